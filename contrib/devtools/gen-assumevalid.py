@@ -0,0 +1,92 @@
+#!/usr/bin/env python3
+# Copyright (c) 2024 The NoteCoin developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+'''
+Generate the assumed-valid chain parameters of chainparams.cpp from a synced node.
+
+Asks a running node for `dumpassumevalid` and prints the matching
+nMinimumChainWork, defaultAssumeValid and chainTxData lines. With --write,
+the values are replaced in place in the chain params class of the node's
+network instead.
+
+    ./contrib/devtools/gen-assumevalid.py [--depth N] [--cli note-cli] [--write src/chainparams.cpp] [-- <note-cli options>]
+
+Everything after `--` is passed to the cli, e.g. `-- -testnet -datadir=/srv/note`.
+'''
+
+import argparse
+import json
+import re
+import subprocess
+import sys
+
+CLASSES = {
+    'main': 'CMainParams',
+    'test': 'CTestNetParams',
+    'regtest': 'CRegTestParams',
+}
+
+def dump(cli, cli_args, depth):
+    cmd = [cli] + cli_args + ['dumpassumevalid']
+    if depth is not None:
+        cmd.append(str(depth))
+    return json.loads(subprocess.check_output(cmd).decode('utf-8'))
+
+def format_params(res, indent='        '):
+    txdata = res['chaintxdata']
+    return [
+        '%sconsensus.nMinimumChainWork = uint256S("0x%s");' % (indent, res['minimumchainwork']),
+        '%sconsensus.defaultAssumeValid = uint256S("0x%s"); // %d' % (indent, res['defaultassumevalid'], res['height']),
+    ], [
+        '%schainTxData = ChainTxData{' % indent,
+        '%s    // Data as of block %s (height %d).' % (indent, res['defaultassumevalid'], res['height']),
+        '%s    %d, // * UNIX timestamp of last known number of transactions' % (indent, txdata['time']),
+        '%s    %d, // * total number of transactions between genesis and that timestamp' % (indent, txdata['txcount']),
+        '%s    %.6f // * estimated number of transactions per second after that timestamp' % (indent, txdata['txrate']),
+        '%s};' % indent,
+    ]
+
+def write_params(path, res):
+    with open(path, 'r', encoding='utf8') as f:
+        source = f.read()
+
+    cls = CLASSES[res['network']]
+    start = source.find('class %s ' % cls)
+    if start < 0:
+        sys.exit('%s not found in %s' % (cls, path))
+    end = source.find('\n};', start)
+
+    consensus, txdata = format_params(res)
+    section = source[start:end]
+    replacements = [
+        (r'^[ \t]*consensus\.nMinimumChainWork = [^;]*;[^\n]*$', consensus[0]),
+        (r'^[ \t]*consensus\.defaultAssumeValid = [^;]*;[^\n]*$', consensus[1]),
+        (r'^[ \t]*chainTxData = ChainTxData\{.*?\};', '\n'.join(txdata)),
+    ]
+    for pattern, text in replacements:
+        section, count = re.subn(pattern, lambda m: text, section, count=1, flags=re.MULTILINE | re.DOTALL)
+        if count != 1:
+            sys.exit('%s: no match for %s in %s' % (path, pattern, cls))
+
+    with open(path, 'w', encoding='utf8') as f:
+        f.write(source[:start] + section + source[end:])
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--cli', default='note-cli', help='cli binary to query the node with (default: note-cli)')
+    parser.add_argument('--depth', type=int, help='blocks between the tip and the assumed-valid block (default: the node\'s)')
+    parser.add_argument('--write', metavar='CHAINPARAMS', help='update this chainparams.cpp in place')
+    parser.add_argument('cli_args', nargs='*', help='options passed to the cli')
+    args = parser.parse_args()
+
+    res = dump(args.cli, args.cli_args, args.depth)
+    if args.write:
+        write_params(args.write, res)
+        print('Updated %s for %s at height %d' % (CLASSES[res['network']], res['network'], res['height']))
+    else:
+        consensus, txdata = format_params(res)
+        print('\n'.join(consensus + [''] + txdata))
+
+if __name__ == '__main__':
+    main()
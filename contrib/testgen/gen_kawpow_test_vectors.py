@@ -0,0 +1,258 @@
+#!/usr/bin/env python3
+# Copyright (c) 2024 The NoteCoin developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+'''
+Generate KawPoW regression vectors for src/test/kawpow_tests.cpp.
+
+This is a slow, straightforward implementation of ethash's light cache and
+dataset items plus ProgPoW 0.9.4 with Ravencoin's KawPoW padding, written
+from the specifications and sharing no code with src/crypto/progpow.
+
+Usage:
+    gen_kawpow_test_vectors.py height:header_hash:nonce [...]
+
+Each argument prints one {height, header hash, nonce, mix hash, final hash}
+row in the layout of cpp-kawpow's kawpow_hash_test_cases, all hex strings
+in the byte order KawPoW miners exchange them. Needs
+pycryptodome for the original (pre-SHA3) Keccak-256/512.
+'''
+import sys
+
+from Crypto.Hash import keccak
+
+EPOCH_LENGTH = 7500
+PERIOD_LENGTH = 3
+NUM_REGS = 32
+NUM_LANES = 16
+NUM_CACHE_ACCESSES = 11
+NUM_MATH_OPERATIONS = 18
+NUM_ROUNDS = 64
+NUM_WORDS_PER_LANE = 4
+L1_CACHE_WORDS = 4096
+FNV_PRIME = 0x01000193
+FNV_OFFSET_BASIS = 0x811c9dc5
+# "rAVENCOINKAWPOW"
+KAWPOW_PADDING = [0x72, 0x41, 0x56, 0x45, 0x4e, 0x43, 0x4f, 0x49, 0x4e, 0x4b, 0x41, 0x57, 0x50, 0x4f, 0x57]
+M32 = 0xffffffff
+
+KECCAK_RC = [
+    0x0000000000000001, 0x0000000000008082, 0x800000000000808A, 0x8000000080008000,
+    0x000000000000808B, 0x0000000080000001, 0x8000000080008081, 0x8000000000008009,
+    0x000000000000008A, 0x0000000000000088, 0x0000000080008009, 0x000000008000000A,
+    0x000000008000808B, 0x800000000000008B, 0x8000000000008089, 0x8000000000008003,
+    0x8000000000008002, 0x8000000000000080, 0x000000000000800A, 0x800000008000000A,
+    0x8000000080008081, 0x8000000000008080,
+]
+
+def keccak256(data):
+    return keccak.new(digest_bits=256, data=data).digest()
+
+def keccak512(data):
+    return keccak.new(digest_bits=512, data=data).digest()
+
+def rotl32(x, n):
+    n %= 32
+    return ((x << n) | (x >> (32 - n))) & M32 if n else x
+
+def rotr32(x, n):
+    return rotl32(x, 32 - n % 32)
+
+def keccak_f800(a):
+    '''Keccak-f[800] on 25 words, lane (x, y) at index x + 5 * y.'''
+    offsets = {(0, 0): 0}
+    x, y = 1, 0
+    for t in range(24):
+        offsets[(x, y)] = (t + 1) * (t + 2) // 2
+        x, y = y, (2 * x + 3 * y) % 5
+    for rc in KECCAK_RC:
+        c = [a[x] ^ a[x + 5] ^ a[x + 10] ^ a[x + 15] ^ a[x + 20] for x in range(5)]
+        d = [c[(x - 1) % 5] ^ rotl32(c[(x + 1) % 5], 1) for x in range(5)]
+        a = [a[i] ^ d[i % 5] for i in range(25)]
+        b = [0] * 25
+        for x in range(5):
+            for y in range(5):
+                b[y + 5 * ((2 * x + 3 * y) % 5)] = rotl32(a[x + 5 * y], offsets[(x, y)])
+        a = [b[x + 5 * y] ^ (~b[(x + 1) % 5 + 5 * y] & M32 & b[(x + 2) % 5 + 5 * y]) for y in range(5) for x in range(5)]
+        a[0] ^= rc & M32
+    return a
+
+def is_prime(n):
+    i = 2
+    while i * i <= n:
+        if n % i == 0:
+            return False
+        i += 1
+    return n >= 2
+
+def light_cache_num_items(epoch):
+    size = 2**24 + 2**17 * epoch - 64
+    while not is_prime(size // 64):
+        size -= 128
+    return size // 64
+
+def full_dataset_num_items(epoch):
+    size = 2**30 + 2**23 * epoch - 128
+    while not is_prime(size // 128):
+        size -= 256
+    return size // 128
+
+def to_words(data):
+    return [int.from_bytes(data[i:i + 4], 'little') for i in range(0, len(data), 4)]
+
+def to_bytes(words):
+    return b''.join(w.to_bytes(4, 'little') for w in words)
+
+def fnv1(u, v):
+    return ((u * FNV_PRIME) & M32) ^ v
+
+def fnv1a(u, v):
+    return ((u ^ v) * FNV_PRIME) & M32
+
+def build_light_cache(epoch):
+    seed = b'\0' * 32
+    for _ in range(epoch):
+        seed = keccak256(seed)
+    n = light_cache_num_items(epoch)
+    cache = [keccak512(seed)]
+    for _ in range(1, n):
+        cache.append(keccak512(cache[-1]))
+    for _ in range(3):
+        for i in range(n):
+            v = int.from_bytes(cache[i][:4], 'little') % n
+            cache[i] = keccak512(bytes(p ^ q for p, q in zip(cache[(i - 1 + n) % n], cache[v])))
+    return [to_words(item) for item in cache]
+
+def dataset_item_512(cache, index):
+    n = len(cache)
+    mix = list(cache[index % n])
+    mix[0] ^= index
+    mix = to_words(keccak512(to_bytes(mix)))
+    for j in range(256):
+        parent = cache[fnv1(index ^ j, mix[j % 16]) % n]
+        mix = [fnv1(mix[k], parent[k]) for k in range(16)]
+    return to_words(keccak512(to_bytes(mix)))
+
+def dataset_item_2048(cache, index):
+    return sum((dataset_item_512(cache, 4 * index + k) for k in range(4)), [])
+
+class Kiss99:
+    def __init__(self, z, w, jsr, jcong):
+        self.z, self.w, self.jsr, self.jcong = z, w, jsr, jcong
+
+    def __call__(self):
+        self.z = (36969 * (self.z & 0xffff) + (self.z >> 16)) & M32
+        self.w = (18000 * (self.w & 0xffff) + (self.w >> 16)) & M32
+        self.jcong = (69069 * self.jcong + 1234567) & M32
+        self.jsr ^= (self.jsr << 17) & M32
+        self.jsr ^= self.jsr >> 13
+        self.jsr ^= (self.jsr << 5) & M32
+        return (((((self.z << 16) + self.w) & M32) ^ self.jcong) + self.jsr) & M32
+
+def clz32(x):
+    return 32 - x.bit_length()
+
+def random_math(a, b, selector):
+    return [
+        lambda: (a + b) & M32,
+        lambda: (a * b) & M32,
+        lambda: (a * b) >> 32,
+        lambda: min(a, b),
+        lambda: rotl32(a, b),
+        lambda: rotr32(a, b),
+        lambda: a & b,
+        lambda: a | b,
+        lambda: a ^ b,
+        lambda: clz32(a) + clz32(b),
+        lambda: bin(a).count('1') + bin(b).count('1'),
+    ][selector % 11]()
+
+def random_merge(a, b, selector):
+    x = (selector >> 16) % 31 + 1
+    return [
+        lambda: (a * 33 + b) & M32,
+        lambda: ((a ^ b) * 33) & M32,
+        lambda: rotl32(a, x) ^ b,
+        lambda: rotr32(a, x) ^ b,
+    ][selector % 4]()
+
+def program(period):
+    '''The KISS99 state after the register shuffles, and the shuffled sequences.'''
+    lo, hi = period & M32, period >> 32
+    z = fnv1a(FNV_OFFSET_BASIS, lo)
+    w = fnv1a(z, hi)
+    jsr = fnv1a(w, lo)
+    jcong = fnv1a(jsr, hi)
+    rng = Kiss99(z, w, jsr, jcong)
+    dst, src = list(range(NUM_REGS)), list(range(NUM_REGS))
+    for i in range(NUM_REGS - 1, 0, -1):
+        j = rng() % (i + 1)
+        dst[i], dst[j] = dst[j], dst[i]
+        j = rng() % (i + 1)
+        src[i], src[j] = src[j], src[i]
+    return (rng.z, rng.w, rng.jsr, rng.jcong), dst, src
+
+def kawpow(epoch, cache, height, header_hash, nonce):
+    state = keccak_f800(to_words(bytes.fromhex(header_hash)) + [nonce & M32, nonce >> 32] + KAWPOW_PADDING)
+    seed = state[:8]
+
+    z = fnv1a(FNV_OFFSET_BASIS, seed[0])
+    w = fnv1a(z, seed[1])
+    mix = []
+    for lane in range(NUM_LANES):
+        jsr = fnv1a(w, lane)
+        rng = Kiss99(z, w, jsr, fnv1a(jsr, lane))
+        mix.append([rng() for _ in range(NUM_REGS)])
+
+    rng_state, dst_seq, src_seq = program(height // PERIOD_LENGTH)
+    l1 = sum((dataset_item_2048(cache, i) for i in range(L1_CACHE_WORDS // 64)), [])
+    num_items = full_dataset_num_items(epoch) // 2
+    for r in range(NUM_ROUNDS):
+        rng = Kiss99(*rng_state)
+        dst_iter = iter(dst_seq * 4)
+        src_iter = iter(src_seq * 4)
+        item = dataset_item_2048(cache, mix[r % NUM_LANES][0] % num_items)
+        for i in range(max(NUM_CACHE_ACCESSES, NUM_MATH_OPERATIONS)):
+            if i < NUM_CACHE_ACCESSES:
+                src, dst, sel = next(src_iter), next(dst_iter), rng()
+                for lane in mix:
+                    lane[dst] = random_merge(lane[dst], l1[lane[src] % L1_CACHE_WORDS], sel)
+            if i < NUM_MATH_OPERATIONS:
+                src_rnd = rng() % (NUM_REGS * (NUM_REGS - 1))
+                src1, src2 = src_rnd % NUM_REGS, src_rnd // NUM_REGS
+                if src2 >= src1:
+                    src2 += 1
+                sel1 = rng()
+                dst = next(dst_iter)
+                sel2 = rng()
+                for lane in mix:
+                    lane[dst] = random_merge(lane[dst], random_math(lane[src1], lane[src2], sel1), sel2)
+        dsts, sels = [], []
+        for i in range(NUM_WORDS_PER_LANE):
+            dsts.append(0 if i == 0 else next(dst_iter))
+            sels.append(rng())
+        for l, lane in enumerate(mix):
+            offset = ((l ^ r) % NUM_LANES) * NUM_WORDS_PER_LANE
+            for i in range(NUM_WORDS_PER_LANE):
+                lane[dsts[i]] = random_merge(lane[dsts[i]], item[offset + i], sels[i])
+
+    mix_hash = [FNV_OFFSET_BASIS] * 8
+    for l, lane in enumerate(mix):
+        lane_hash = FNV_OFFSET_BASIS
+        for word in lane:
+            lane_hash = fnv1a(lane_hash, word)
+        mix_hash[l % 8] = fnv1a(mix_hash[l % 8], lane_hash)
+
+    final = keccak_f800(seed + mix_hash + KAWPOW_PADDING[:9])
+    return to_bytes(final[:8]).hex(), to_bytes(mix_hash).hex()
+
+if __name__ == '__main__':
+    caches = {}
+    for arg in sys.argv[1:]:
+        height, header_hash, nonce = arg.split(':')
+        height = int(height)
+        epoch = height // EPOCH_LENGTH
+        if epoch not in caches:
+            caches[epoch] = build_light_cache(epoch)
+        final_hash, mix_hash = kawpow(epoch, caches[epoch], height, header_hash, int(nonce, 16))
+        print('{%d, "%s", "%s",\n    "%s",\n    "%s"},' % (height, header_hash, nonce, mix_hash, final_hash))
@@ -0,0 +1,91 @@
+// Copyright (c) 2015-2017 The Bitcoin Core developers
+// Copyright (c) 2024 The NoteCoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <chainparams.h>
+#include <crypto/ripemd160.h>
+#include <crypto/scrypt.h>
+#include <crypto/sha256.h>
+#include <crypto/siphash.h>
+#include <random.h>
+#include <util.h>
+#include <utilstrencodings.h>
+
+#include <atomic>
+#include <iostream>
+#include <new>
+
+#include <stdlib.h>
+
+static std::atomic<uint64_t> g_allocation_count{0};
+
+// Count every heap allocation so benchmarks can report allocs/op.
+void* operator new(size_t size)
+{
+    g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+
+uint64_t benchmark::AllocationCount()
+{
+    return g_allocation_count.load(std::memory_order_relaxed);
+}
+
+static const int64_t DEFAULT_BENCH_EVALUATIONS = 5;
+static const char* DEFAULT_BENCH_FILTER = ".*";
+static const char* DEFAULT_BENCH_SCALING = "1.0";
+
+int
+main(int argc, char** argv)
+{
+    gArgs.ParseParameters(argc, argv);
+
+    if (gArgs.IsArgSet("-?") || gArgs.IsArgSet("-help")) {
+        std::cout << HelpMessageGroup(_("Options:"))
+                  << HelpMessageOpt("-?", _("Print this help message and exit"))
+                  << HelpMessageOpt("-list", _("List benchmarks without executing them. Can be combined with -scaling and -filter"))
+                  << HelpMessageOpt("-evals=<n>", strprintf(_("Number of measurement evaluations to perform. (default: %u)"), DEFAULT_BENCH_EVALUATIONS))
+                  << HelpMessageOpt("-filter=<regex>", strprintf(_("Regular expression filter to select benchmark by name (default: %s)"), DEFAULT_BENCH_FILTER))
+                  << HelpMessageOpt("-scaling=<n>", strprintf(_("Scaling factor for benchmark's runtime (default: %s)"), DEFAULT_BENCH_SCALING));
+        return 0;
+    }
+
+    SHA256AutoDetect();
+    RIPEMD160AutoDetect();
+    SipHashAutoDetect();
+    scrypt_detect();
+    RandomInit();
+    SetupEnvironment();
+    fPrintToDebugLog = false; // don't want to write to debug.log file
+    SelectParams(CBaseChainParams::MAIN);
+
+    int64_t evaluations = gArgs.GetArg("-evals", DEFAULT_BENCH_EVALUATIONS);
+    std::string regex_filter = gArgs.GetArg("-filter", DEFAULT_BENCH_FILTER);
+    std::string scaling_str = gArgs.GetArg("-scaling", DEFAULT_BENCH_SCALING);
+    bool is_list_only = gArgs.GetBoolArg("-list", false);
+
+    double scaling_factor;
+    if (!ParseDouble(scaling_str, &scaling_factor)) {
+        fprintf(stderr, "Error parsing scaling factor as double: %s\n", scaling_str.c_str());
+        return EXIT_FAILURE;
+    }
+
+    benchmark::ConsolePrinter printer;
+    benchmark::BenchRunner::RunAll(printer, evaluations, scaling_factor, regex_filter, is_list_only);
+
+    return EXIT_SUCCESS;
+}
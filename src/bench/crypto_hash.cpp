@@ -0,0 +1,114 @@
+// Copyright (c) 2016-2017 The Bitcoin Core developers
+// Copyright (c) 2024 The NoteCoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <crypto/sha256.h>
+#include <crypto/siphash.h>
+#include <hash.h>
+#include <uint256.h>
+
+#include <vector>
+
+/* Number of bytes to hash per iteration */
+static const uint64_t BUFFER_SIZE = 1000*1000;
+
+static void SHA256(benchmark::State& state)
+{
+    uint8_t hash[CSHA256::OUTPUT_SIZE];
+    std::vector<uint8_t> in(BUFFER_SIZE,0);
+    while (state.KeepRunning())
+        CSHA256().Write(in.data(), in.size()).Finalize(hash);
+}
+
+static void SHA256_32b(benchmark::State& state)
+{
+    std::vector<uint8_t> in(32,0);
+    while (state.KeepRunning()) {
+        CSHA256()
+            .Write(in.data(), in.size())
+            .Finalize(in.data());
+    }
+}
+
+static void SHA256D64_1024(benchmark::State& state)
+{
+    std::vector<uint8_t> in(64 * 1024, 0);
+    while (state.KeepRunning()) {
+        SHA256D64(in.data(), in.data(), 1024);
+    }
+}
+
+static void Hash256_64b_1024(benchmark::State& state)
+{
+    std::vector<uint8_t> in(64 * 1024, 0);
+    while (state.KeepRunning()) {
+        for (int i = 0; i < 1024; i++) {
+            CHash256().Write(in.data() + 64 * i, 64).Finalize(in.data() + 32 * i);
+        }
+    }
+}
+
+static void Hash160_33b_1024(benchmark::State& state)
+{
+    std::vector<uint8_t> in(33 * 1024, 0);
+    std::vector<uint8_t> out(20 * 1024);
+    while (state.KeepRunning()) {
+        for (int i = 0; i < 1024; i++) {
+            CHash160().Write(in.data() + 33 * i, 33).Finalize(out.data() + 20 * i);
+        }
+    }
+}
+
+static void Hash160Batch_33b_1024(benchmark::State& state)
+{
+    std::vector<uint8_t> in(33 * 1024, 0);
+    std::vector<uint8_t> out(20 * 1024);
+    std::vector<const unsigned char*> inputs;
+    std::vector<size_t> lengths(1024, 33);
+    for (int i = 0; i < 1024; i++) {
+        inputs.push_back(in.data() + 33 * i);
+    }
+    while (state.KeepRunning()) {
+        Hash160Batch(out.data(), inputs.data(), lengths.data(), 1024);
+    }
+}
+
+static void SipHash_32b_1024(benchmark::State& state)
+{
+    std::vector<uint256> in(1024);
+    std::vector<uint64_t> out(1024);
+    for (int i = 0; i < 1024; i++) {
+        *in[i].begin() = i;
+    }
+    while (state.KeepRunning()) {
+        for (int i = 0; i < 1024; i++) {
+            out[i] = SipHashUint256(0, 1, in[i]);
+        }
+    }
+}
+
+static void SipHash32Many_32b_1024(benchmark::State& state)
+{
+    std::vector<uint256> in(1024);
+    std::vector<uint64_t> out(1024);
+    std::vector<const unsigned char*> inputs;
+    for (int i = 0; i < 1024; i++) {
+        *in[i].begin() = i;
+        inputs.push_back(in[i].begin());
+    }
+    while (state.KeepRunning()) {
+        SipHash32Many(0, 1, inputs.data(), nullptr, out.data(), 1024);
+    }
+}
+
+BENCHMARK(SHA256, 340);
+BENCHMARK(SHA256_32b, 4700 * 1000);
+BENCHMARK(SHA256D64_1024, 7400);
+BENCHMARK(Hash256_64b_1024, 2000);
+BENCHMARK(Hash160_33b_1024, 2000);
+BENCHMARK(Hash160Batch_33b_1024, 2000);
+BENCHMARK(SipHash_32b_1024, 20 * 1000);
+BENCHMARK(SipHash32Many_32b_1024, 20 * 1000);
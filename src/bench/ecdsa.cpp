@@ -0,0 +1,68 @@
+// Copyright (c) 2024 The NoteCoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <key.h>
+#include <pubkey.h>
+#include <random.h>
+#include <uint256.h>
+
+#include <assert.h>
+#include <vector>
+
+/** Signatures verified per iteration: one full batch of the secp256k1 batch module */
+static const size_t ECDSA_SIGNATURES = 64;
+
+struct SignatureSet
+{
+    std::vector<CPubKey> pubkeys;
+    std::vector<uint256> hashes;
+    std::vector<std::vector<unsigned char>> sigs;
+};
+
+static SignatureSet MakeSignatures()
+{
+    SignatureSet set;
+    FastRandomContext rng(true);
+    for (size_t i = 0; i < ECDSA_SIGNATURES; i++) {
+        CKey key;
+        key.MakeNewKey(true);
+        const uint256 hash = rng.rand256();
+        std::vector<unsigned char> sig;
+        bool ret = key.Sign(hash, sig);
+        assert(ret);
+        set.pubkeys.push_back(key.GetPubKey());
+        set.hashes.push_back(hash);
+        set.sigs.push_back(sig);
+    }
+    return set;
+}
+
+static void ECDSAVerify_64(benchmark::State& state)
+{
+    ECCVerifyHandle verify_handle;
+    ECC_Start();
+    const SignatureSet set = MakeSignatures();
+    while (state.KeepRunning()) {
+        for (size_t i = 0; i < ECDSA_SIGNATURES; i++) {
+            set.pubkeys[i].Verify(set.hashes[i], set.sigs[i]);
+        }
+    }
+    ECC_Stop();
+}
+
+static void ECDSAVerifyBatch_64(benchmark::State& state)
+{
+    ECCVerifyHandle verify_handle;
+    ECC_Start();
+    const SignatureSet set = MakeSignatures();
+    while (state.KeepRunning()) {
+        CPubKey::VerifyBatch(set.pubkeys, set.hashes, set.sigs);
+    }
+    ECC_Stop();
+}
+
+BENCHMARK(ECDSAVerify_64, 250);
+BENCHMARK(ECDSAVerifyBatch_64, 250);
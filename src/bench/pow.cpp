@@ -0,0 +1,179 @@
+// Copyright (c) 2024 The NoteCoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <arith_uint256.h>
+#include <chain.h>
+#include <chainparams.h>
+#include <crypto/scrypt.h>
+#include <kawpow/kawpow.h>
+#include <pow.h>
+#include <primitives/block.h>
+#include <random.h>
+#include <uint256.h>
+
+#include <limits>
+#include <vector>
+
+#include <string.h>
+
+static const int SYNTHETIC_CHAIN_LENGTH = 1000000;
+
+/** Main network consensus rules with the DigiShield V4 parameters filled in */
+static const Consensus::Params& BenchParams()
+{
+    static Consensus::Params params;
+    static bool initialized = false;
+    if (!initialized) {
+        params = Params().GetConsensus();
+        params.nAveragingInterval = 10;
+        params.multiAlgoTargetSpacingV4 = params.nPowTargetSpacing;
+        params.nAveragingTargetTimespanV4 = params.nAveragingInterval * params.multiAlgoTargetSpacingV4;
+        params.nMaxAdjustDownV4 = 16;
+        params.nMaxAdjustUpV4 = 8;
+        params.nMinActualTimespanV4 = params.nAveragingTargetTimespanV4 * (100 - params.nMaxAdjustUpV4) / 100;
+        params.nMaxActualTimespanV4 = params.nAveragingTargetTimespanV4 * (100 + params.nMaxAdjustDownV4) / 100;
+        params.nLocalTargetAdjustment = 4;
+        params.nDigiShieldHFHeight = 0;
+        initialized = true;
+    }
+    return params;
+}
+
+/**
+ * A chain of SYNTHETIC_CHAIN_LENGTH headers linked the way the block index
+ * links them, with skip pointers and cached median time past. It is built
+ * once, outside the timed loops.
+ */
+static const std::vector<CBlockIndex>& SyntheticChain()
+{
+    static std::vector<CBlockIndex> blocks;
+    if (blocks.empty()) {
+        const Consensus::Params& params = BenchParams();
+        FastRandomContext rng(true);
+        blocks.resize(SYNTHETIC_CHAIN_LENGTH);
+        for (int i = 0; i < SYNTHETIC_CHAIN_LENGTH; i++) {
+            blocks[i].pprev = i ? &blocks[i - 1] : nullptr;
+            blocks[i].nHeight = i;
+            blocks[i].nTime = 1269211443 + i * params.nPowTargetSpacing + rng.randrange(2 * params.nPowTargetSpacing);
+            blocks[i].nBits = 0x1c0ffff0 + rng.randrange(16);
+            blocks[i].BuildSkip();
+            blocks[i].BuildMedianTimePast();
+        }
+    }
+    return blocks;
+}
+
+/** Heights spread over the whole chain, so the ancestor lookups do not stay in cache */
+static const CBlockIndex* NextTip(const std::vector<CBlockIndex>& blocks, uint64_t& n)
+{
+    n = (n + 7919) % blocks.size();
+    return &blocks[n];
+}
+
+static void DigiShieldV4_1M(benchmark::State& state)
+{
+    const Consensus::Params& params = BenchParams();
+    const std::vector<CBlockIndex>& blocks = SyntheticChain();
+    uint64_t n = 0;
+    while (state.KeepRunning()) {
+        DigiShieldV4(NextTip(blocks, n), params);
+    }
+}
+
+static void GetNextWorkRequired_1M(benchmark::State& state)
+{
+    const Consensus::Params& params = BenchParams();
+    const std::vector<CBlockIndex>& blocks = SyntheticChain();
+    CBlockHeader header;
+    uint64_t n = 0;
+    while (state.KeepRunning()) {
+        const CBlockIndex* pindexLast = NextTip(blocks, n);
+        header.nTime = pindexLast->nTime + params.nPowTargetSpacing;
+        GetNextWorkRequired(pindexLast, &header, params);
+    }
+}
+
+static void GetNextWorkRequiredLegacy_1M(benchmark::State& state)
+{
+    Consensus::Params params = BenchParams();
+    params.nDigiShieldHFHeight = std::numeric_limits<int>::max();
+    const std::vector<CBlockIndex>& blocks = SyntheticChain();
+    CBlockHeader header;
+    // Land on retarget heights only; everything else returns the previous nBits
+    const uint64_t interval = params.DifficultyAdjustmentInterval();
+    uint64_t n = 0;
+    while (state.KeepRunning()) {
+        n = (n + 7919 * interval) % (blocks.size() - blocks.size() % interval);
+        const CBlockIndex* pindexLast = &blocks[n + interval - 1];
+        header.nTime = pindexLast->nTime + params.nPowTargetSpacing;
+        GetNextWorkRequired(pindexLast, &header, params);
+    }
+}
+
+static CBlockHeader BenchHeader()
+{
+    CBlockHeader header;
+    header.nVersion = 0x20000000;
+    header.hashPrevBlock = uint256S("0x00000000000000000000000000000000000000000000000000000000000000ff");
+    header.hashMerkleRoot = uint256S("0x4a5e1e4baab89f3a32518a88c31bc87f618f76673e2cc77ab2127b7afdeda33b");
+    header.nTime = 1269211443;
+    header.nBits = 0x1c0ffff0;
+    header.nHeight = 100;
+    return header;
+}
+
+static void KawPoWHash(benchmark::State& state)
+{
+    CBlockHeader header = BenchHeader();
+    uint256 mix_hash;
+    // Build the epoch context before timing; that is a one-off cost per epoch
+    kawpow::HashPoW(header, mix_hash);
+    while (state.KeepRunning()) {
+        header.nNonce++;
+        kawpow::HashPoW(header, mix_hash);
+    }
+}
+
+static void KawPoWHashLight(benchmark::State& state)
+{
+    CBlockHeader header = BenchHeader();
+    header.nMixHash = uint256S("0x11f19805c58ab46610ff9c719dcf0a5f18fa2f1605798eef770c47219274767d");
+    while (state.KeepRunning()) {
+        header.nNonce++;
+        kawpow::HashPoWLight(header);
+    }
+}
+
+static void Scrypt_1024_1_1_256(benchmark::State& state)
+{
+    char input[80] = {0};
+    char output[32];
+    uint32_t nonce = 0;
+    while (state.KeepRunning()) {
+        nonce++;
+        memcpy(input + 76, &nonce, sizeof(nonce));
+        scrypt_1024_1_1_256(input, output);
+    }
+}
+
+static void CheckProofOfWork_Compact(benchmark::State& state)
+{
+    const Consensus::Params& params = BenchParams();
+    const unsigned int nBits = UintToArith256(params.powLimit).GetCompact();
+    uint256 hash = uint256S("0x00000fffffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
+    while (state.KeepRunning()) {
+        *hash.begin() += 1;
+        CheckProofOfWork(hash, nBits, params);
+    }
+}
+
+BENCHMARK(DigiShieldV4_1M, 1000 * 1000);
+BENCHMARK(GetNextWorkRequired_1M, 1000 * 1000);
+BENCHMARK(GetNextWorkRequiredLegacy_1M, 20 * 1000);
+BENCHMARK(KawPoWHash, 250);
+BENCHMARK(KawPoWHashLight, 1000 * 1000);
+BENCHMARK(Scrypt_1024_1_1_256, 10 * 1000);
+BENCHMARK(CheckProofOfWork_Compact, 10 * 1000 * 1000);
@@ -0,0 +1,56 @@
+// Copyright (c) 2024 The NoteCoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <primitives/transaction.h>
+#include <random.h>
+#include <script/interpreter.h>
+#include <script/script.h>
+#include <uint256.h>
+
+#include <vector>
+
+/** A ~100kB legacy transaction consolidating 680 P2PKH outputs into one. */
+static CTransaction LargeLegacyTransaction()
+{
+    FastRandomContext rng(true);
+    CMutableTransaction tx;
+    tx.vin.resize(680);
+    for (auto& txin : tx.vin) {
+        txin.prevout = COutPoint(rng.rand256(), rng.randrange(4));
+        txin.scriptSig = CScript() << std::vector<unsigned char>(72, 0x30) << std::vector<unsigned char>(33, 0x02);
+    }
+    tx.vout.resize(1);
+    tx.vout[0].nValue = 680 * COIN;
+    tx.vout[0].scriptPubKey = CScript() << OP_DUP << OP_HASH160 << std::vector<unsigned char>(20, 0) << OP_EQUALVERIFY << OP_CHECKSIG;
+    return CTransaction(tx);
+}
+
+static const CScript SCRIPT_CODE = CScript() << OP_DUP << OP_HASH160 << std::vector<unsigned char>(20, 1) << OP_EQUALVERIFY << OP_CHECKSIG;
+
+// One SIGHASH_ALL signature hash per input, as verifying the transaction does
+static void SignatureHashLegacy(benchmark::State& state)
+{
+    const CTransaction tx = LargeLegacyTransaction();
+    while (state.KeepRunning()) {
+        for (unsigned int i = 0; i < tx.vin.size(); i++) {
+            SignatureHash(SCRIPT_CODE, tx, i, SIGHASH_ALL, 0, SIGVERSION_BASE);
+        }
+    }
+}
+
+static void SignatureHashLegacyPrecomputed(benchmark::State& state)
+{
+    const CTransaction tx = LargeLegacyTransaction();
+    while (state.KeepRunning()) {
+        const PrecomputedTransactionData txdata(tx);
+        for (unsigned int i = 0; i < tx.vin.size(); i++) {
+            SignatureHash(SCRIPT_CODE, tx, i, SIGHASH_ALL, 0, SIGVERSION_BASE, &txdata);
+        }
+    }
+}
+
+BENCHMARK(SignatureHashLegacy, 2);
+BENCHMARK(SignatureHashLegacyPrecomputed, 20);
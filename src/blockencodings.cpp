@@ -5,6 +5,7 @@
 #include <consensus/consensus.h>
 #include <consensus/validation.h>
 #include <chainparams.h>
+#include <crypto/siphash.h>
 #include <hash.h>
 #include <random.h>
 #include <streams.h>
@@ -12,6 +13,7 @@
 #include <validation.h>
 #include <util/system.h>
 
+#include <algorithm>
 #include <unordered_map>
 #include <limits>
 
@@ -50,6 +52,12 @@ uint64_t CBlockHeaderAndShortTxIDs::GetShortID(const uint256& txhash) const
     return SipHashUint256(shorttxidk0, shorttxidk1, txhash) & 0xffffffffffffULL;
 }
 
+void CBlockHeaderAndShortTxIDs::GetShortIDs(const unsigned char* const* txhashes, uint64_t* out, size_t n) const
+{
+    SipHash32Many(shorttxidk0, shorttxidk1, txhashes, nullptr, out, n);
+    for (size_t i = 0; i < n; ++i) out[i] &= 0xffffffffffffULL;
+}
+
 ReadStatus PartiallyDownloadedBlock::InitData(const CBlockHeaderAndShortTxIDs& cmpctblock,
                                               const std::vector<std::pair<uint256, CTransactionRef>>& extra_txn)
 {
@@ -97,23 +105,34 @@ ReadStatus PartiallyDownloadedBlock::InitData(const CBlockHeaderAndShortTxIDs& c
 
     {
         LOCK(pool->cs);
-        for (const auto& txinfo : pool->vTxHashes) {
-            uint64_t shortid = cmpctblock.GetShortID(txinfo.first);
-            auto it = shorttxids.find(shortid);
-            if (it != shorttxids.end()) {
-                auto& pos = it->second;
-                if (!have_txn[pos]) {
-                    txn_available[pos] = txinfo.second->GetSharedTx();
-                    have_txn[pos] = true;
-                    mempool_count++;
-                } else {
-                    if (txn_available[pos]) {
-                        txn_available[pos].reset();
-                        mempool_count--;
+        // Compute the mempool's short IDs a chunk at a time, several per SipHash call
+        static const size_t SHORTID_CHUNK = 64;
+        const unsigned char* txhashes[SHORTID_CHUNK];
+        uint64_t shortids[SHORTID_CHUNK];
+        for (size_t start = 0; start < pool->vTxHashes.size() && mempool_count != shorttxids.size(); start += SHORTID_CHUNK) {
+            const size_t count = std::min(SHORTID_CHUNK, pool->vTxHashes.size() - start);
+            for (size_t i = 0; i < count; ++i) {
+                txhashes[i] = pool->vTxHashes[start + i].first.begin();
+            }
+            cmpctblock.GetShortIDs(txhashes, shortids, count);
+            for (size_t i = 0; i < count; ++i) {
+                const auto& txinfo = pool->vTxHashes[start + i];
+                auto it = shorttxids.find(shortids[i]);
+                if (it != shorttxids.end()) {
+                    auto& pos = it->second;
+                    if (!have_txn[pos]) {
+                        txn_available[pos] = txinfo.second->GetSharedTx();
+                        have_txn[pos] = true;
+                        mempool_count++;
+                    } else {
+                        if (txn_available[pos]) {
+                            txn_available[pos].reset();
+                            mempool_count--;
+                        }
                     }
                 }
+                if (mempool_count == shorttxids.size()) break;
             }
-            if (mempool_count == shorttxids.size()) break;
         }
     }
 
@@ -150,6 +150,8 @@ public:
     CBlockHeaderAndShortTxIDs(const CBlock& block, bool fUseWTXID);
 
     uint64_t GetShortID(const uint256& txhash) const;
+    /** GetShortID of n 32-byte hashes at once, using the multi-lane SipHash when available */
+    void GetShortIDs(const unsigned char* const* txhashes, uint64_t* out, size_t n) const;
 
     size_t BlockTxCount() const {
         return shorttxids.size() + prefilledtxn.size();
@@ -116,6 +116,27 @@ void CBlockIndex::BuildSkip() {
     }
 }
 
+/** Median block time of pindex and its nMedianTimeSpan - 1 predecessors */
+static int64_t CalculateMedianTimePast(const CBlockIndex* pindex) {
+    int64_t pmedian[CBlockIndex::nMedianTimeSpan];
+    int64_t* pbegin = &pmedian[CBlockIndex::nMedianTimeSpan];
+    int64_t* pend = &pmedian[CBlockIndex::nMedianTimeSpan];
+
+    for (int i = 0; i < CBlockIndex::nMedianTimeSpan && pindex; i++, pindex = pindex->pprev)
+        *(--pbegin) = pindex->GetBlockTime();
+
+    std::sort(pbegin, pend);
+    return pbegin[(pend - pbegin) / 2];
+}
+
+int64_t CBlockIndex::GetMedianTimePast() const {
+    return nMedianTimePast ? nMedianTimePast : CalculateMedianTimePast(this);
+}
+
+void CBlockIndex::BuildMedianTimePast() {
+    nMedianTimePast = CalculateMedianTimePast(this);
+}
+
 /** Calculate proof of a block (work representation) */
 arith_uint256 GetBlockProof(const CBlockIndex& block) {
     arith_uint256 bnTarget;
@@ -96,7 +96,10 @@ enum BlockStatus : uint32_t {
     BLOCK_FAILED_CHILD = 64,
     BLOCK_FAILED_MASK = BLOCK_FAILED_VALID | BLOCK_FAILED_CHILD,
 
-    BLOCK_OPT_WITNESS = 128
+    BLOCK_OPT_WITNESS = 128,
+
+    //! The KawPoW mix digest was recomputed from the DAG and hashPoW holds the final hash
+    BLOCK_POW_VERIFIED = 256
 };
 
 // Index eines Blocks in der Blockchain
@@ -119,10 +122,16 @@ public:
     uint256 hashMerkleRoot;
     uint32_t nTime{0};
     uint32_t nBits{0};
-    uint32_t nNonce{0};
+    uint64_t nNonce{0};
+    uint256 nMixHash;
+
+    //! Final KawPoW hash, only meaningful with BLOCK_POW_VERIFIED
+    uint256 hashPoW;
 
     int32_t nSequenceId{0};
     unsigned int nTimeMax{0};
+    //! (memory only) GetMedianTimePast() as of BuildMedianTimePast(), 0 if not cached
+    int64_t nMedianTimePast{0};
 
     explicit CBlockIndex(const CBlockHeader& block);
     CBlockIndex() = default;
@@ -140,6 +149,8 @@ public:
 
     static constexpr int nMedianTimeSpan = 11;
     int64_t GetMedianTimePast() const;
+    /** Cache the median time past; pprev and the block times up to here must be final. */
+    void BuildMedianTimePast();
 
     std::string ToString() const;
 
@@ -183,6 +194,9 @@ public:
         READWRITE(nTime);
         READWRITE(nBits);
         READWRITE(nNonce);
+        READWRITE(nMixHash);
+        if (nStatus & BLOCK_POW_VERIFIED)
+            READWRITE(hashPoW);
     }
 
     uint256 GetBlockHash() const;
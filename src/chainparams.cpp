@@ -101,6 +101,9 @@ public:
             0,
             0.0
         };
+
+        // No UTXO snapshots have been reviewed for this chain yet
+        mapAssumeutxo = {};
     }
 };
 
@@ -167,6 +170,9 @@ public:
             0,
             0.0
         };
+
+        // No UTXO snapshots have been reviewed for this chain yet
+        mapAssumeutxo = {};
     }
 };
 
@@ -192,3 +198,13 @@ void SelectParams(const std::string& network)
 {
     globalChainParams = CreateChainParams(network);
 }
+
+void CChainParams::UpdateAssumeutxo(const uint256& base_blockhash, const AssumeutxoData& data)
+{
+    mapAssumeutxo[base_blockhash] = data;
+}
+
+void UpdateAssumeutxo(const uint256& base_blockhash, const AssumeutxoData& data)
+{
+    globalChainParams->UpdateAssumeutxo(base_blockhash, data);
+}
@@ -32,6 +32,18 @@ struct ChainTxData {
     double dTxRate;
 };
 
+/** What -loadutxosnapshot checks a UTXO snapshot against */
+struct AssumeutxoData {
+    //! Height of the base block
+    int height;
+    //! gettxoutsetinfo's hash_serialized_2 of the UTXO set at the base block
+    uint256 hash_serialized;
+    uint64_t coins_count;
+};
+
+/** The UTXO snapshots -loadutxosnapshot accepts, by the hash of their base block */
+typedef std::map<uint256, AssumeutxoData> MapAssumeutxo;
+
 /**
  * CChainParams defines tweakable parameters for a blockchain instance.
  * There are mainnet, testnet and optionally regtest.
@@ -68,8 +80,10 @@ public:
     const std::vector<SeedSpec6>& FixedSeeds() const { return vFixedSeeds; }
     const CCheckpointData& Checkpoints() const { return checkpointData; }
     const ChainTxData& TxData() const { return chainTxData; }
+    const MapAssumeutxo& Assumeutxo() const { return mapAssumeutxo; }
 
     void UpdateVersionBitsParameters(Consensus::DeploymentPos d, int64_t nStartTime, int64_t nTimeout);
+    void UpdateAssumeutxo(const uint256& base_blockhash, const AssumeutxoData& data);
 
 protected:
     CChainParams() {}
@@ -93,6 +107,7 @@ protected:
 
     CCheckpointData checkpointData;
     ChainTxData chainTxData;
+    MapAssumeutxo mapAssumeutxo;
 };
 
 std::unique_ptr<CChainParams> CreateChainParams(const std::string& chain);
@@ -100,4 +115,7 @@ const CChainParams& Params();
 void SelectParams(const std::string& chain);
 void UpdateVersionBitsParameters(Consensus::DeploymentPos d, int64_t nStartTime, int64_t nTimeout);
 
+/** Allows accepting an additional UTXO snapshot on regtest, for testing. */
+void UpdateAssumeutxo(const uint256& base_blockhash, const AssumeutxoData& data);
+
 #endif // NOTECHAIN_CHAINPARAMS_H
@@ -6,111 +6,263 @@
 #define BITCOIN_CHECKQUEUE_H
 
 #include <sync.h>
+#include <utiltime.h>
 
 #include <algorithm>
+#include <atomic>
+#include <deque>
+#include <memory>
 #include <vector>
 
 #include <boost/thread/condition_variable.hpp>
+#include <boost/thread/exceptions.hpp>
 #include <boost/thread/mutex.hpp>
 
+/**
+ * Perform a chunk of checks taken from a CCheckQueue by one thread, returning
+ * whether all of them succeeded. Check types that can be verified more cheaply
+ * together specialize this.
+ */
+template <typename T>
+bool RunChecks(std::vector<T>& vChecks)
+{
+    for (T& check : vChecks) {
+        if (!check())
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Utilization of a CCheckQueue over one round of checks, i.e. from the first
+ * Add() after the previous Wait() until the next Wait() returns.
+ */
+struct CheckQueueStats
+{
+    //! Threads taking part: the registered workers plus the master
+    unsigned int threads = 0;
+    //! Checks performed (or skipped after a failure)
+    uint64_t checks = 0;
+    //! Batches taken from another thread's queue
+    uint64_t steals = 0;
+    //! Wall clock time of the round, and the summed time threads spent running checks
+    int64_t wall_micros = 0;
+    int64_t busy_micros = 0;
+
+    /** Fraction of the available thread time spent running checks. */
+    double Utilization() const
+    {
+        return wall_micros > 0 && threads > 0 ? (double)busy_micros / ((double)wall_micros * threads) : 0.0;
+    }
+};
+
 /**
  * Queue for verifications that have to be performed.
  * T must provide an operator() that returns a bool.
+ *
+ * Every thread owns a deque of pending checks: the master's is slot 0 and
+ * each worker registering through Thread() gets the next one. Add() deals the
+ * checks out over the deques in chunks, and a thread takes batches from the
+ * back of its own deque, stealing from the front of the others once it runs
+ * dry. The per-deque locks are only contended when a steal races with the
+ * owner, so threads do not serialize on a single queue lock. The shared lock
+ * is only taken to put an idle thread to sleep and wake it up again.
  */
 template <typename T>
 class CCheckQueue {
 private:
+    //! Number of deques; further workers share them
+    static const unsigned int MAX_QUEUES = 64;
+
+    struct alignas(64) WorkQueue {
+        boost::mutex mutex;
+        std::deque<T> checks;
+    };
+
+    std::unique_ptr<WorkQueue[]> queues;
+
+    //! Protects sleeping and waking idle threads
     boost::mutex mutex;
     boost::condition_variable condWorker;
     boost::condition_variable condMaster;
 
-    std::vector<T> queue;
-    int nIdle = 0;
-    int nTotal = 0;
-    bool fAllOk = true;
-    unsigned int nTodo = 0;
+    //! Number of workers that registered through Thread()
+    std::atomic<unsigned int> nWorkers{0};
+    //! Number of workers waiting for checks
+    std::atomic<int> nIdle{0};
+    //! Checks sitting in one of the deques (may briefly go negative while Add() publishes)
+    std::atomic<int> nQueued{0};
+    //! Checks added but not yet finished (including their destruction)
+    std::atomic<unsigned int> nTodo{0};
+    std::atomic<bool> fAllOk{true};
     unsigned int nBatchSize;
 
-    bool Loop(bool fMaster = false) {
-        boost::condition_variable& cond = fMaster ? condMaster : condWorker;
+    //! Deque Add() deals the next chunk to; only used by the master
+    unsigned int nNextQueue = 0;
+
+    //! Counters for the current round; only the master touches nRoundStart
+    std::atomic<uint64_t> nChecks{0};
+    std::atomic<uint64_t> nSteals{0};
+    std::atomic<int64_t> nBusyMicros{0};
+    int64_t nRoundStart = 0;
+    CheckQueueStats lastStats;
+
+    unsigned int ActiveQueues() const {
+        return std::min(nWorkers.load() + 1, MAX_QUEUES);
+    }
+
+    /** Move up to half of a deque (at most nBatchSize) into vChecks; the owner takes from the back, thieves from the front. */
+    bool Take(WorkQueue& queue, std::vector<T>& vChecks, bool fSteal) {
+        boost::unique_lock<boost::mutex> lock(queue.mutex);
+        if (queue.checks.empty())
+            return false;
+        const unsigned int nNow = std::max(1U, std::min(nBatchSize, static_cast<unsigned int>(queue.checks.size() + 1) / 2));
+        vChecks.resize(nNow);
+        for (unsigned int i = 0; i < nNow; ++i) {
+            if (fSteal) {
+                vChecks[i].swap(queue.checks.front());
+                queue.checks.pop_front();
+            } else {
+                vChecks[i].swap(queue.checks.back());
+                queue.checks.pop_back();
+            }
+        }
+        nQueued -= nNow;
+        return true;
+    }
+
+    /** Find a batch of checks, first in our own deque and then in the others. */
+    bool TakeWork(unsigned int nSelf, std::vector<T>& vChecks) {
+        if (nQueued.load() <= 0)
+            return false;
+        if (Take(queues[nSelf], vChecks, false))
+            return true;
+        const unsigned int nQueues = ActiveQueues();
+        for (unsigned int i = 1; i < nQueues; ++i) {
+            if (Take(queues[(nSelf + i) % nQueues], vChecks, true)) {
+                nSteals++;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /** Run a batch unless the round already failed, destroy it, and then mark it done. */
+    void Run(std::vector<T>& vChecks) {
+        bool fOk = fAllOk.load();
+        if (fOk) {
+            const int64_t nStart = GetTimeMicros();
+            fOk = RunChecks(vChecks);
+            nBusyMicros += GetTimeMicros() - nStart;
+            if (!fOk)
+                fAllOk = false;
+        }
+        const unsigned int nNow = vChecks.size();
+        vChecks.clear();
+        nChecks += nNow;
+        if (nTodo.fetch_sub(nNow) == nNow) {
+            boost::unique_lock<boost::mutex> lock(mutex);
+            condMaster.notify_one();
+        }
+    }
+
+    void Loop(unsigned int nSelf) {
         std::vector<T> vChecks;
         vChecks.reserve(nBatchSize);
-        unsigned int nNow = 0;
-        bool fOk = true;
-
-        do {
-            {
-                boost::unique_lock<boost::mutex> lock(mutex);
-
-                if (nNow) {
-                    fAllOk &= fOk;
-                    nTodo -= nNow;
-                    if (nTodo == 0 && !fMaster)
-                        condMaster.notify_one();
-                } else {
-                    nTotal++;
-                }
-
-                while (queue.empty()) {
-                    if (fMaster && nTodo == 0) {
-                        nTotal--;
-                        bool fRet = fAllOk;
-                        if (fMaster) fAllOk = true;
-                        return fRet;
-                    }
-                    nIdle++;
-                    cond.wait(lock);
-                    nIdle--;
-                }
-
-                nNow = std::max(1U, std::min(nBatchSize, static_cast<unsigned int>(queue.size()) / (nTotal + nIdle + 1)));
-                vChecks.resize(nNow);
-                for (unsigned int i = 0; i < nNow; ++i) {
-                    vChecks[i].swap(queue.back());
-                    queue.pop_back();
-                }
-
-                fOk = fAllOk;
+        while (true) {
+            if (TakeWork(nSelf, vChecks)) {
+                Run(vChecks);
+                continue;
             }
-
-            for (T& check : vChecks) {
-                if (fOk)
-                    fOk = check();
+            boost::unique_lock<boost::mutex> lock(mutex);
+            nIdle++;
+            try {
+                while (nQueued.load() <= 0)
+                    condWorker.wait(lock);
+            } catch (const boost::thread_interrupted&) {
+                nIdle--;
+                throw;
             }
-            vChecks.clear();
-        } while (true);
+            nIdle--;
+        }
     }
 
 public:
     boost::mutex ControlMutex;
 
-    explicit CCheckQueue(unsigned int nBatchSizeIn) : nBatchSize(nBatchSizeIn) {}
+    explicit CCheckQueue(unsigned int nBatchSizeIn) : queues(new WorkQueue[MAX_QUEUES]), nBatchSize(nBatchSizeIn) {}
 
     void Thread() {
-        Loop();
+        const unsigned int nId = ++nWorkers;
+        Loop(nId % MAX_QUEUES);
     }
 
     bool Wait() {
-        return Loop(true);
+        std::vector<T> vChecks;
+        vChecks.reserve(nBatchSize);
+        while (true) {
+            if (TakeWork(0, vChecks)) {
+                Run(vChecks);
+                continue;
+            }
+            if (nTodo.load() == 0)
+                break;
+            // Only the master adds checks, so there is nothing left to take
+            // until the workers finish what they hold.
+            boost::unique_lock<boost::mutex> lock(mutex);
+            while (nTodo.load() != 0 && nQueued.load() <= 0)
+                condMaster.wait(lock);
+        }
+
+        lastStats.threads = nWorkers.load() + 1;
+        lastStats.checks = nChecks.exchange(0);
+        lastStats.steals = nSteals.exchange(0);
+        lastStats.busy_micros = nBusyMicros.exchange(0);
+        lastStats.wall_micros = nRoundStart ? GetTimeMicros() - nRoundStart : 0;
+        nRoundStart = 0;
+        return fAllOk.exchange(true);
     }
 
     void Add(std::vector<T>& vChecks) {
-        boost::unique_lock<boost::mutex> lock(mutex);
-        for (T& check : vChecks) {
-            queue.emplace_back();
-            check.swap(queue.back());
-        }
+        if (vChecks.empty())
+            return;
+        if (!nRoundStart)
+            nRoundStart = GetTimeMicros();
         nTodo += vChecks.size();
-        if (vChecks.size() == 1)
-            condWorker.notify_one();
-        else if (!vChecks.empty())
-            condWorker.notify_all();
+
+        // Deal the checks out in chunks, so that a large Add() is spread over
+        // the threads right away instead of waiting to be stolen.
+        const unsigned int nQueues = ActiveQueues();
+        const size_t nChunk = std::max<size_t>(1, std::min<size_t>(nBatchSize, (vChecks.size() + nQueues - 1) / nQueues));
+        for (size_t nPos = 0; nPos < vChecks.size(); nPos += nChunk) {
+            const size_t nEnd = std::min(vChecks.size(), nPos + nChunk);
+            WorkQueue& queue = queues[nNextQueue];
+            nNextQueue = (nNextQueue + 1) % nQueues;
+            boost::unique_lock<boost::mutex> lock(queue.mutex);
+            for (size_t i = nPos; i < nEnd; ++i) {
+                queue.checks.emplace_back();
+                vChecks[i].swap(queue.checks.back());
+            }
+        }
+        nQueued += vChecks.size();
+
+        if (nIdle.load() > 0) {
+            boost::unique_lock<boost::mutex> lock(mutex);
+            if (vChecks.size() == 1)
+                condWorker.notify_one();
+            else
+                condWorker.notify_all();
+        }
+    }
+
+    /** Statistics of the last round of checks, valid until the next Add(). */
+    CheckQueueStats GetLastStats() const {
+        return lastStats;
     }
 
     ~CCheckQueue() = default;
 };
 
-
 /**
  * RAII-style controller for a CCheckQueue.
  * Guarantees the queue is finished before continuing.
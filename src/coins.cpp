@@ -19,6 +19,13 @@ bool CCoinsView::HaveCoin(const COutPoint& outpoint) const {
     return GetCoin(outpoint, coin);
 }
 
+void CCoinsView::GetCoins(const std::vector<COutPoint>& outpoints, std::vector<Coin>& coins, std::vector<bool>& found) const {
+    coins.resize(outpoints.size());
+    found.resize(outpoints.size());
+    for (size_t i = 0; i < outpoints.size(); ++i)
+        found[i] = GetCoin(outpoints[i], coins[i]);
+}
+
 // === CCoinsViewBacked Implementation ===
 
 CCoinsViewBacked::CCoinsViewBacked(CCoinsView* viewIn) : base(viewIn) {}
@@ -63,6 +70,50 @@ CCoinsMap::iterator CCoinsViewCache::FetchCoin(const COutPoint& outpoint) const
     return ret;
 }
 
+bool CCoinsViewCache::FetchCoins(const std::vector<COutPoint>& outpoints) const {
+    // The probes do not depend on each other, so their cache misses overlap
+    // instead of each one waiting behind the previous lookup's fetch.
+    bool fAll = true;
+    std::vector<COutPoint> missing;
+    for (const auto& outpoint : outpoints) {
+        auto it = cacheCoins.find(outpoint);
+        if (it == cacheCoins.end())
+            missing.push_back(outpoint);
+        else if (it->second.coin.IsSpent())
+            fAll = false;
+    }
+    if (missing.empty()) return fAll;
+
+    std::vector<Coin> coins;
+    std::vector<bool> found;
+    base->GetCoins(missing, coins, found);
+    for (size_t i = 0; i < missing.size(); ++i) {
+        if (!found[i]) {
+            fAll = false;
+            continue;
+        }
+        auto [it, inserted] = cacheCoins.emplace(std::piecewise_construct, std::forward_as_tuple(missing[i]), std::forward_as_tuple(std::move(coins[i])));
+        if (!inserted) continue; // listed twice
+
+        if (it->second.coin.IsSpent())
+            it->second.flags = CCoinsCacheEntry::FRESH;
+
+        cachedCoinsUsage += it->second.coin.DynamicMemoryUsage();
+    }
+    return fAll;
+}
+
+void CCoinsViewCache::GetCoins(const std::vector<COutPoint>& outpoints, std::vector<Coin>& coins, std::vector<bool>& found) const {
+    FetchCoins(outpoints);
+    coins.resize(outpoints.size());
+    found.resize(outpoints.size());
+    for (size_t i = 0; i < outpoints.size(); ++i) {
+        auto it = cacheCoins.find(outpoints[i]);
+        found[i] = it != cacheCoins.end() && !it->second.coin.IsSpent();
+        if (found[i]) coins[i] = it->second.coin;
+    }
+}
+
 bool CCoinsViewCache::GetCoin(const COutPoint& outpoint, Coin& coin) const {
     auto it = FetchCoin(outpoint);
     if (it == cacheCoins.end()) return false;
@@ -213,11 +264,12 @@ CAmount CCoinsViewCache::GetValueIn(const CTransaction& tx) const {
 bool CCoinsViewCache::HaveInputs(const CTransaction& tx) const {
     if (tx.IsCoinBase()) return true;
 
+    std::vector<COutPoint> prevouts;
+    prevouts.reserve(tx.vin.size());
     for (const auto& in : tx.vin)
-        if (!HaveCoin(in.prevout))
-            return false;
+        prevouts.push_back(in.prevout);
 
-    return true;
+    return FetchCoins(prevouts);
 }
 
 // === TXID-Zugriff ===
@@ -234,3 +286,15 @@ const Coin& AccessByTxid(const CCoinsViewCache& view, const uint256& txid) {
     }
     return coinEmpty;
 }
+
+void ApplyTxOutSetHash(CHashWriter& ss, const uint256& txid, const std::map<uint32_t, Coin>& outputs) {
+    assert(!outputs.empty());
+    ss << txid;
+    ss << VARINT(outputs.begin()->second.nHeight * 2 + outputs.begin()->second.fCoinBase);
+    for (const auto& output : outputs) {
+        ss << VARINT(output.first + 1);
+        ss << output.second.out.scriptPubKey;
+        ss << VARINT(output.second.out.nValue);
+    }
+    ss << VARINT(0);
+}
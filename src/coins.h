@@ -15,6 +15,7 @@
 
 #include <cassert>
 #include <cstdint>
+#include <map>
 #include <unordered_map>
 
 // === Coin: UTXO-Dateneintrag ===
@@ -124,6 +125,8 @@ public:
 
     virtual bool GetCoin(const COutPoint& outpoint, Coin& coin) const;
     virtual bool HaveCoin(const COutPoint& outpoint) const;
+    //! Look up several outpoints at once; found[i] is what GetCoin(outpoints[i], coins[i]) would return
+    virtual void GetCoins(const std::vector<COutPoint>& outpoints, std::vector<Coin>& coins, std::vector<bool>& found) const;
     virtual uint256 GetBestBlock() const;
     virtual std::vector<uint256> GetHeadBlocks() const;
     virtual bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock);
@@ -163,6 +166,7 @@ public:
 
     bool GetCoin(const COutPoint& outpoint, Coin& coin) const override;
     bool HaveCoin(const COutPoint& outpoint) const override;
+    void GetCoins(const std::vector<COutPoint>& outpoints, std::vector<Coin>& coins, std::vector<bool>& found) const override;
     uint256 GetBestBlock() const override;
     void SetBestBlock(const uint256& hashBlockIn);
     bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock) override;
@@ -174,6 +178,14 @@ public:
     bool HaveCoinInCache(const COutPoint& outpoint) const;
     const Coin& AccessCoin(const COutPoint& outpoint) const;
 
+    /**
+     * Bring the coins of several outpoints (e.g. all inputs of a transaction)
+     * into the cache together: probe the cache for all of them first, then
+     * fetch the misses from the backing view in one GetCoins call. Returns
+     * whether all of them exist unspent.
+     */
+    bool FetchCoins(const std::vector<COutPoint>& outpoints) const;
+
     void AddCoin(const COutPoint& outpoint, Coin&& coin, bool potential_overwrite);
     bool SpendCoin(const COutPoint& outpoint, Coin* moveto = nullptr);
     bool Flush();
@@ -194,4 +206,10 @@ private:
 void AddCoins(CCoinsViewCache& cache, const CTransaction& tx, int nHeight, bool check = false);
 const Coin& AccessByTxid(const CCoinsViewCache& cache, const uint256& txid);
 
+/**
+ * Add the unspent outputs of one transaction, keyed by output index, to a
+ * hash of the UTXO set as gettxoutsetinfo computes its hash_serialized_2.
+ */
+void ApplyTxOutSetHash(CHashWriter& ss, const uint256& txid, const std::map<uint32_t, Coin>& outputs);
+
 #endif // BITCOIN_COINS_H
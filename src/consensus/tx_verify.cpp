@@ -10,6 +10,8 @@
 #include <chain.h>
 #include <coins.h>
 
+#include <algorithm>
+
 bool IsFinalTx(const CTransaction& tx, int nBlockHeight, int64_t nBlockTime)
 {
     if (tx.nLockTime == 0)
@@ -140,12 +142,15 @@ bool CheckTransaction(const CTransaction& tx, CValidationState& state, bool fChe
             return state.DoS(100, false, REJECT_INVALID, "bad-txns-txouttotal-toolarge");
     }
 
-    if (fCheckDuplicateInputs) {
-        std::set<COutPoint> inPoints;
-        for (const auto& txin : tx.vin) {
-            if (!inPoints.insert(txin.prevout).second)
-                return state.DoS(100, false, REJECT_INVALID, "bad-txns-inputs-duplicate");
-        }
+    if (fCheckDuplicateInputs && tx.vin.size() > 1) {
+        // Sorting a flat copy finds duplicates without a node allocation per input.
+        std::vector<COutPoint> vInPoints;
+        vInPoints.reserve(tx.vin.size());
+        for (const auto& txin : tx.vin)
+            vInPoints.push_back(txin.prevout);
+        std::sort(vInPoints.begin(), vInPoints.end());
+        if (std::adjacent_find(vInPoints.begin(), vInPoints.end()) != vInPoints.end())
+            return state.DoS(100, false, REJECT_INVALID, "bad-txns-inputs-duplicate");
     }
 
     if (tx.IsCoinBase()) {
@@ -0,0 +1,129 @@
+// Copyright (c) 2024 The NoteCoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <crypto/keccak.h>
+#include <crypto/common.h>
+
+#include <string.h>
+
+namespace
+{
+/// Internal Keccak implementation.
+namespace keccak
+{
+const uint64_t RC[24] = {
+    0x0000000000000001ull, 0x0000000000008082ull, 0x800000000000808aull, 0x8000000080008000ull,
+    0x000000000000808bull, 0x0000000080000001ull, 0x8000000080008081ull, 0x8000000000008009ull,
+    0x000000000000008aull, 0x0000000000000088ull, 0x0000000080008009ull, 0x000000008000000aull,
+    0x000000008000808bull, 0x800000000000008bull, 0x8000000000008089ull, 0x8000000000008003ull,
+    0x8000000000008002ull, 0x8000000000000080ull, 0x000000000000800aull, 0x800000008000000aull,
+    0x8000000080008081ull, 0x8000000000008080ull, 0x0000000080000001ull, 0x8000000080008008ull,
+};
+
+/** Rotation offsets, in the order lanes are visited by the combined rho/pi step. */
+const int ROTC[24] = {1, 3, 6, 10, 15, 21, 28, 36, 45, 55, 2, 14, 27, 41, 56, 8, 25, 43, 62, 18, 39, 61, 20, 44};
+const int PILN[24] = {10, 7, 11, 17, 18, 3, 5, 16, 8, 21, 24, 4, 15, 23, 19, 13, 12, 2, 20, 14, 22, 9, 6, 1};
+
+template <typename T>
+T inline Rotl(T x, int n)
+{
+    const int bits = sizeof(T) * 8;
+    n %= bits;
+    return n ? (T)((x << n) | (x >> (bits - n))) : x;
+}
+
+/** Keccak-f[25*w] where w is the bit width of T; round constants are truncated to w bits. */
+template <typename T>
+void Permute(T st[25], int rounds)
+{
+    T bc[5];
+    for (int round = 0; round < rounds; ++round) {
+        // Theta
+        for (int i = 0; i < 5; ++i) {
+            bc[i] = st[i] ^ st[i + 5] ^ st[i + 10] ^ st[i + 15] ^ st[i + 20];
+        }
+        for (int i = 0; i < 5; ++i) {
+            T t = bc[(i + 4) % 5] ^ Rotl<T>(bc[(i + 1) % 5], 1);
+            for (int j = 0; j < 25; j += 5) {
+                st[j + i] ^= t;
+            }
+        }
+
+        // Rho and pi
+        T t = st[1];
+        for (int i = 0; i < 24; ++i) {
+            int j = PILN[i];
+            T tmp = st[j];
+            st[j] = Rotl<T>(t, ROTC[i]);
+            t = tmp;
+        }
+
+        // Chi
+        for (int j = 0; j < 25; j += 5) {
+            for (int i = 0; i < 5; ++i) {
+                bc[i] = st[j + i];
+            }
+            for (int i = 0; i < 5; ++i) {
+                st[j + i] ^= (~bc[(i + 1) % 5]) & bc[(i + 2) % 5];
+            }
+        }
+
+        // Iota
+        st[0] ^= (T)RC[round];
+    }
+}
+
+/** Sponge with the original Keccak multi-rate padding (0x01 ... 0x80). */
+void Sponge(size_t rate, const unsigned char* data, size_t len, unsigned char* out, size_t outlen)
+{
+    uint64_t st[25];
+    memset(st, 0, sizeof(st));
+    const size_t lanes = rate / 8;
+
+    while (len >= rate) {
+        for (size_t i = 0; i < lanes; ++i) {
+            st[i] ^= ReadLE64(data + 8 * i);
+        }
+        KeccakF1600(st);
+        data += rate;
+        len -= rate;
+    }
+
+    unsigned char last[200];
+    memset(last, 0, rate);
+    memcpy(last, data, len);
+    last[len] ^= 0x01;
+    last[rate - 1] ^= 0x80;
+    for (size_t i = 0; i < lanes; ++i) {
+        st[i] ^= ReadLE64(last + 8 * i);
+    }
+    KeccakF1600(st);
+
+    // All outputs used by this codebase fit in a single squeeze.
+    for (size_t i = 0; i < outlen / 8; ++i) {
+        WriteLE64(out + 8 * i, st[i]);
+    }
+}
+} // namespace keccak
+} // namespace
+
+void KeccakF1600(uint64_t st[25])
+{
+    keccak::Permute<uint64_t>(st, 24);
+}
+
+void KeccakF800(uint32_t st[25])
+{
+    keccak::Permute<uint32_t>(st, 22);
+}
+
+void Keccak256(const unsigned char* data, size_t len, unsigned char hash[32])
+{
+    keccak::Sponge(136, data, len, hash, 32);
+}
+
+void Keccak512(const unsigned char* data, size_t len, unsigned char hash[64])
+{
+    keccak::Sponge(72, data, len, hash, 64);
+}
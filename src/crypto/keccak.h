@@ -0,0 +1,23 @@
+// Copyright (c) 2024 The NoteCoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_CRYPTO_KECCAK_H
+#define BITCOIN_CRYPTO_KECCAK_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/** Keccak-f[1600] permutation (24 rounds over 64-bit lanes). */
+void KeccakF1600(uint64_t st[25]);
+
+/** Keccak-f[800] permutation (22 rounds over 32-bit lanes), as used by ProgPoW. */
+void KeccakF800(uint32_t st[25]);
+
+/** Original Keccak-256 (0x01 padding, not SHA3-256), as used by ethash. */
+void Keccak256(const unsigned char* data, size_t len, unsigned char hash[32]);
+
+/** Original Keccak-512 (0x01 padding, not SHA3-512), as used by ethash. */
+void Keccak512(const unsigned char* data, size_t len, unsigned char hash[64]);
+
+#endif // BITCOIN_CRYPTO_KECCAK_H
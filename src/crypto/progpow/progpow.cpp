@@ -1,33 +1,325 @@
 #include <crypto/progpow/progpow.hpp>
-#include <crypto/keccak.h> // vorhandene Keccak-Implementation (SHA3)
+#include <crypto/common.h>
+#include <crypto/keccak.h>
+
+#include <algorithm>
+#include <array>
+#include <string.h>
 
 namespace progpow {
 
-// Dummy seed hash generator (real implementation uses fixed table)
-static uint256 get_seed_hash(uint64_t height)
+namespace {
+
+const uint32_t NUM_REGS = 32;
+const size_t NUM_LANES = 16;
+const int NUM_CACHE_ACCESSES = 11;
+const int NUM_MATH_OPERATIONS = 18;
+const int NUM_ROUNDS = 64;
+/** Words of each 2048-bit DAG item consumed by one lane. */
+const size_t NUM_WORDS_PER_LANE = 64 / NUM_LANES;
+
+const uint32_t FNV_PRIME = 0x01000193;
+const uint32_t FNV_OFFSET_BASIS = 0x811c9dc5;
+
+/** "RAVENCOINKAWPOW", the KawPoW padding of the Keccak-f[800] input. */
+const uint32_t KAWPOW_PADDING[15] = {
+    0x00000072, 0x00000041, 0x00000056, 0x00000045, 0x0000004E, 0x00000043, 0x0000004F, 0x00000049,
+    0x0000004E, 0x0000004B, 0x00000041, 0x00000057, 0x00000050, 0x0000004F, 0x00000057,
+};
+
+/**
+ * ethash digests are byte strings; uint256 keeps them reversed, matching the
+ * hex strings KawPoW miners exchange (uint256S(to_hex(digest)) in Ravencoin).
+ */
+void ToDigestBytes(const uint256& in, unsigned char out[32])
+{
+    for (int i = 0; i < 32; ++i) out[i] = in.begin()[31 - i];
+}
+
+uint256 FromDigestBytes(const unsigned char in[32])
+{
+    uint256 out;
+    for (int i = 0; i < 32; ++i) out.begin()[i] = in[31 - i];
+    return out;
+}
+
+inline uint32_t fnv1a(uint32_t u, uint32_t v) { return (u ^ v) * FNV_PRIME; }
+inline uint32_t rotl32(uint32_t n, uint32_t c) { c &= 31; return c ? (n << c) | (n >> (32 - c)) : n; }
+inline uint32_t rotr32(uint32_t n, uint32_t c) { c &= 31; return c ? (n >> c) | (n << (32 - c)) : n; }
+inline uint32_t mul_hi32(uint32_t a, uint32_t b) { return (uint32_t)(((uint64_t)a * b) >> 32); }
+
+inline uint32_t clz32(uint32_t x)
+{
+    uint32_t n = 0;
+    if (x == 0) return 32;
+    while (!(x & 0x80000000u)) { x <<= 1; ++n; }
+    return n;
+}
+
+inline uint32_t popcount32(uint32_t x)
+{
+    uint32_t n = 0;
+    for (; x; x &= x - 1) ++n;
+    return n;
+}
+
+/** KISS99 pseudo random generator, as specified by ProgPoW. */
+class Kiss99
 {
-    // Simplified: just hash the height into a 256-bit seed
-    CHash256 hasher;
-    hasher.Write((const unsigned char*)&height, sizeof(height));
-    uint256 seed;
-    hasher.Finalize(seed.begin());
-    return seed;
+private:
+    uint32_t z, w, jsr, jcong;
+
+public:
+    Kiss99(uint32_t z_, uint32_t w_, uint32_t jsr_, uint32_t jcong_) : z(z_), w(w_), jsr(jsr_), jcong(jcong_) {}
+
+    uint32_t operator()()
+    {
+        z = 36969 * (z & 0xffff) + (z >> 16);
+        w = 18000 * (w & 0xffff) + (w >> 16);
+        jcong = 69069 * jcong + 1234567;
+        jsr ^= (jsr << 17);
+        jsr ^= (jsr >> 13);
+        jsr ^= (jsr << 5);
+        return (((z << 16) + w) ^ jcong) + jsr;
+    }
+};
+
+/** The random program of one period: register permutations plus the KISS99 stream. */
+class MixRngState
+{
+private:
+    size_t dst_counter = 0;
+    size_t src_counter = 0;
+    std::array<uint32_t, NUM_REGS> dst_seq;
+    std::array<uint32_t, NUM_REGS> src_seq;
+
+public:
+    Kiss99 rng;
+
+    explicit MixRngState(uint64_t seed) : rng(0, 0, 0, 0)
+    {
+        const uint32_t seed_lo = (uint32_t)seed;
+        const uint32_t seed_hi = (uint32_t)(seed >> 32);
+        const uint32_t z = fnv1a(FNV_OFFSET_BASIS, seed_lo);
+        const uint32_t w = fnv1a(z, seed_hi);
+        const uint32_t jsr = fnv1a(w, seed_lo);
+        const uint32_t jcong = fnv1a(jsr, seed_hi);
+        rng = Kiss99(z, w, jsr, jcong);
+
+        // Fisher-Yates shuffle of the mix destinations and sources.
+        for (uint32_t i = 0; i < NUM_REGS; ++i) {
+            dst_seq[i] = i;
+            src_seq[i] = i;
+        }
+        for (uint32_t i = NUM_REGS; i > 1; --i) {
+            std::swap(dst_seq[i - 1], dst_seq[rng() % i]);
+            std::swap(src_seq[i - 1], src_seq[rng() % i]);
+        }
+    }
+
+    uint32_t NextDst() { return dst_seq[(dst_counter++) % NUM_REGS]; }
+    uint32_t NextSrc() { return src_seq[(src_counter++) % NUM_REGS]; }
+};
+
+typedef std::array<std::array<uint32_t, NUM_REGS>, NUM_LANES> MixArray;
+
+uint32_t RandomMath(uint32_t a, uint32_t b, uint32_t selector)
+{
+    switch (selector % 11) {
+    default:
+    case 0: return a + b;
+    case 1: return a * b;
+    case 2: return mul_hi32(a, b);
+    case 3: return std::min(a, b);
+    case 4: return rotl32(a, b);
+    case 5: return rotr32(a, b);
+    case 6: return a & b;
+    case 7: return a | b;
+    case 8: return a ^ b;
+    case 9: return clz32(a) + clz32(b);
+    case 10: return popcount32(a) + popcount32(b);
+    }
+}
+
+void RandomMerge(uint32_t& a, uint32_t b, uint32_t selector)
+{
+    const uint32_t x = (selector >> 16) % 31 + 1;
+    switch (selector % 4) {
+    case 0: a = (a * 33) + b; break;
+    case 1: a = (a ^ b) * 33; break;
+    case 2: a = rotl32(a, x) ^ b; break;
+    case 3: a = rotr32(a, x) ^ b; break;
+    }
+}
+
+MixArray InitMix(uint32_t seed0, uint32_t seed1)
+{
+    const uint32_t z = fnv1a(FNV_OFFSET_BASIS, seed0);
+    const uint32_t w = fnv1a(z, seed1);
+
+    MixArray mix;
+    for (uint32_t l = 0; l < NUM_LANES; ++l) {
+        const uint32_t jsr = fnv1a(w, l);
+        const uint32_t jcong = fnv1a(jsr, l);
+        Kiss99 rng(z, w, jsr, jcong);
+        for (uint32_t& reg : mix[l]) reg = rng();
+    }
+    return mix;
 }
 
-uint256 hash(const uint256& header_hash, uint64_t nonce, uint64_t height)
+/** One ProgPoW loop iteration. The program state is passed by value: every round replays it. */
+void Round(const EpochContext& context, uint32_t r, MixArray& mix, MixRngState state)
 {
-    // Generate seed hash for height
-    uint256 seed_hash = get_seed_hash(height);
+    const uint32_t num_items = (uint32_t)(context.full_dataset_num_items / 2);
+    const uint32_t item_index = mix[r % NUM_LANES][0] % num_items;
+    uint32_t item[64];
+    CalculateDatasetItem2048(context, item_index, item);
 
-    // Combine header_hash + nonce + seed_hash into final hash
-    CHash256 hasher;
-    hasher.Write(header_hash.begin(), header_hash.size());
-    hasher.Write((const unsigned char*)&nonce, sizeof(nonce));
-    hasher.Write(seed_hash.begin(), seed_hash.size());
+    const int max_operations = std::max(NUM_CACHE_ACCESSES, NUM_MATH_OPERATIONS);
+    for (int i = 0; i < max_operations; ++i) {
+        if (i < NUM_CACHE_ACCESSES) {
+            // Random access to the L1 cache.
+            const uint32_t src = state.NextSrc();
+            const uint32_t dst = state.NextDst();
+            const uint32_t sel = state.rng();
+            for (size_t l = 0; l < NUM_LANES; ++l) {
+                const size_t offset = mix[l][src] % L1_CACHE_NUM_ITEMS;
+                RandomMerge(mix[l][dst], context.l1_cache[offset], sel);
+            }
+        }
+        if (i < NUM_MATH_OPERATIONS) {
+            // Random math on two distinct registers.
+            const uint32_t src_rnd = state.rng() % (NUM_REGS * (NUM_REGS - 1));
+            const uint32_t src1 = src_rnd % NUM_REGS;
+            uint32_t src2 = src_rnd / NUM_REGS;
+            if (src2 >= src1) ++src2;
 
-    uint256 result;
-    hasher.Finalize(result.begin());
-    return result;
+            const uint32_t sel1 = state.rng();
+            const uint32_t dst = state.NextDst();
+            const uint32_t sel2 = state.rng();
+            for (size_t l = 0; l < NUM_LANES; ++l) {
+                const uint32_t data = RandomMath(mix[l][src1], mix[l][src2], sel1);
+                RandomMerge(mix[l][dst], data, sel2);
+            }
+        }
+    }
+
+    // DAG access.
+    uint32_t dsts[NUM_WORDS_PER_LANE];
+    uint32_t sels[NUM_WORDS_PER_LANE];
+    for (size_t i = 0; i < NUM_WORDS_PER_LANE; ++i) {
+        dsts[i] = i == 0 ? 0 : state.NextDst();
+        sels[i] = state.rng();
+    }
+    for (size_t l = 0; l < NUM_LANES; ++l) {
+        const size_t offset = ((l ^ r) % NUM_LANES) * NUM_WORDS_PER_LANE;
+        for (size_t i = 0; i < NUM_WORDS_PER_LANE; ++i) {
+            RandomMerge(mix[l][dsts[i]], item[offset + i], sels[i]);
+        }
+    }
+}
+
+void HashMix(const EpochContext& context, uint64_t height, uint32_t seed0, uint32_t seed1, uint32_t mix_hash[8])
+{
+    MixArray mix = InitMix(seed0, seed1);
+    const MixRngState state(height / PERIOD_LENGTH);
+
+    for (uint32_t r = 0; r < NUM_ROUNDS; ++r) {
+        Round(context, r, mix, state);
+    }
+
+    // Reduce the mix to one word per lane, then the lanes to 256 bits.
+    uint32_t lane_hash[NUM_LANES];
+    for (size_t l = 0; l < NUM_LANES; ++l) {
+        lane_hash[l] = FNV_OFFSET_BASIS;
+        for (uint32_t i = 0; i < NUM_REGS; ++i) {
+            lane_hash[l] = fnv1a(lane_hash[l], mix[l][i]);
+        }
+    }
+    for (int i = 0; i < 8; ++i) mix_hash[i] = FNV_OFFSET_BASIS;
+    for (size_t l = 0; l < NUM_LANES; ++l) {
+        mix_hash[l % 8] = fnv1a(mix_hash[l % 8], lane_hash[l]);
+    }
+}
+
+/** Final Keccak-f[800] pass over the carried-over seed words, mix digest and padding. */
+uint256 FinalHash(const uint32_t seed[8], const uint32_t mix[8])
+{
+    uint32_t state[25];
+    for (int i = 0; i < 8; ++i) state[i] = seed[i];
+    for (int i = 8; i < 16; ++i) state[i] = mix[i - 8];
+    for (int i = 16; i < 25; ++i) state[i] = KAWPOW_PADDING[i - 16];
+    KeccakF800(state);
+
+    unsigned char digest[32];
+    for (int i = 0; i < 8; ++i) WriteLE32(digest + 4 * i, state[i]);
+    return FromDigestBytes(digest);
+}
+
+} // namespace
+
+SeedHasher::SeedHasher(const uint256& header_hash)
+{
+    unsigned char digest[32];
+    ToDigestBytes(header_hash, digest);
+    for (int i = 0; i < 8; ++i) base[i] = ReadLE32(digest + 4 * i);
+    base[8] = 0;
+    base[9] = 0;
+    for (int i = 10; i < 25; ++i) base[i] = KAWPOW_PADDING[i - 10];
+}
+
+void SeedHasher::Seed(uint64_t nonce, uint32_t seed[8]) const
+{
+    uint32_t state[25];
+    memcpy(state, base, sizeof(state));
+    state[8] = (uint32_t)nonce;
+    state[9] = (uint32_t)(nonce >> 32);
+    KeccakF800(state);
+    memcpy(seed, state, 8 * sizeof(uint32_t));
+}
+
+uint256 hash(const EpochContext& context, const SeedHasher& hasher, uint64_t nonce, uint64_t height, uint256* mix_hash)
+{
+    uint32_t seed[8];
+    hasher.Seed(nonce, seed);
+
+    uint32_t mix[8];
+    HashMix(context, height, seed[0], seed[1], mix);
+
+    if (mix_hash) {
+        unsigned char digest[32];
+        for (int i = 0; i < 8; ++i) WriteLE32(digest + 4 * i, mix[i]);
+        *mix_hash = FromDigestBytes(digest);
+    }
+    return FinalHash(seed, mix);
+}
+
+uint256 hash_light(const SeedHasher& hasher, uint64_t nonce, const uint256& mix_hash)
+{
+    uint32_t seed[8];
+    hasher.Seed(nonce, seed);
+
+    unsigned char digest[32];
+    ToDigestBytes(mix_hash, digest);
+    uint32_t mix[8];
+    for (int i = 0; i < 8; ++i) mix[i] = ReadLE32(digest + 4 * i);
+    return FinalHash(seed, mix);
+}
+
+uint256 hash(const EpochContext& context, const uint256& header_hash, uint64_t nonce, uint64_t height, uint256* mix_hash)
+{
+    return hash(context, SeedHasher(header_hash), nonce, height, mix_hash);
+}
+
+uint256 hash_light(const uint256& header_hash, uint64_t nonce, const uint256& mix_hash)
+{
+    return hash_light(SeedHasher(header_hash), nonce, mix_hash);
+}
+
+uint256 hash(const uint256& header_hash, uint64_t nonce, uint64_t height, uint256* mix_hash)
+{
+    std::shared_ptr<const EpochContext> context = GetEpochContext(GetEpochNumber(height));
+    return hash(*context, header_hash, nonce, height, mix_hash);
 }
 
 } // namespace progpow
@@ -2,20 +2,106 @@
 #define PROGPOW_HASH_HPP
 
 #include <uint256.h>
+
 #include <cstdint>
+#include <memory>
+#include <vector>
 
 namespace progpow {
 
+/** Number of blocks sharing one ethash epoch (KawPoW uses a quarter of ethash's 30000). */
+static const int EPOCH_LENGTH = 7500;
+/** Number of blocks sharing one random ProgPoW program. */
+static const int PERIOD_LENGTH = 3;
+/** Size of the ProgPoW L1 cache, taken from the start of the DAG. */
+static const size_t L1_CACHE_SIZE = 16 * 1024;
+/** Number of 32-bit words in the L1 cache. */
+static const size_t L1_CACHE_NUM_ITEMS = L1_CACHE_SIZE / sizeof(uint32_t);
+/** Number of epoch contexts kept alive by GetEpochContext(). */
+static const size_t MAX_CACHED_EPOCHS = 3;
+
+/**
+ * Everything needed to verify a KawPoW hash for one epoch without the full
+ * DAG: the ethash light cache and the first 16KiB of the DAG. Immutable once
+ * built, so it can be shared between threads.
+ */
+struct EpochContext
+{
+    int epoch_number;
+    /** Number of 512-bit items in the light cache. */
+    uint64_t light_cache_num_items;
+    /** Number of 1024-bit items in the (never materialised) full DAG. */
+    uint64_t full_dataset_num_items;
+    /** Light cache, 16 little-endian words per item. */
+    std::vector<uint32_t> light_cache;
+    /** First L1_CACHE_SIZE bytes of the DAG. */
+    std::vector<uint32_t> l1_cache;
+};
+
+int GetEpochNumber(uint64_t height);
+uint64_t GetLightCacheNumItems(int epoch_number);
+uint64_t GetFullDatasetNumItems(int epoch_number);
+
+/** Seed of the given epoch: Keccak-256 applied epoch_number times to zero. */
+uint256 GetEpochSeed(int epoch_number);
+
+/** Build a context from scratch. Expensive (~16MiB of Keccak-512); prefer GetEpochContext(). */
+std::shared_ptr<const EpochContext> CreateEpochContext(int epoch_number);
+
+/**
+ * Return the context for an epoch from a small LRU of recently used epochs,
+ * building it on a miss. Thread-safe; the build runs without the LRU's lock.
+ */
+std::shared_ptr<const EpochContext> GetEpochContext(int epoch_number);
+
+/** Compute one 2048-bit DAG item (64 words) from the light cache. */
+void CalculateDatasetItem2048(const EpochContext& context, uint32_t index, uint32_t item[64]);
+
+/**
+ * Keccak-f[800] input for one header hash with the KawPoW padding already in
+ * place. Seeding a nonce only rewrites two words of a stack copy, so one
+ * instance can be reused across a whole nonce range.
+ */
+class SeedHasher
+{
+private:
+    uint32_t base[25];
+
+public:
+    explicit SeedHasher(const uint256& header_hash);
+
+    /** Run the initial Keccak-f[800] pass for one nonce, producing the 8 words carried into the final pass. */
+    void Seed(uint64_t nonce, uint32_t seed[8]) const;
+};
+
 /**
  * Computes the KawPoW (ProgPoW) hash for block verification.
  *
  * @param header_hash  Double-SHA256 of the block header
  * @param nonce        64-bit block nonce
  * @param height       Block height (used for seed)
+ * @param mix_hash     If not null, receives the ProgPoW mix digest
  *
  * @return Final KawPoW result (uint256)
+ *
+ * header_hash, mix_hash and the result use the byte order of the hex strings
+ * KawPoW miners exchange, so targets compare the same way as in stock miners.
+ */
+uint256 hash(const uint256& header_hash, uint64_t nonce, uint64_t height, uint256* mix_hash = nullptr);
+
+/** As above, with an explicit epoch context (which must match height's epoch). */
+uint256 hash(const EpochContext& context, const uint256& header_hash, uint64_t nonce, uint64_t height, uint256* mix_hash = nullptr);
+
+/** As above, reusing a prepared seed state across nonces. */
+uint256 hash(const EpochContext& context, const SeedHasher& hasher, uint64_t nonce, uint64_t height, uint256* mix_hash = nullptr);
+
+/**
+ * Recompute only the final Keccak pass from a claimed mix digest. This is two
+ * Keccak-f[800] permutations and no DAG access: a cheap filter that rejects
+ * bogus solutions, but a passing result still needs hash() to prove the mix.
  */
-uint256 hash(const uint256& header_hash, uint64_t nonce, uint64_t height);
+uint256 hash_light(const uint256& header_hash, uint64_t nonce, const uint256& mix_hash);
+uint256 hash_light(const SeedHasher& hasher, uint64_t nonce, const uint256& mix_hash);
 
 } // namespace progpow
 
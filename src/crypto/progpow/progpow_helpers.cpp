@@ -0,0 +1,234 @@
+// Ethash light cache and DAG item generation for KawPoW verification.
+
+#include <crypto/progpow/progpow.hpp>
+#include <crypto/common.h>
+#include <crypto/keccak.h>
+
+#include <algorithm>
+#include <future>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string.h>
+
+namespace progpow {
+
+namespace {
+
+const int LIGHT_CACHE_ITEM_SIZE = 64;
+const int FULL_DATASET_ITEM_SIZE = 128;
+const uint64_t LIGHT_CACHE_INIT_SIZE = 1 << 24;
+const uint64_t LIGHT_CACHE_GROWTH = 1 << 17;
+const int LIGHT_CACHE_ROUNDS = 3;
+const uint64_t FULL_DATASET_INIT_SIZE = 1 << 30;
+const uint64_t FULL_DATASET_GROWTH = 1 << 23;
+const int FULL_DATASET_ITEM_PARENTS = 256;
+
+const uint32_t FNV_PRIME = 0x01000193;
+
+inline uint32_t fnv1(uint32_t u, uint32_t v) { return (u * FNV_PRIME) ^ v; }
+
+bool IsOddPrime(uint64_t number)
+{
+    for (uint64_t d = 3; d * d <= number; d += 2) {
+        if (number % d == 0) return false;
+    }
+    return true;
+}
+
+uint64_t FindLargestPrime(uint64_t upper_bound)
+{
+    uint64_t n = upper_bound;
+    if (n < 2) return 0;
+    if (n == 2) return 2;
+    if (n % 2 == 0) --n;
+    while (!IsOddPrime(n)) n -= 2;
+    return n;
+}
+
+/** Keccak-512 of a 64-byte item held as 16 little-endian words, in place. */
+void Keccak512Words(uint32_t words[16])
+{
+    unsigned char buf[64];
+    for (int i = 0; i < 16; ++i) WriteLE32(buf + 4 * i, words[i]);
+    Keccak512(buf, sizeof(buf), buf);
+    for (int i = 0; i < 16; ++i) words[i] = ReadLE32(buf + 4 * i);
+}
+
+void BuildLightCache(uint32_t* cache, uint64_t num_items, const uint256& seed)
+{
+    unsigned char item[64];
+    Keccak512(seed.begin(), seed.size(), item);
+    for (int j = 0; j < 16; ++j) cache[j] = ReadLE32(item + 4 * j);
+    for (uint64_t i = 1; i < num_items; ++i) {
+        uint32_t* dst = cache + 16 * i;
+        memcpy(dst, dst - 16, LIGHT_CACHE_ITEM_SIZE);
+        Keccak512Words(dst);
+    }
+
+    for (int q = 0; q < LIGHT_CACHE_ROUNDS; ++q) {
+        for (uint64_t i = 0; i < num_items; ++i) {
+            const uint32_t index_limit = (uint32_t)num_items;
+            const uint32_t v = cache[16 * i] % index_limit;
+            const uint32_t w = (uint32_t)((num_items + i - 1) % index_limit);
+            uint32_t* dst = cache + 16 * i;
+            for (int j = 0; j < 16; ++j) dst[j] = cache[16 * v + j] ^ cache[16 * w + j];
+            Keccak512Words(dst);
+        }
+    }
+}
+
+/** One 512-bit DAG item under construction; see the ethash spec's calc_dataset_item. */
+class ItemState
+{
+private:
+    const uint32_t* const cache;
+    const uint32_t num_cache_items;
+    const uint32_t seed;
+    uint32_t mix[16];
+
+public:
+    ItemState(const EpochContext& context, int64_t index)
+        : cache(context.light_cache.data()), num_cache_items((uint32_t)context.light_cache_num_items), seed((uint32_t)index)
+    {
+        memcpy(mix, cache + 16 * (index % num_cache_items), sizeof(mix));
+        mix[0] ^= seed;
+        Keccak512Words(mix);
+    }
+
+    void Update(uint32_t round)
+    {
+        const uint32_t t = fnv1(seed ^ round, mix[round % 16]);
+        const uint32_t* parent = cache + 16 * (t % num_cache_items);
+        for (int j = 0; j < 16; ++j) mix[j] = fnv1(mix[j], parent[j]);
+    }
+
+    void Final(uint32_t out[16])
+    {
+        memcpy(out, mix, sizeof(mix));
+        Keccak512Words(out);
+    }
+};
+
+/** LRU of recently used epoch contexts, most recent first. */
+std::mutex cs_epoch_contexts;
+std::list<std::shared_ptr<const EpochContext>> epoch_contexts;
+/** Contexts being built by GetEpochContext(), which does so without holding cs_epoch_contexts. */
+std::map<int, std::shared_future<std::shared_ptr<const EpochContext>>> epoch_contexts_building;
+
+} // namespace
+
+int GetEpochNumber(uint64_t height)
+{
+    return (int)(height / EPOCH_LENGTH);
+}
+
+uint64_t GetLightCacheNumItems(int epoch_number)
+{
+    const uint64_t num_items_init = LIGHT_CACHE_INIT_SIZE / LIGHT_CACHE_ITEM_SIZE;
+    const uint64_t num_items_growth = LIGHT_CACHE_GROWTH / LIGHT_CACHE_ITEM_SIZE;
+    return FindLargestPrime(num_items_init + (uint64_t)epoch_number * num_items_growth);
+}
+
+uint64_t GetFullDatasetNumItems(int epoch_number)
+{
+    const uint64_t num_items_init = FULL_DATASET_INIT_SIZE / FULL_DATASET_ITEM_SIZE;
+    const uint64_t num_items_growth = FULL_DATASET_GROWTH / FULL_DATASET_ITEM_SIZE;
+    return FindLargestPrime(num_items_init + (uint64_t)epoch_number * num_items_growth);
+}
+
+uint256 GetEpochSeed(int epoch_number)
+{
+    uint256 seed;
+    for (int i = 0; i < epoch_number; ++i) {
+        Keccak256(seed.begin(), seed.size(), seed.begin());
+    }
+    return seed;
+}
+
+void CalculateDatasetItem2048(const EpochContext& context, uint32_t index, uint32_t item[64])
+{
+    ItemState item0(context, int64_t(index) * 4);
+    ItemState item1(context, int64_t(index) * 4 + 1);
+    ItemState item2(context, int64_t(index) * 4 + 2);
+    ItemState item3(context, int64_t(index) * 4 + 3);
+
+    for (uint32_t j = 0; j < FULL_DATASET_ITEM_PARENTS; ++j) {
+        item0.Update(j);
+        item1.Update(j);
+        item2.Update(j);
+        item3.Update(j);
+    }
+
+    item0.Final(item);
+    item1.Final(item + 16);
+    item2.Final(item + 32);
+    item3.Final(item + 48);
+}
+
+std::shared_ptr<const EpochContext> CreateEpochContext(int epoch_number)
+{
+    std::shared_ptr<EpochContext> context = std::make_shared<EpochContext>();
+    context->epoch_number = epoch_number;
+    context->light_cache_num_items = GetLightCacheNumItems(epoch_number);
+    context->full_dataset_num_items = GetFullDatasetNumItems(epoch_number);
+    context->light_cache.resize((size_t)context->light_cache_num_items * 16);
+    BuildLightCache(context->light_cache.data(), context->light_cache_num_items, GetEpochSeed(epoch_number));
+
+    context->l1_cache.resize(L1_CACHE_NUM_ITEMS);
+    for (uint32_t i = 0; i < L1_CACHE_NUM_ITEMS / 64; ++i) {
+        CalculateDatasetItem2048(*context, i, context->l1_cache.data() + 64 * i);
+    }
+    return context;
+}
+
+std::shared_ptr<const EpochContext> GetEpochContext(int epoch_number)
+{
+    std::promise<std::shared_ptr<const EpochContext>> promise;
+    std::shared_future<std::shared_ptr<const EpochContext>> building;
+    {
+        std::lock_guard<std::mutex> lock(cs_epoch_contexts);
+        for (auto it = epoch_contexts.begin(); it != epoch_contexts.end(); ++it) {
+            if ((*it)->epoch_number == epoch_number) {
+                epoch_contexts.splice(epoch_contexts.begin(), epoch_contexts, it);
+                return epoch_contexts.front();
+            }
+        }
+        auto it = epoch_contexts_building.find(epoch_number);
+        if (it != epoch_contexts_building.end()) {
+            building = it->second;
+        } else {
+            epoch_contexts_building.emplace(epoch_number, promise.get_future().share());
+        }
+    }
+    // Concurrent verifiers almost always want the same epoch, so the first
+    // one builds it and the others wait for that build.
+    if (building.valid()) {
+        return building.get();
+    }
+
+    // Built without the lock, so lookups of other epochs are not held up
+    std::shared_ptr<const EpochContext> context;
+    try {
+        context = CreateEpochContext(epoch_number);
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> lock(cs_epoch_contexts);
+            epoch_contexts_building.erase(epoch_number);
+        }
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+    {
+        std::lock_guard<std::mutex> lock(cs_epoch_contexts);
+        epoch_contexts_building.erase(epoch_number);
+        epoch_contexts.push_front(context);
+        if (epoch_contexts.size() > MAX_CACHED_EPOCHS) {
+            epoch_contexts.pop_back();
+        }
+    }
+    promise.set_value(context);
+    return context;
+}
+
+} // namespace progpow
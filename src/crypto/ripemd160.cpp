@@ -6,8 +6,20 @@
 
 #include <crypto/common.h>
 
+#include <assert.h>
 #include <string.h>
 
+#if defined(__x86_64__) || defined(__amd64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+#if defined(ENABLE_AVX2)
+namespace ripemd160_avx2
+{
+void Transform_8way(uint32_t* s, const unsigned char* chunks);
+}
+#endif
+
 // Internal implementation code.
 namespace
 {
@@ -235,8 +247,64 @@ void Transform(uint32_t* s, const unsigned char* chunk)
 
 } // namespace ripemd160
 
+/** Process one 64-byte chunk for each of 8 states stored back to back. */
+typedef void (*Transform8Type)(uint32_t*, const unsigned char*);
+Transform8Type Transform_8way = nullptr;
+
+/** Check an 8-lane block transform against the generic code. */
+bool SelfTest8way(Transform8Type tr)
+{
+    unsigned char in[64 * 8];
+    uint32_t s[5 * 8];
+    uint32_t expected[5];
+    for (size_t i = 0; i < sizeof(in); i++) {
+        in[i] = (unsigned char)(i * 197 + (i >> 6));
+    }
+    for (int i = 0; i < 5 * 8; i++) {
+        s[i] = 0x9e3779b9ul * (i + 1);
+    }
+    tr(s, in);
+    for (int i = 0; i < 8; i++) {
+        for (int j = 0; j < 5; j++) expected[j] = 0x9e3779b9ul * (5 * i + j + 1);
+        ripemd160::Transform(expected, in + 64 * i);
+        if (memcmp(s + 5 * i, expected, sizeof(expected))) return false;
+    }
+    return true;
+}
+
+#if defined(__x86_64__) || defined(__amd64__) || defined(__i386__)
+/** Whether the OS saves the AVX (YMM) registers on context switches. */
+bool AVXEnabled()
+{
+    uint32_t a, d;
+    __asm__("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+    return (a & 6) == 6;
+}
+#endif
+
 } // namespace
 
+std::string RIPEMD160AutoDetect()
+{
+#if defined(__x86_64__) || defined(__amd64__) || defined(__i386__)
+    uint32_t eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return "standard";
+    const bool enabled_avx = ((ecx >> 27) & 1) && ((ecx >> 28) & 1) && AVXEnabled();
+#if defined(ENABLE_AVX2)
+    if (enabled_avx && __get_cpuid_max(0, nullptr) >= 7) {
+        __cpuid_count(7, 0, eax, ebx, ecx, edx);
+        if ((ebx >> 5) & 1) {
+            assert(SelfTest8way(ripemd160_avx2::Transform_8way));
+            Transform_8way = ripemd160_avx2::Transform_8way;
+            return "avx2(8way)";
+        }
+    }
+#endif
+    (void)enabled_avx;
+#endif
+    return "standard";
+}
+
 ////// RIPEMD160
 
 CRIPEMD160::CRIPEMD160() : bytes(0)
@@ -290,3 +358,29 @@ CRIPEMD160& CRIPEMD160::Reset()
     ripemd160::Initialize(s);
     return *this;
 }
+
+void RIPEMD160_32(unsigned char* output, const unsigned char* input, size_t n)
+{
+    if (Transform_8way) {
+        // A 32-byte message always pads to a single block.
+        unsigned char chunks[64 * 8] = {};
+        uint32_t s[5 * 8];
+        for (int j = 0; j < 8; j++) {
+            chunks[64 * j + 32] = 0x80;
+            WriteLE64(chunks + 64 * j + 56, 32 << 3);
+        }
+        for (; n >= 8; n -= 8, input += 256, output += 160) {
+            for (int j = 0; j < 8; j++) {
+                memcpy(chunks + 64 * j, input + 32 * j, 32);
+                ripemd160::Initialize(s + 5 * j);
+            }
+            Transform_8way(s, chunks);
+            for (int j = 0; j < 8; j++) {
+                for (int i = 0; i < 5; i++) WriteLE32(output + 20 * j + 4 * i, s[5 * j + i]);
+            }
+        }
+    }
+    for (; n > 0; --n, input += 32, output += 20) {
+        CRIPEMD160().Write(input, 32).Finalize(output);
+    }
+}
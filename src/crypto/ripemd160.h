@@ -7,6 +7,7 @@
 
 #include <stdint.h>
 #include <stdlib.h>
+#include <string>
 
 /** A hasher class for RIPEMD-160. */
 class CRIPEMD160
@@ -25,4 +26,12 @@ public:
     CRIPEMD160& Reset();
 };
 
+/** Autodetect the best available multi-lane RIPEMD-160 implementation. Returns its name. */
+std::string RIPEMD160AutoDetect();
+
+/** Compute the RIPEMD-160's of n consecutive 32-byte inputs (as in HASH160)
+ *  into n consecutive 20-byte outputs, 8 at a time when possible.
+ */
+void RIPEMD160_32(unsigned char* output, const unsigned char* input, size_t n);
+
 #endif // BITCOIN_CRYPTO_RIPEMD160_H
@@ -32,16 +32,36 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
+#include <memory>
 #include <openssl/sha.h>
 
-#if defined(USE_SSE2) && !defined(USE_SSE2_ALWAYS)
 #ifdef _MSC_VER
 // MSVC 64bit is unable to use inline asm
 #include <intrin.h>
-#else
+#elif defined(__x86_64__) || defined(__amd64__) || defined(__i386__)
 // GCC Linux or i686-w64-mingw32
 #include <cpuid.h>
 #endif
+
+#if defined(ENABLE_SSE41)
+namespace scrypt_sse41
+{
+void scrypt_1024_1_1_256_4way(const char *input, char *output, uint32_t *V);
+}
+#endif
+
+#if defined(ENABLE_AVX2)
+namespace scrypt_avx2
+{
+void scrypt_1024_1_1_256_8way(const char *input, char *output, uint32_t *V);
+}
+#endif
+
+#if defined(ENABLE_AVX512)
+namespace scrypt_avx512
+{
+void scrypt_1024_1_1_256_16way(const char *input, char *output, uint32_t *V);
+}
 #endif
 #ifndef __FreeBSD__
 static inline uint32_t be32dec(const void *pp)
@@ -288,14 +308,75 @@ void scrypt_1024_1_1_256_sp_generic(const char *input, char *output, char *scrat
 }
 
 #if defined(USE_SSE2)
-// By default, set to generic scrypt function. This will prevent crash in case when scrypt_detect_sse2() wasn't called
+// By default, set to generic scrypt function. This will prevent crash in case when scrypt_detect() wasn't called
 void (*scrypt_1024_1_1_256_sp_detected)(const char *input, char *output, char *scratchpad) = &scrypt_1024_1_1_256_sp_generic;
+#endif
+
+/* Multi-lane kernel: hashes nMultiLanes inputs using a scratchpad of 128KiB per lane. */
+typedef void (*scrypt_multi_type)(const char *input, char *output, uint32_t *V);
+static scrypt_multi_type scrypt_multi_kernel = nullptr;
+static size_t nMultiLanes = 1;
+
+#if (defined(__x86_64__) || defined(__amd64__) || defined(__i386__)) && !defined(_MSC_VER)
+/* The OS state components enabled in XCR0. */
+static uint32_t scrypt_xgetbv()
+{
+	uint32_t a, d;
+	__asm__("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+	return a;
+}
+
+static std::string scrypt_detect_multi()
+{
+	uint32_t eax, ebx, ecx, edx;
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+		return "none";
+	const bool have_sse41 = (ecx >> 19) & 1;
+	const uint32_t xcr0 = ((ecx >> 27) & 1) ? scrypt_xgetbv() : 0;
+	uint32_t ebx7 = 0;
+	if (__get_cpuid_max(0, nullptr) >= 7) {
+		__cpuid_count(7, 0, eax, ebx7, ecx, edx);
+	}
+#if defined(ENABLE_AVX512)
+	/* AVX-512F, with the OS saving the YMM, opmask and ZMM state */
+	if (((ebx7 >> 16) & 1) && (xcr0 & 0xe6) == 0xe6) {
+		scrypt_multi_kernel = &scrypt_avx512::scrypt_1024_1_1_256_16way;
+		nMultiLanes = 16;
+		return "avx512(16way)";
+	}
+#endif
+#if defined(ENABLE_AVX2)
+	if (((ebx7 >> 5) & 1) && (xcr0 & 0x6) == 0x6) {
+		scrypt_multi_kernel = &scrypt_avx2::scrypt_1024_1_1_256_8way;
+		nMultiLanes = 8;
+		return "avx2(8way)";
+	}
+#endif
+#if defined(ENABLE_SSE41)
+	if (have_sse41) {
+		scrypt_multi_kernel = &scrypt_sse41::scrypt_1024_1_1_256_4way;
+		nMultiLanes = 4;
+		return "sse4(4way)";
+	}
+#endif
+	(void)have_sse41;
+	(void)xcr0;
+	(void)ebx7;
+	return "none";
+}
+#else
+static std::string scrypt_detect_multi()
+{
+	return "none";
+}
+#endif
 
-std::string scrypt_detect_sse2()
+std::string scrypt_detect()
 {
     std::string ret;
+#if defined(USE_SSE2)
 #if defined(USE_SSE2_ALWAYS)
-    ret = "scrypt: using scrypt-sse2 as built.";
+    ret = "scrypt: using scrypt-sse2 as built";
 #else // USE_SSE2_ALWAYS
     // 32bit x86 Linux or Windows, detect cpuid features
     unsigned int cpuid_edx=0;
@@ -321,9 +402,33 @@ std::string scrypt_detect_sse2()
         ret = "scrypt: using scrypt-generic, SSE2 unavailable";
     }
 #endif // USE_SSE2_ALWAYS
-    return ret;
+#else // USE_SSE2
+    ret = "scrypt: using scrypt-generic";
+#endif // USE_SSE2
+    return ret + ", multi-lane: " + scrypt_detect_multi();
+}
+
+size_t scrypt_multi_lanes()
+{
+	return nMultiLanes;
+}
+
+void scrypt_1024_1_1_256_multi(const char *input, char *output, size_t count)
+{
+	if (scrypt_multi_kernel && count >= nMultiLanes) {
+		std::unique_ptr<uint32_t[]> V(new uint32_t[1024 * 32 * nMultiLanes]);
+		for (; count >= nMultiLanes; count -= nMultiLanes) {
+			scrypt_multi_kernel(input, output, V.get());
+			input += 80 * nMultiLanes;
+			output += 32 * nMultiLanes;
+		}
+	}
+	for (; count > 0; --count) {
+		scrypt_1024_1_1_256(input, output);
+		input += 80;
+		output += 32;
+	}
 }
-#endif
 
 void scrypt_1024_1_1_256(const char *input, char *output)
 {
@@ -0,0 +1,107 @@
+// Copyright (c) 2024 The NoteCoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+//
+// Eight independent scrypt(1024, 1, 1) hashes with AVX2. Lane l of every
+// vector belongs to hash l, so salsa20/8 runs on all eight at once without
+// any shuffles; only the data-dependent scratchpad reads need a gather.
+
+#ifdef ENABLE_AVX2
+
+#include <crypto/scrypt.h>
+
+#include <stdint.h>
+#include <string.h>
+#include <immintrin.h>
+
+namespace scrypt_avx2 {
+namespace {
+
+__m256i inline Add(__m256i x, __m256i y) { return _mm256_add_epi32(x, y); }
+__m256i inline Xor(__m256i x, __m256i y) { return _mm256_xor_si256(x, y); }
+template <int n>
+__m256i inline Rotl(__m256i x) { return _mm256_or_si256(_mm256_slli_epi32(x, n), _mm256_srli_epi32(x, 32 - n)); }
+
+/** a ^= ROTL(b + c, n) */
+template <int n>
+void inline Step(__m256i& a, __m256i b, __m256i c) { a = Xor(a, Rotl<n>(Add(b, c))); }
+
+void inline XorSalsa8(__m256i B[16], const __m256i Bx[16])
+{
+    __m256i x[16];
+    for (int i = 0; i < 16; ++i) {
+        x[i] = B[i] = Xor(B[i], Bx[i]);
+    }
+    for (int i = 0; i < 8; i += 2) {
+        /* Operate on columns. */
+        Step<7>(x[4], x[0], x[12]);   Step<7>(x[9], x[5], x[1]);
+        Step<7>(x[14], x[10], x[6]);  Step<7>(x[3], x[15], x[11]);
+        Step<9>(x[8], x[4], x[0]);    Step<9>(x[13], x[9], x[5]);
+        Step<9>(x[2], x[14], x[10]);  Step<9>(x[7], x[3], x[15]);
+        Step<13>(x[12], x[8], x[4]);  Step<13>(x[1], x[13], x[9]);
+        Step<13>(x[6], x[2], x[14]);  Step<13>(x[11], x[7], x[3]);
+        Step<18>(x[0], x[12], x[8]);  Step<18>(x[5], x[1], x[13]);
+        Step<18>(x[10], x[6], x[2]);  Step<18>(x[15], x[11], x[7]);
+
+        /* Operate on rows. */
+        Step<7>(x[1], x[0], x[3]);    Step<7>(x[6], x[5], x[4]);
+        Step<7>(x[11], x[10], x[9]);  Step<7>(x[12], x[15], x[14]);
+        Step<9>(x[2], x[1], x[0]);    Step<9>(x[7], x[6], x[5]);
+        Step<9>(x[8], x[11], x[10]);  Step<9>(x[13], x[12], x[15]);
+        Step<13>(x[3], x[2], x[1]);   Step<13>(x[4], x[7], x[6]);
+        Step<13>(x[9], x[8], x[11]);  Step<13>(x[14], x[13], x[12]);
+        Step<18>(x[0], x[3], x[2]);   Step<18>(x[5], x[4], x[7]);
+        Step<18>(x[10], x[9], x[8]);  Step<18>(x[15], x[14], x[13]);
+    }
+    for (int i = 0; i < 16; ++i) {
+        B[i] = Add(B[i], x[i]);
+    }
+}
+
+} // namespace
+
+void scrypt_1024_1_1_256_8way(const char* input, char* output, uint32_t* V)
+{
+    static const int LANES = 8;
+    uint8_t B[LANES][128];
+    uint32_t words[LANES];
+    __m256i X[32];
+
+    for (int l = 0; l < LANES; ++l) {
+        PBKDF2_SHA256((const uint8_t*)input + 80 * l, 80, (const uint8_t*)input + 80 * l, 80, 1, B[l], 128);
+    }
+    for (int k = 0; k < 32; ++k) {
+        for (int l = 0; l < LANES; ++l) words[l] = le32dec(&B[l][4 * k]);
+        X[k] = _mm256_loadu_si256((const __m256i*)words);
+    }
+
+    __m256i* Vv = (__m256i*)V;
+    for (int i = 0; i < 1024; ++i) {
+        for (int k = 0; k < 32; ++k) _mm256_storeu_si256(&Vv[i * 32 + k], X[k]);
+        XorSalsa8(&X[0], &X[16]);
+        XorSalsa8(&X[16], &X[0]);
+    }
+    // Word k of lane l's block j lives at V[(32 * j + k) * LANES + l]
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i mask = _mm256_set1_epi32(1023);
+    for (int i = 0; i < 1024; ++i) {
+        const __m256i index = Add(_mm256_slli_epi32(_mm256_and_si256(X[16], mask), 8), lanes);
+        for (int k = 0; k < 32; ++k) {
+            X[k] = Xor(X[k], _mm256_i32gather_epi32((const int*)(V + k * LANES), index, 4));
+        }
+        XorSalsa8(&X[0], &X[16]);
+        XorSalsa8(&X[16], &X[0]);
+    }
+
+    for (int k = 0; k < 32; ++k) {
+        _mm256_storeu_si256((__m256i*)words, X[k]);
+        for (int l = 0; l < LANES; ++l) le32enc(&B[l][4 * k], words[l]);
+    }
+    for (int l = 0; l < LANES; ++l) {
+        PBKDF2_SHA256((const uint8_t*)input + 80 * l, 80, B[l], 128, 1, (uint8_t*)output + 32 * l, 32);
+    }
+}
+
+} // namespace scrypt_avx2
+
+#endif
@@ -0,0 +1,107 @@
+// Copyright (c) 2024 The NoteCoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+//
+// Sixteen independent scrypt(1024, 1, 1) hashes with AVX-512F. Lane l of every
+// vector belongs to hash l, so salsa20/8 runs on all sixteen at once without
+// any shuffles; only the data-dependent scratchpad reads need a gather.
+
+#ifdef ENABLE_AVX512
+
+#include <crypto/scrypt.h>
+
+#include <stdint.h>
+#include <string.h>
+#include <immintrin.h>
+
+namespace scrypt_avx512 {
+namespace {
+
+__m512i inline Add(__m512i x, __m512i y) { return _mm512_add_epi32(x, y); }
+__m512i inline Xor(__m512i x, __m512i y) { return _mm512_xor_si512(x, y); }
+template <int n>
+__m512i inline Rotl(__m512i x) { return _mm512_rol_epi32(x, n); }
+
+/** a ^= ROTL(b + c, n) */
+template <int n>
+void inline Step(__m512i& a, __m512i b, __m512i c) { a = Xor(a, Rotl<n>(Add(b, c))); }
+
+void inline XorSalsa8(__m512i B[16], const __m512i Bx[16])
+{
+    __m512i x[16];
+    for (int i = 0; i < 16; ++i) {
+        x[i] = B[i] = Xor(B[i], Bx[i]);
+    }
+    for (int i = 0; i < 8; i += 2) {
+        /* Operate on columns. */
+        Step<7>(x[4], x[0], x[12]);   Step<7>(x[9], x[5], x[1]);
+        Step<7>(x[14], x[10], x[6]);  Step<7>(x[3], x[15], x[11]);
+        Step<9>(x[8], x[4], x[0]);    Step<9>(x[13], x[9], x[5]);
+        Step<9>(x[2], x[14], x[10]);  Step<9>(x[7], x[3], x[15]);
+        Step<13>(x[12], x[8], x[4]);  Step<13>(x[1], x[13], x[9]);
+        Step<13>(x[6], x[2], x[14]);  Step<13>(x[11], x[7], x[3]);
+        Step<18>(x[0], x[12], x[8]);  Step<18>(x[5], x[1], x[13]);
+        Step<18>(x[10], x[6], x[2]);  Step<18>(x[15], x[11], x[7]);
+
+        /* Operate on rows. */
+        Step<7>(x[1], x[0], x[3]);    Step<7>(x[6], x[5], x[4]);
+        Step<7>(x[11], x[10], x[9]);  Step<7>(x[12], x[15], x[14]);
+        Step<9>(x[2], x[1], x[0]);    Step<9>(x[7], x[6], x[5]);
+        Step<9>(x[8], x[11], x[10]);  Step<9>(x[13], x[12], x[15]);
+        Step<13>(x[3], x[2], x[1]);   Step<13>(x[4], x[7], x[6]);
+        Step<13>(x[9], x[8], x[11]);  Step<13>(x[14], x[13], x[12]);
+        Step<18>(x[0], x[3], x[2]);   Step<18>(x[5], x[4], x[7]);
+        Step<18>(x[10], x[9], x[8]);  Step<18>(x[15], x[14], x[13]);
+    }
+    for (int i = 0; i < 16; ++i) {
+        B[i] = Add(B[i], x[i]);
+    }
+}
+
+} // namespace
+
+void scrypt_1024_1_1_256_16way(const char* input, char* output, uint32_t* V)
+{
+    static const int LANES = 16;
+    uint8_t B[LANES][128];
+    uint32_t words[LANES];
+    __m512i X[32];
+
+    for (int l = 0; l < LANES; ++l) {
+        PBKDF2_SHA256((const uint8_t*)input + 80 * l, 80, (const uint8_t*)input + 80 * l, 80, 1, B[l], 128);
+    }
+    for (int k = 0; k < 32; ++k) {
+        for (int l = 0; l < LANES; ++l) words[l] = le32dec(&B[l][4 * k]);
+        X[k] = _mm512_loadu_si512(words);
+    }
+
+    __m512i* Vv = (__m512i*)V;
+    for (int i = 0; i < 1024; ++i) {
+        for (int k = 0; k < 32; ++k) _mm512_storeu_si512(&Vv[i * 32 + k], X[k]);
+        XorSalsa8(&X[0], &X[16]);
+        XorSalsa8(&X[16], &X[0]);
+    }
+    // Word k of lane l's block j lives at V[(32 * j + k) * LANES + l]
+    const __m512i lanes = _mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    const __m512i mask = _mm512_set1_epi32(1023);
+    for (int i = 0; i < 1024; ++i) {
+        const __m512i index = Add(_mm512_slli_epi32(_mm512_and_si512(X[16], mask), 9), lanes);
+        for (int k = 0; k < 32; ++k) {
+            X[k] = Xor(X[k], _mm512_i32gather_epi32(index, (const int*)(V + k * LANES), 4));
+        }
+        XorSalsa8(&X[0], &X[16]);
+        XorSalsa8(&X[16], &X[0]);
+    }
+
+    for (int k = 0; k < 32; ++k) {
+        _mm512_storeu_si512(words, X[k]);
+        for (int l = 0; l < LANES; ++l) le32enc(&B[l][4 * k], words[l]);
+    }
+    for (int l = 0; l < LANES; ++l) {
+        PBKDF2_SHA256((const uint8_t*)input + 80 * l, 80, B[l], 128, 1, (uint8_t*)output + 32 * l, 32);
+    }
+}
+
+} // namespace scrypt_avx512
+
+#endif
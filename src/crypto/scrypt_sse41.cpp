@@ -0,0 +1,108 @@
+// Copyright (c) 2024 The NoteCoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+//
+// Four independent scrypt(1024, 1, 1) hashes with SSE4.1. Lane l of every
+// vector belongs to hash l, so salsa20/8 runs on all four at once without
+// any shuffles; only the data-dependent scratchpad reads are per lane.
+
+#ifdef ENABLE_SSE41
+
+#include <crypto/scrypt.h>
+
+#include <stdint.h>
+#include <string.h>
+#include <immintrin.h>
+
+namespace scrypt_sse41 {
+namespace {
+
+__m128i inline Add(__m128i x, __m128i y) { return _mm_add_epi32(x, y); }
+__m128i inline Xor(__m128i x, __m128i y) { return _mm_xor_si128(x, y); }
+template <int n>
+__m128i inline Rotl(__m128i x) { return _mm_or_si128(_mm_slli_epi32(x, n), _mm_srli_epi32(x, 32 - n)); }
+
+/** a ^= ROTL(b + c, n) */
+template <int n>
+void inline Step(__m128i& a, __m128i b, __m128i c) { a = Xor(a, Rotl<n>(Add(b, c))); }
+
+void inline XorSalsa8(__m128i B[16], const __m128i Bx[16])
+{
+    __m128i x[16];
+    for (int i = 0; i < 16; ++i) {
+        x[i] = B[i] = Xor(B[i], Bx[i]);
+    }
+    for (int i = 0; i < 8; i += 2) {
+        /* Operate on columns. */
+        Step<7>(x[4], x[0], x[12]);   Step<7>(x[9], x[5], x[1]);
+        Step<7>(x[14], x[10], x[6]);  Step<7>(x[3], x[15], x[11]);
+        Step<9>(x[8], x[4], x[0]);    Step<9>(x[13], x[9], x[5]);
+        Step<9>(x[2], x[14], x[10]);  Step<9>(x[7], x[3], x[15]);
+        Step<13>(x[12], x[8], x[4]);  Step<13>(x[1], x[13], x[9]);
+        Step<13>(x[6], x[2], x[14]);  Step<13>(x[11], x[7], x[3]);
+        Step<18>(x[0], x[12], x[8]);  Step<18>(x[5], x[1], x[13]);
+        Step<18>(x[10], x[6], x[2]);  Step<18>(x[15], x[11], x[7]);
+
+        /* Operate on rows. */
+        Step<7>(x[1], x[0], x[3]);    Step<7>(x[6], x[5], x[4]);
+        Step<7>(x[11], x[10], x[9]);  Step<7>(x[12], x[15], x[14]);
+        Step<9>(x[2], x[1], x[0]);    Step<9>(x[7], x[6], x[5]);
+        Step<9>(x[8], x[11], x[10]);  Step<9>(x[13], x[12], x[15]);
+        Step<13>(x[3], x[2], x[1]);   Step<13>(x[4], x[7], x[6]);
+        Step<13>(x[9], x[8], x[11]);  Step<13>(x[14], x[13], x[12]);
+        Step<18>(x[0], x[3], x[2]);   Step<18>(x[5], x[4], x[7]);
+        Step<18>(x[10], x[9], x[8]);  Step<18>(x[15], x[14], x[13]);
+    }
+    for (int i = 0; i < 16; ++i) {
+        B[i] = Add(B[i], x[i]);
+    }
+}
+
+} // namespace
+
+void scrypt_1024_1_1_256_4way(const char* input, char* output, uint32_t* V)
+{
+    static const int LANES = 4;
+    uint8_t B[LANES][128];
+    uint32_t words[LANES];
+    __m128i X[32];
+
+    for (int l = 0; l < LANES; ++l) {
+        PBKDF2_SHA256((const uint8_t*)input + 80 * l, 80, (const uint8_t*)input + 80 * l, 80, 1, B[l], 128);
+    }
+    for (int k = 0; k < 32; ++k) {
+        for (int l = 0; l < LANES; ++l) words[l] = le32dec(&B[l][4 * k]);
+        X[k] = _mm_loadu_si128((const __m128i*)words);
+    }
+
+    __m128i* Vv = (__m128i*)V;
+    for (int i = 0; i < 1024; ++i) {
+        for (int k = 0; k < 32; ++k) _mm_storeu_si128(&Vv[i * 32 + k], X[k]);
+        XorSalsa8(&X[0], &X[16]);
+        XorSalsa8(&X[16], &X[0]);
+    }
+    // Word k of lane l's block j lives at V[(32 * j + k) * LANES + l]
+    uint32_t index[LANES];
+    for (int i = 0; i < 1024; ++i) {
+        _mm_storeu_si128((__m128i*)words, X[16]);
+        for (int l = 0; l < LANES; ++l) index[l] = 32 * LANES * (words[l] & 1023) + l;
+        for (int k = 0; k < 32; ++k) {
+            const uint32_t* Vk = V + k * LANES;
+            X[k] = Xor(X[k], _mm_setr_epi32(Vk[index[0]], Vk[index[1]], Vk[index[2]], Vk[index[3]]));
+        }
+        XorSalsa8(&X[0], &X[16]);
+        XorSalsa8(&X[16], &X[0]);
+    }
+
+    for (int k = 0; k < 32; ++k) {
+        _mm_storeu_si128((__m128i*)words, X[k]);
+        for (int l = 0; l < LANES; ++l) le32enc(&B[l][4 * k], words[l]);
+    }
+    for (int l = 0; l < LANES; ++l) {
+        PBKDF2_SHA256((const uint8_t*)input + 80 * l, 80, B[l], 128, 1, (uint8_t*)output + 32 * l, 32);
+    }
+}
+
+} // namespace scrypt_sse41
+
+#endif
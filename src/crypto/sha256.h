@@ -31,4 +31,20 @@ public:
  */
 std::string SHA256AutoDetect();
 
+/** Compute multiple double-SHA256's of 64-byte blobs.
+ *  output:  pointer to a blocks*32 byte output buffer
+ *  input:   pointer to a blocks*64 byte input buffer
+ *  blocks:  the number of hashes to compute.
+ */
+void SHA256D64(unsigned char* output, const unsigned char* input, size_t blocks);
+
+/** Compute the SHA256's of n independent messages, 8 at a time when a
+ *  multi-lane implementation is available. Meant for many short inputs
+ *  such as public keys and scripts.
+ *  output:  pointer to a n*32 byte output buffer
+ *  inputs:  pointers to the n messages
+ *  lengths: the byte lengths of the n messages
+ */
+void SHA256Batch(unsigned char* output, const unsigned char* const* inputs, const size_t* lengths, size_t n);
+
 #endif // BITCOIN_CRYPTO_SHA256_H
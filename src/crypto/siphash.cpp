@@ -0,0 +1,135 @@
+// Copyright (c) 2024 The NoteCoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <crypto/siphash.h>
+#include <crypto/common.h>
+
+#include <assert.h>
+
+#if defined(__x86_64__) || defined(__amd64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+#if defined(ENABLE_AVX2)
+namespace siphash_avx2
+{
+void SipHash_4way(uint64_t k0, uint64_t k1, const unsigned char* const* inputs, const uint64_t* last, uint64_t* out);
+}
+#endif
+
+namespace
+{
+/// Internal SipHash implementation.
+namespace siphash
+{
+uint64_t inline Rol(uint64_t x, int b) { return (x << b) | (x >> (64 - b)); }
+
+void inline SipRound(uint64_t& v0, uint64_t& v1, uint64_t& v2, uint64_t& v3)
+{
+    v0 += v1; v1 = Rol(v1, 13); v1 ^= v0;
+    v0 = Rol(v0, 32);
+    v2 += v3; v3 = Rol(v3, 16); v3 ^= v2;
+    v0 += v3; v3 = Rol(v3, 21); v3 ^= v0;
+    v2 += v1; v1 = Rol(v1, 17); v1 ^= v2;
+    v2 = Rol(v2, 32);
+}
+
+/** SipHash-2-4 of a 32-byte input followed by the final (length-tagged) word last. */
+uint64_t Hash(uint64_t k0, uint64_t k1, const unsigned char* in, uint64_t last)
+{
+    uint64_t v0 = 0x736f6d6570736575ULL ^ k0;
+    uint64_t v1 = 0x646f72616e646f6dULL ^ k1;
+    uint64_t v2 = 0x6c7967656e657261ULL ^ k0;
+    uint64_t v3 = 0x7465646279746573ULL ^ k1;
+    for (int i = 0; i < 5; ++i) {
+        const uint64_t d = i < 4 ? ReadLE64(in + 8 * i) : last;
+        v3 ^= d;
+        SipRound(v0, v1, v2, v3);
+        SipRound(v0, v1, v2, v3);
+        v0 ^= d;
+    }
+    v2 ^= 0xFF;
+    SipRound(v0, v1, v2, v3);
+    SipRound(v0, v1, v2, v3);
+    SipRound(v0, v1, v2, v3);
+    SipRound(v0, v1, v2, v3);
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+/** The final word: the message length in the top byte, then the extra word if any. */
+uint64_t inline Last(const uint32_t* extras, size_t i)
+{
+    return extras ? (((uint64_t)36) << 56) | extras[i] : ((uint64_t)32) << 56;
+}
+
+} // namespace siphash
+
+typedef void (*Hash4Type)(uint64_t, uint64_t, const unsigned char* const*, const uint64_t*, uint64_t*);
+Hash4Type Hash_4way = nullptr;
+
+/** Check a 4-lane implementation against the generic code. */
+bool SelfTest(Hash4Type tr)
+{
+    unsigned char in[4][32];
+    const unsigned char* inputs[4];
+    uint64_t last[4], out[4];
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 32; ++j) in[i][j] = (unsigned char)(i * 77 + j * 13);
+        inputs[i] = in[i];
+        last[i] = (((uint64_t)36) << 56) | (0x9e3779b9ul * i);
+    }
+    tr(0x0706050403020100ULL, 0x0F0E0D0C0B0A0908ULL, inputs, last, out);
+    for (int i = 0; i < 4; ++i) {
+        if (out[i] != siphash::Hash(0x0706050403020100ULL, 0x0F0E0D0C0B0A0908ULL, in[i], last[i])) return false;
+    }
+    return true;
+}
+
+#if defined(__x86_64__) || defined(__amd64__) || defined(__i386__)
+/** Whether the OS saves the AVX (YMM) registers on context switches. */
+bool AVXEnabled()
+{
+    uint32_t a, d;
+    __asm__("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+    return (a & 6) == 6;
+}
+#endif
+
+} // namespace
+
+std::string SipHashAutoDetect()
+{
+#if defined(__x86_64__) || defined(__amd64__) || defined(__i386__)
+    uint32_t eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return "standard";
+    const bool enabled_avx = ((ecx >> 27) & 1) && ((ecx >> 28) & 1) && AVXEnabled();
+#if defined(ENABLE_AVX2)
+    if (enabled_avx && __get_cpuid_max(0, nullptr) >= 7) {
+        __cpuid_count(7, 0, eax, ebx, ecx, edx);
+        if ((ebx >> 5) & 1) {
+            assert(SelfTest(siphash_avx2::SipHash_4way));
+            Hash_4way = siphash_avx2::SipHash_4way;
+            return "avx2(4way)";
+        }
+    }
+#endif
+    (void)enabled_avx;
+#endif
+    return "standard";
+}
+
+void SipHash32Many(uint64_t k0, uint64_t k1, const unsigned char* const* inputs, const uint32_t* extras, uint64_t* out, size_t n)
+{
+    size_t i = 0;
+    if (Hash_4way) {
+        uint64_t last[4];
+        for (; i + 4 <= n; i += 4) {
+            for (int j = 0; j < 4; ++j) last[j] = siphash::Last(extras, i + j);
+            Hash_4way(k0, k1, inputs + i, last, out + i);
+        }
+    }
+    for (; i < n; ++i) {
+        out[i] = siphash::Hash(k0, k1, inputs[i], siphash::Last(extras, i));
+    }
+}
@@ -0,0 +1,22 @@
+// Copyright (c) 2024 The NoteCoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_CRYPTO_SIPHASH_H
+#define BITCOIN_CRYPTO_SIPHASH_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string>
+
+/** Autodetect the best available multi-lane SipHash implementation. Returns its name. */
+std::string SipHashAutoDetect();
+
+/**
+ * SipHash-2-4 under the key (k0, k1) of n 32-byte inputs, 4 at a time when
+ * a multi-lane implementation is active. The results match SipHashUint256,
+ * or SipHashUint256Extra if extras holds the n extra words.
+ */
+void SipHash32Many(uint64_t k0, uint64_t k1, const unsigned char* const* inputs, const uint32_t* extras, uint64_t* out, size_t n);
+
+#endif // BITCOIN_CRYPTO_SIPHASH_H
@@ -0,0 +1,64 @@
+// Copyright (c) 2024 The NoteCoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifdef ENABLE_AVX2
+
+#include <stdint.h>
+#include <immintrin.h>
+
+#include <crypto/common.h>
+
+namespace siphash_avx2 {
+namespace {
+
+__m256i inline K(uint64_t x) { return _mm256_set1_epi64x(x); }
+
+__m256i inline Add(__m256i x, __m256i y) { return _mm256_add_epi64(x, y); }
+__m256i inline Xor(__m256i x, __m256i y) { return _mm256_xor_si256(x, y); }
+__m256i inline Rol(__m256i x, int n) { return _mm256_or_si256(_mm256_slli_epi64(x, n), _mm256_srli_epi64(x, 64 - n)); }
+__m256i inline Rol16(__m256i x) { return _mm256_shuffle_epi8(x, _mm256_set_epi8(13, 12, 11, 10, 9, 8, 15, 14, 5, 4, 3, 2, 1, 0, 7, 6, 13, 12, 11, 10, 9, 8, 15, 14, 5, 4, 3, 2, 1, 0, 7, 6)); }
+__m256i inline Rol32(__m256i x) { return _mm256_shuffle_epi32(x, 0xB1); }
+
+void inline __attribute__((always_inline)) SipRound(__m256i& v0, __m256i& v1, __m256i& v2, __m256i& v3)
+{
+    v0 = Add(v0, v1); v1 = Rol(v1, 13); v1 = Xor(v1, v0);
+    v0 = Rol32(v0);
+    v2 = Add(v2, v3); v3 = Rol16(v3); v3 = Xor(v3, v2);
+    v0 = Add(v0, v3); v3 = Rol(v3, 21); v3 = Xor(v3, v0);
+    v2 = Add(v2, v1); v1 = Rol(v1, 17); v1 = Xor(v1, v2);
+    v2 = Rol32(v2);
+}
+
+/** Load 64-bit word offset/8 of 4 inputs, one per lane, little endian. */
+__m256i inline Read4(const unsigned char* const* inputs, int offset)
+{
+    return _mm256_set_epi64x(ReadLE64(inputs[3] + offset), ReadLE64(inputs[2] + offset), ReadLE64(inputs[1] + offset), ReadLE64(inputs[0] + offset));
+}
+
+}
+
+void SipHash_4way(uint64_t k0, uint64_t k1, const unsigned char* const* inputs, const uint64_t* last, uint64_t* out)
+{
+    __m256i v0 = K(0x736f6d6570736575ULL ^ k0);
+    __m256i v1 = K(0x646f72616e646f6dULL ^ k1);
+    __m256i v2 = K(0x6c7967656e657261ULL ^ k0);
+    __m256i v3 = K(0x7465646279746573ULL ^ k1);
+
+    for (int i = 0; i < 5; ++i) {
+        const __m256i d = i < 4 ? Read4(inputs, 8 * i) : _mm256_loadu_si256((const __m256i*)last);
+        v3 = Xor(v3, d);
+        SipRound(v0, v1, v2, v3);
+        SipRound(v0, v1, v2, v3);
+        v0 = Xor(v0, d);
+    }
+    v2 = Xor(v2, K(0xFF));
+    SipRound(v0, v1, v2, v3);
+    SipRound(v0, v1, v2, v3);
+    SipRound(v0, v1, v2, v3);
+    SipRound(v0, v1, v2, v3);
+    _mm256_storeu_si256((__m256i*)out, Xor(Xor(v0, v1), Xor(v2, v3)));
+}
+}
+
+#endif
@@ -78,6 +78,13 @@ void BIP32Hash(const ChainCode &chainCode, unsigned int nChild, unsigned char he
     CHMAC_SHA512(chainCode.begin(), chainCode.size()).Write(&header, 1).Write(data, 32).Write(num, 4).Finalize(output);
 }
 
+void Hash160Batch(unsigned char* output, const unsigned char* const* inputs, const size_t* lengths, size_t n)
+{
+    std::vector<unsigned char> sha(CSHA256::OUTPUT_SIZE * n);
+    SHA256Batch(sha.data(), inputs, lengths, n);
+    RIPEMD160_32(output, sha.data(), n);
+}
+
 #define ROTL(x, b) (uint64_t)(((x) << (b)) | ((x) >> (64 - (b))))
 
 #define SIPROUND do { \
@@ -112,6 +112,11 @@ inline uint160 Hash160(const prevector<N, unsigned char>& vch)
     return Hash160(vch.begin(), vch.end());
 }
 
+/** Compute the 160-bit hashes of n independent messages into n consecutive
+ *  20-byte outputs, using the multi-lane SHA256/RIPEMD160 code when available.
+ */
+void Hash160Batch(unsigned char* output, const unsigned char* const* inputs, const size_t* lengths, size_t n);
+
 /** A writer stream (for serialization) that computes a 256-bit hash. */
 class CHashWriter
 {
@@ -16,6 +16,8 @@
 #include <checkpoints.h>
 #include <compat/sanity.h>
 #include <consensus/validation.h>
+#include <crypto/ripemd160.h>
+#include <crypto/siphash.h>
 #include <fs.h>
 #include <httpserver.h>
 #include <httprpc.h>
@@ -38,6 +40,7 @@
 #include <timedata.h>
 #include <txdb.h>
 #include <txmempool.h>
+#include <stratum.h>
 #include <torcontrol.h>
 #include <ui_interface.h>
 #include <util.h>
@@ -144,16 +147,29 @@ public:
         try {
             return CCoinsViewBacked::GetCoin(outpoint, coin);
         } catch(const std::runtime_error& e) {
-            uiInterface.ThreadSafeMessageBox(_("Error reading from database, shutting down."), "", CClientUIInterface::MSG_ERROR);
-            LogPrintf("Error reading from database: %s\n", e.what());
-            // Starting the shutdown sequence and returning false to the caller would be
-            // interpreted as 'entry not found' (as opposed to unable to read data), and
-            // could lead to invalid interpretation. Just exit immediately, as we can't
-            // continue anyway, and all writes should be atomic.
-            abort();
+            ReadError(e);
+        }
+    }
+    void GetCoins(const std::vector<COutPoint>& outpoints, std::vector<Coin>& coins, std::vector<bool>& found) const override {
+        // Forward the whole batch, so that the database can serve it at once.
+        try {
+            base->GetCoins(outpoints, coins, found);
+        } catch(const std::runtime_error& e) {
+            ReadError(e);
         }
     }
     // Writes do not need similar protection, as failure to write is handled by the caller.
+
+private:
+    [[noreturn]] static void ReadError(const std::runtime_error& e) {
+        uiInterface.ThreadSafeMessageBox(_("Error reading from database, shutting down."), "", CClientUIInterface::MSG_ERROR);
+        LogPrintf("Error reading from database: %s\n", e.what());
+        // Starting the shutdown sequence and returning false to the caller would be
+        // interpreted as 'entry not found' (as opposed to unable to read data), and
+        // could lead to invalid interpretation. Just exit immediately, as we can't
+        // continue anyway, and all writes should be atomic.
+        abort();
+    }
 };
 
 static std::unique_ptr<CCoinsViewErrorCatcher> pcoinscatcher;
@@ -169,6 +185,7 @@ void Interrupt()
     InterruptRPC();
     InterruptREST();
     InterruptTorControl();
+    InterruptStratumServer();
     if (g_connman)
         g_connman->Interrupt();
 }
@@ -205,6 +222,11 @@ void Shutdown()
     g_connman.reset();
 
     StopTorControl();
+    StopStratumServer();
+    if (g_template_updater) {
+        UnregisterValidationInterface(g_template_updater.get());
+        g_template_updater.reset();
+    }
 
     // After everything has been shut down, but before things get flushed, stop the
     // CScheduler/checkqueue threadGroup
@@ -363,6 +385,7 @@ std::string HelpMessage(HelpMessageMode mode)
     if (showDebug)
         strUsage += HelpMessageOpt("-feefilter", strprintf("Tell other nodes to filter invs to us by our mempool min fee (default: %u)", DEFAULT_FEEFILTER));
     strUsage += HelpMessageOpt("-loadblock=<file>", _("Imports blocks from external blk000??.dat file on startup"));
+    strUsage += HelpMessageOpt("-loadutxosnapshot=<file>", _("On first startup, fill the chainstate from a UTXO snapshot written by dumptxoutset instead of downloading and validating the blocks below it. Only snapshots whose base block, height, UTXO set hash and coin count are built into this software are accepted. The blocks below the snapshot are never validated and are treated as pruned. If loading is interrupted, restart with the same file. This mode is incompatible with -txindex"));
     strUsage += HelpMessageOpt("-debuglogfile=<file>", strprintf(_("Specify location of debug log file: this can be an absolute path or a path relative to the data directory (default: %s)"), DEFAULT_DEBUGLOGFILE));
     strUsage += HelpMessageOpt("-maxorphantx=<n>", strprintf(_("Keep at most <n> unconnectable transactions in memory (default: %u)"), DEFAULT_MAX_ORPHAN_TRANSACTIONS));
     strUsage += HelpMessageOpt("-maxmempool=<n>", strprintf(_("Keep the transaction memory pool below <n> megabytes (default: %u)"), DEFAULT_MAX_MEMPOOL_SIZE));
@@ -445,6 +468,7 @@ std::string HelpMessage(HelpMessageMode mode)
     {
         strUsage += HelpMessageOpt("-checkblocks=<n>", strprintf(_("How many blocks to check at startup (default: %u, 0 = all)"), DEFAULT_CHECKBLOCKS));
         strUsage += HelpMessageOpt("-checklevel=<n>", strprintf(_("How thorough the block verification of -checkblocks is (0-4, default: %u)"), DEFAULT_CHECKLEVEL));
+        strUsage += HelpMessageOpt("-checkblockpow", strprintf(_("Recompute the proof of work of all stored headers in the background after startup, using all cores (default: %u)"), DEFAULT_CHECKBLOCKPOW));
         strUsage += HelpMessageOpt("-checkblockindex", strprintf("Do a full consistency check for mapBlockIndex, setBlockIndexCandidates, chainActive and mapBlocksUnlinked occasionally. Also sets -checkmempool (default: %u)", defaultChainParams->DefaultConsistencyChecks()));
         strUsage += HelpMessageOpt("-checkmempool=<n>", strprintf("Run checks every <n> transactions (default: %u)", defaultChainParams->DefaultConsistencyChecks()));
         strUsage += HelpMessageOpt("-checkpoints", strprintf("Disable expensive verification for known chain history (default: %u)", DEFAULT_CHECKPOINTS_ENABLED));
@@ -461,6 +485,7 @@ std::string HelpMessage(HelpMessageMode mode)
         strUsage += HelpMessageOpt("-limitdescendantcount=<n>", strprintf("Do not accept transactions if any ancestor would have <n> or more in-mempool descendants (default: %u)", DEFAULT_DESCENDANT_LIMIT));
         strUsage += HelpMessageOpt("-limitdescendantsize=<n>", strprintf("Do not accept transactions if any ancestor would have more than <n> kilobytes of in-mempool descendants (default: %u).", DEFAULT_DESCENDANT_SIZE_LIMIT));
         strUsage += HelpMessageOpt("-vbparams=deployment:start:end", "Use given start/end times for specified version bits deployment (regtest-only)");
+        strUsage += HelpMessageOpt("-assumeutxo=blockhash:height:hash:coins", "Accept the UTXO snapshot of the given base block and height, hash_serialized_2 and coin count with -loadutxosnapshot (regtest-only)");
     }
     strUsage += HelpMessageOpt("-debug=<category>", strprintf(_("Output debugging information (default: %u, supplying <category> is optional)"), 0) + ". " +
         _("If <category> is not supplied or if <category> = 1, output all debugging information.") + " " + _("<category> can be:") + " " + ListLogCategories() + ".");
@@ -506,6 +531,13 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-blockmintxfee=<amt>", strprintf(_("Set lowest fee rate (in %s/kB) for transactions to be included in block creation. (default: %s)"), CURRENCY_UNIT, FormatMoney(DEFAULT_BLOCK_MIN_TX_FEE)));
     if (showDebug)
         strUsage += HelpMessageOpt("-blockversion=<n>", "Override block version to test forking scenarios");
+    strUsage += HelpMessageOpt("-genthreads=<n>", strprintf(_("Set the number of threads generate and generatetoaddress mine with (0 = all cores, <0 = leave that many cores free, default: %d)"), DEFAULT_GENERATE_THREADS));
+    strUsage += HelpMessageOpt("-stratum", strprintf(_("Serve block templates to KawPoW miners over the stratum protocol (default: %u)"), DEFAULT_STRATUM_ENABLE));
+    strUsage += HelpMessageOpt("-stratumaddress=<addr>", _("Address the coinbase of stratum blocks pays to (required with -stratum)"));
+    strUsage += HelpMessageOpt("-stratumbind=<addr>", strprintf(_("Bind the stratum server to the given address. Without -stratumpassword miners are not authenticated, so only use trusted interfaces (default: %s)"), DEFAULT_STRATUM_BIND));
+    strUsage += HelpMessageOpt("-stratumport=<port>", strprintf(_("Listen for stratum connections on <port> (default: %u)"), DEFAULT_STRATUM_PORT));
+    strUsage += HelpMessageOpt("-stratumpassword=<pw>", _("Password miners have to send with mining.authorize before they can submit shares"));
+    strUsage += HelpMessageOpt("-stratumdifficulty=<n>", strprintf(_("Share difficulty as a multiple of the minimum proof-of-work difficulty, capped at the block difficulty (default: %d)"), DEFAULT_STRATUM_DIFFICULTY));
 
     strUsage += HelpMessageGroup(_("RPC server options:"));
     strUsage += HelpMessageOpt("-server", _("Accept command line and JSON-RPC commands"));
@@ -901,6 +933,14 @@ bool AppInitParameterInteraction()
             return InitError(_("Prune mode is incompatible with -txindex."));
     }
 
+    // a UTXO snapshot holds no blocks to index or reindex from
+    if (gArgs.IsArgSet("-loadutxosnapshot")) {
+        if (gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX))
+            return InitError(_("-loadutxosnapshot is incompatible with -txindex."));
+        if (gArgs.GetBoolArg("-reindex", false) || gArgs.GetBoolArg("-reindex-chainstate", false))
+            return InitError(_("-loadutxosnapshot is incompatible with -reindex and -reindex-chainstate."));
+    }
+
     // -bind and -whitebind can't be set when not listening
     size_t nUserBind = gArgs.GetArgs("-bind").size() + gArgs.GetArgs("-whitebind").size();
     if (nUserBind != 0 && !gArgs.GetBoolArg("-listen", DEFAULT_LISTEN)) {
@@ -1145,6 +1185,35 @@ bool AppInitParameterInteraction()
             }
         }
     }
+
+    if (gArgs.IsArgSet("-assumeutxo")) {
+        // Allow accepting other UTXO snapshots for testing. Testnet mines
+        // blocks on demand too, but is a public network.
+        if (chainparams.NetworkIDString() != CBaseChainParams::REGTEST) {
+            return InitError("UTXO snapshots may only be added on regtest.");
+        }
+        for (const std::string& strSnapshot : gArgs.GetArgs("-assumeutxo")) {
+            std::vector<std::string> vSnapshotParams;
+            boost::split(vSnapshotParams, strSnapshot, boost::is_any_of(":"));
+            if (vSnapshotParams.size() != 4) {
+                return InitError("UTXO snapshot parameters malformed, expecting blockhash:height:hash:coins");
+            }
+            if (!IsHex(vSnapshotParams[0]) || vSnapshotParams[0].size() != 64 || !IsHex(vSnapshotParams[2]) || vSnapshotParams[2].size() != 64) {
+                return InitError(strprintf("Invalid UTXO snapshot hashes (%s)", strSnapshot));
+            }
+            int32_t nHeight;
+            if (!ParseInt32(vSnapshotParams[1], &nHeight) || nHeight <= 0) {
+                return InitError(strprintf("Invalid UTXO snapshot height (%s)", vSnapshotParams[1]));
+            }
+            int64_t nCoins;
+            if (!ParseInt64(vSnapshotParams[3], &nCoins) || nCoins < 0) {
+                return InitError(strprintf("Invalid UTXO snapshot coin count (%s)", vSnapshotParams[3]));
+            }
+            const uint256 hashBase = uint256S(vSnapshotParams[0]);
+            UpdateAssumeutxo(hashBase, AssumeutxoData{nHeight, uint256S(vSnapshotParams[2]), (uint64_t)nCoins});
+            LogPrintf("Accepting the UTXO snapshot at %s (height %d) with hash_serialized_2=%s, coins=%d\n", hashBase.ToString(), nHeight, vSnapshotParams[2], nCoins);
+        }
+    }
     return true;
 }
 
@@ -1165,6 +1234,10 @@ bool AppInitSanityChecks()
     // Initialize elliptic curve code
     std::string sha256_algo = SHA256AutoDetect();
     LogPrintf("Using the '%s' SHA256 implementation\n", sha256_algo);
+    std::string ripemd160_algo = RIPEMD160AutoDetect();
+    LogPrintf("Using the '%s' RIPEMD160 implementation\n", ripemd160_algo);
+    std::string siphash_algo = SipHashAutoDetect();
+    LogPrintf("Using the '%s' SipHash implementation\n", siphash_algo);
     RandomInit();
     ECC_Start();
     globalVerifyHandle.reset(new ECCVerifyHandle());
@@ -1229,10 +1302,12 @@ bool AppInitMain()
     InitSignatureCache();
     InitScriptExecutionCache();
 
-    LogPrintf("Using %u threads for script verification\n", nScriptCheckThreads);
+    LogPrintf("Using %u threads for script, transaction and header PoW verification and coin fetching\n", nScriptCheckThreads);
     if (nScriptCheckThreads) {
-        for (int i=0; i<nScriptCheckThreads-1; i++)
+        for (int i=0; i<nScriptCheckThreads-1; i++) {
             threadGroup.create_thread(&ThreadScriptCheck);
+            threadGroup.create_thread(&ThreadTaskCheck);
+        }
     }
 
     // Start the lightweight task scheduler thread
@@ -1264,10 +1339,8 @@ bool AppInitMain()
 
     int64_t nStart;
 
-#if defined(USE_SSE2)
-    std::string sse2detect = scrypt_detect_sse2();
-    LogPrintf("%s\n", sse2detect);
-#endif
+    std::string scryptdetect = scrypt_detect();
+    LogPrintf("%s\n", scryptdetect);
 
     // ********************************************************* Step 5: verify wallet database integrity
 #ifdef ENABLE_WALLET
@@ -1435,6 +1508,14 @@ bool AppInitMain()
                         CleanupBlockRevFiles();
                 }
 
+                // Block index entries and block files from before the KawPoW header
+                // fields were added cannot be deserialized any more.
+                if (!pblocktree->HasKawpowHeaderFormat()) {
+                    strLoadError = _("The block database uses the block header format from before KawPoW. You need to rebuild the database using -reindex.  This will redownload the entire blockchain");
+                    break;
+                }
+                pblocktree->WriteFlag("kawpowheaders", true);
+
                 if (fRequestShutdown) break;
 
                 // LoadBlockIndex will load fTxIndex from the db, or set it if
@@ -1459,8 +1540,9 @@ bool AppInitMain()
                 }
 
                 // Check for changed -prune state.  What we are concerned about is a user who has pruned blocks
-                // in the past, but is now trying to run unpruned.
-                if (fHavePruned && !fPruneMode) {
+                // in the past, but is now trying to run unpruned. A chainstate loaded from a UTXO snapshot
+                // has no blocks below the snapshot either way.
+                if (fHavePruned && !fPruneMode && !fHaveUTXOSnapshot) {
                     strLoadError = _("You need to rebuild the database using -reindex to go back to unpruned mode.  This will redownload the entire blockchain");
                     break;
                 }
@@ -1496,6 +1578,18 @@ bool AppInitMain()
                 // The on-disk coinsdb is now in a good state, create the cache
                 pcoinsTip.reset(new CCoinsViewCache(pcoinscatcher.get()));
 
+                if (!fReset && !fReindexChainState) {
+                    // Fill an empty coinsdb from a UTXO snapshot, if given. This is a no-op once it is loaded.
+                    if (gArgs.IsArgSet("-loadutxosnapshot")) {
+                        if (!LoadUTXOSnapshot(chainparams, fs::absolute(gArgs.GetArg("-loadutxosnapshot", ""), GetDataDir()), strLoadError)) {
+                            break;
+                        }
+                    } else if (fHaveUTXOSnapshot && pcoinsTip->GetBestBlock().IsNull()) {
+                        strLoadError = _("Loading the UTXO snapshot was interrupted. Restart with the same -loadutxosnapshot file");
+                        break;
+                    }
+                }
+
                 bool is_coinsview_empty = fReset || fReindexChainState || pcoinsTip->GetBestBlock().IsNull();
                 if (!is_coinsview_empty) {
                     // LoadChainTip sets chainActive based on pcoinsTip's best block
@@ -1609,6 +1703,9 @@ bool AppInitMain()
             uiInterface.InitMessage(_("Pruning blockstore..."));
             PruneAndFlush();
         }
+    } else if (fHaveUTXOSnapshot) {
+        LogPrintf("Unsetting NODE_NETWORK, the blocks below the UTXO snapshot are not available\n");
+        nLocalServices = ServiceFlags(nLocalServices & ~NODE_NETWORK);
     }
 
     if (chainparams.GetConsensus().vDeployments[Consensus::DEPLOYMENT_SEGWIT].nTimeout != 0) {
@@ -1643,6 +1740,10 @@ bool AppInitMain()
 
     threadGroup.create_thread(boost::bind(&ThreadImport, vImportFiles));
 
+    if (gArgs.GetBoolArg("-checkblockpow", DEFAULT_CHECKBLOCKPOW)) {
+        threadGroup.create_thread(&ThreadCheckBlockIndexPoW);
+    }
+
     // Wait for genesis block to be processed
     {
         WaitableLock lock(cs_GenesisWait);
@@ -1735,6 +1836,14 @@ bool AppInitMain()
         return false;
     }
 
+    // Keep the block template current for getblocktemplate and stratum
+    g_template_updater.reset(new BlockTemplateUpdater(chainparams));
+    RegisterValidationInterface(g_template_updater.get());
+
+    if (gArgs.GetBoolArg("-stratum", DEFAULT_STRATUM_ENABLE) && !StartStratumServer()) {
+        return false;
+    }
+
     // ********************************************************* Step 12: finished
 
     SetRPCWarmupFinished();
@@ -0,0 +1,59 @@
+// Copyright (c) 2024 The NoteCoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <kawpow/header_hasher.h>
+#include <crypto/common.h>
+
+#include <string.h>
+
+namespace kawpow {
+
+HeaderHasher::HeaderHasher(const CBlockHeader& header) :
+    nHeight(header.nHeight),
+    seeder(header.GetKAWPOWHeaderHash()),
+    context(progpow::GetEpochContext(progpow::GetEpochNumber(header.nHeight)))
+{
+    // The serialized header is 120 bytes; everything before the nonce (the
+    // 80-byte KawPoW input) is fixed, and its first 64 bytes fill exactly
+    // one SHA256 block.
+    unsigned char head[64];
+    WriteLE32(head, (uint32_t)header.nVersion);
+    memcpy(head + 4, header.hashPrevBlock.begin(), 32);
+    memcpy(head + 36, header.hashMerkleRoot.begin(), 28);
+    midstate.Write(head, sizeof(head));
+
+    memcpy(tail, header.hashMerkleRoot.begin() + 28, 4);
+    WriteLE32(tail + 4, header.nTime);
+    WriteLE32(tail + 8, header.nBits);
+    WriteLE32(tail + 12, header.nHeight);
+}
+
+void HeaderHasher::Hash(uint64_t nFirstNonce, size_t count, uint256* hashes, uint256* mix_hashes) const
+{
+    for (size_t j = 0; j < count; ++j) {
+        hashes[j] = progpow::hash(*context, seeder, nFirstNonce + j, nHeight, &mix_hashes[j]);
+    }
+}
+
+void HeaderHasher::HashLight(const uint64_t* nonces, const uint256* mix_hashes, size_t count, uint256* hashes) const
+{
+    for (size_t j = 0; j < count; ++j) {
+        hashes[j] = progpow::hash_light(seeder, nonces[j], mix_hashes[j]);
+    }
+}
+
+uint256 HeaderHasher::GetBlockHash(uint64_t nNonce, const uint256& mix_hash) const
+{
+    unsigned char rest[sizeof(tail) + 8];
+    memcpy(rest, tail, sizeof(tail));
+    WriteLE64(rest + sizeof(tail), nNonce);
+
+    uint256 result;
+    CSHA256 sha(midstate);
+    sha.Write(rest, sizeof(rest)).Write(mix_hash.begin(), 32).Finalize(result.begin());
+    CSHA256().Write(result.begin(), CSHA256::OUTPUT_SIZE).Finalize(result.begin());
+    return result;
+}
+
+} // namespace kawpow
@@ -0,0 +1,49 @@
+// Copyright (c) 2024 The NoteCoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef KAWPOW_HEADER_HASHER_H
+#define KAWPOW_HEADER_HASHER_H
+
+#include <crypto/progpow/progpow.hpp>
+#include <crypto/sha256.h>
+#include <primitives/block.h>
+#include <uint256.h>
+
+#include <memory>
+#include <stdint.h>
+
+namespace kawpow {
+
+/**
+ * Hashes many nonces of one header template. Only nNonce and nMixHash vary
+ * while scanning, so the KawPoW header hash, the seed state, the epoch
+ * context and the SHA256 midstate of the block hash are prepared once.
+ */
+class HeaderHasher
+{
+private:
+    uint32_t nHeight;
+    progpow::SeedHasher seeder;
+    std::shared_ptr<const progpow::EpochContext> context;
+    /** SHA256 state after the first 64 bytes of the serialized header. */
+    CSHA256 midstate;
+    /** Header bytes between the midstate and nNonce (end of hashMerkleRoot, nTime, nBits, nHeight). */
+    unsigned char tail[16];
+
+public:
+    explicit HeaderHasher(const CBlockHeader& header);
+
+    /** Full KawPoW hashes and mix digests of nonces nFirstNonce ... nFirstNonce + count - 1. */
+    void Hash(uint64_t nFirstNonce, size_t count, uint256* hashes, uint256* mix_hashes) const;
+
+    /** Light (claimed mix) hashes of count candidate solutions, e.g. a queue of shares. */
+    void HashLight(const uint64_t* nonces, const uint256* mix_hashes, size_t count, uint256* hashes) const;
+
+    /** CBlockHeader::GetHash() of the template with the given solution filled in. */
+    uint256 GetBlockHash(uint64_t nNonce, const uint256& mix_hash) const;
+};
+
+} // namespace kawpow
+
+#endif // KAWPOW_HEADER_HASHER_H
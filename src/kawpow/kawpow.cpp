@@ -1,33 +1,36 @@
 #include <kawpow/kawpow.h>
-#include <util/system.h>
-#include <crypto/kawpow/kawpow_hash.hpp> // Separate Implementierung (kommt noch)
-#include <serialize.h>
-#include <streams.h>
+#include <kawpow/kawpow_hash.hpp>
+#include <crypto/common.h>
+
+#include <string.h>
 
 namespace kawpow {
 
-uint256 HashPoW(const CBlockHeader& block)
+void SerializeInput(const CBlockHeader& block, KawpowInput& input)
 {
-    // Convert header to byte stream (without nonce and mixhash)
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
-    ss << block.nVersion;
-    ss << block.hashPrevBlock;
-    ss << block.hashMerkleRoot;
-    ss << block.nTime;
-    ss << block.nBits;
-
-    // Combine full header with nonce
-    std::vector<unsigned char> header_data(ss.begin(), ss.end());
-
-    // KawPoW expects a full 256-bit nonce (here: expand from uint32_t nonce)
-    std::vector<unsigned char> full_nonce(8, 0x00);
-    memcpy(&full_nonce[0], &block.nNonce, sizeof(block.nNonce));
+    // Same layout as CKAWPOWInput's serialization, written straight into a
+    // stack buffer instead of going through a CDataStream.
+    unsigned char* p = input.data();
+    WriteLE32(p, (uint32_t)block.nVersion);
+    memcpy(p + 4, block.hashPrevBlock.begin(), 32);
+    memcpy(p + 36, block.hashMerkleRoot.begin(), 32);
+    WriteLE32(p + 68, block.nTime);
+    WriteLE32(p + 72, block.nBits);
+    WriteLE32(p + 76, block.nHeight);
+}
 
-    // Use fake block height for now, can later pass in real height if needed
-    uint64_t block_height = 0;
+uint256 HashPoW(const CBlockHeader& block, uint256& mix_hash)
+{
+    KawpowInput input;
+    SerializeInput(block, input);
+    return kawpow_hash(input, block.nNonce, block.nHeight, mix_hash);
+}
 
-    // Calculate final hash using KawPoW
-    return kawpow_hash(header_data, full_nonce, block_height);
+uint256 HashPoWLight(const CBlockHeader& block)
+{
+    KawpowInput input;
+    SerializeInput(block, input);
+    return kawpow_hash_light(input, block.nNonce, block.nMixHash);
 }
 
 } // namespace kawpow
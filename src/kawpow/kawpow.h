@@ -1,15 +1,28 @@
 #ifndef KAWPOW_H
 #define KAWPOW_H
 
+#include <kawpow/kawpow_hash.hpp>
 #include <uint256.h>
 #include <primitives/block.h>
 
 namespace kawpow {
 
+/** Serialize the KawPoW input of a header (see CKAWPOWInput) without heap allocation. */
+void SerializeInput(const CBlockHeader& block, KawpowInput& input);
+
+/**
+ * Computes the KawPoW hash for a given block header, recomputing the mix
+ * digest from the DAG of the header's epoch.
+ */
+uint256 HashPoW(const CBlockHeader& block, uint256& mix_hash);
+
 /**
- * Computes the KawPoW hash for a given block header.
+ * Computes the KawPoW hash for a given block header trusting its nMixHash.
+ * This is only the final Keccak pass and needs no DAG, so it is a cheap
+ * first filter; a header passing it still needs HashPoW() to prove that
+ * nMixHash is genuine.
  */
-uint256 HashPoW(const CBlockHeader& block);
+uint256 HashPoWLight(const CBlockHeader& block);
 
 } // namespace kawpow
 
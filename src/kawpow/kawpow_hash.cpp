@@ -1,27 +1,23 @@
 #include <kawpow/kawpow_hash.hpp>
-#include <crypto/progpow/progpow.hpp>  // externe Lib – implementieren wir gleich
-#include <cstring>
+#include <crypto/progpow/progpow.hpp>
+#include <hash.h>
 
-uint256 kawpow_hash(const std::vector<unsigned char>& header,
-                    const std::vector<unsigned char>& full_nonce,
-                    uint64_t height)
+uint256 kawpow_hash(const KawpowInput& header, uint64_t nonce, uint64_t height, uint256& mix_hash)
 {
     // ProgPoW needs:
     // - header_hash (uint256)
     // - nonce (uint64_t)
     // - height (for seed)
+    uint256 header_hash = Hash(header.begin(), header.end()); // double SHA256
 
-    if (header.size() < 80) {
-        // Not a valid block header
-        return uint256();
-    }
+    // Run KawPoW (ProgPoW) algo; the light cache for height's epoch comes
+    // from progpow's epoch context cache and is only built once per epoch.
+    return progpow::hash(header_hash, nonce, height, &mix_hash);
+}
 
+uint256 kawpow_hash_light(const KawpowInput& header, uint64_t nonce, const uint256& mix_hash)
+{
     uint256 header_hash = Hash(header.begin(), header.end()); // double SHA256
-    uint64_t nonce = 0;
-    memcpy(&nonce, &full_nonce[0], sizeof(uint64_t));
-
-    // Run KawPoW (ProgPoW) algo
-    uint256 result_hash = progpow::hash(header_hash, nonce, height);
 
-    return result_hash;
+    return progpow::hash_light(header_hash, nonce, mix_hash);
 }
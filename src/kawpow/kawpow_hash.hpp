@@ -2,19 +2,33 @@
 #define KAWPOW_HASH_HPP
 
 #include <uint256.h>
-#include <vector>
+
+#include <array>
+#include <stdint.h>
+
+/** Size of the serialized KawPoW input (CKAWPOWInput). */
+static const size_t KAWPOW_INPUT_SIZE = 80;
+
+/** Serialized KawPoW input, kept on the stack. */
+typedef std::array<uint8_t, KAWPOW_INPUT_SIZE> KawpowInput;
 
 /**
  * Computes the KawPoW (ProgPoW-based) hash.
  *
  * @param header     Serialized block header (without nonce/mixhash)
- * @param full_nonce 64-bit nonce (as 8-byte vector)
- * @param height      Block height (used as input to ProgPoW seed hash)
+ * @param nonce      64-bit nonce
+ * @param height     Block height (selects the epoch and ProgPoW program)
+ * @param mix_hash   Receives the mix digest recomputed from the DAG
+ *
+ * @return 32-byte (uint256) KawPoW hash
+ */
+uint256 kawpow_hash(const KawpowInput& header, uint64_t nonce, uint64_t height, uint256& mix_hash);
+
+/**
+ * Computes the KawPoW hash from a claimed mix digest without touching the DAG.
  *
  * @return 32-byte (uint256) KawPoW hash
  */
-uint256 kawpow_hash(const std::vector<unsigned char>& header,
-                    const std::vector<unsigned char>& full_nonce,
-                    uint64_t height);
+uint256 kawpow_hash_light(const KawpowInput& header, uint64_t nonce, const uint256& mix_hash);
 
 #endif // KAWPOW_HASH_HPP
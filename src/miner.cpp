@@ -14,7 +14,10 @@
 #include <consensus/merkle.h>
 #include <consensus/validation.h>
 #include <hash.h>
+#include <crypto/progpow/progpow.hpp>
 #include <crypto/scrypt.h>
+#include <init.h>
+#include <kawpow/header_hasher.h>
 #include <validation.h>
 #include <net.h>
 #include <policy/feerate.h>
@@ -30,6 +33,7 @@
 #include <algorithm>
 #include <memory>
 #include <queue>
+#include <thread>
 #include <utility>
 
 //////////////////////////////////////////////////////////////////////////////
@@ -105,6 +109,40 @@ void BlockAssembler::resetBlock()
     nFees = 0;
 }
 
+// Add the coinbase and the header to a template whose transactions are in
+// place, and check that the result is a valid block on top of pindexPrev.
+static void FinalizeBlockTemplate(CBlockTemplate& blocktemplate, const CScript& scriptPubKeyIn, CAmount nFees, CBlockIndex* pindexPrev, const CChainParams& chainparams)
+{
+    CBlock* pblock = &blocktemplate.block;
+    const int nHeight = pindexPrev->nHeight + 1;
+
+    // Create coinbase transaction.
+    CMutableTransaction coinbaseTx;
+    coinbaseTx.vin.resize(1);
+    coinbaseTx.vin[0].prevout.SetNull();
+    coinbaseTx.vout.resize(1);
+    coinbaseTx.vout[0].scriptPubKey = scriptPubKeyIn;
+    coinbaseTx.vout[0].nValue = nFees + GetBlockSubsidy(nHeight, chainparams.GetConsensus());
+    coinbaseTx.vin[0].scriptSig = CScript() << nHeight << OP_0;
+    pblock->vtx[0] = MakeTransactionRef(std::move(coinbaseTx));
+    blocktemplate.vchCoinbaseCommitment = GenerateCoinbaseCommitment(*pblock, pindexPrev, chainparams.GetConsensus());
+    blocktemplate.vTxFees[0] = -nFees;
+
+    // Fill in header
+    pblock->hashPrevBlock  = pindexPrev->GetBlockHash();
+    UpdateTime(pblock, chainparams.GetConsensus(), pindexPrev);
+    pblock->nBits          = GetNextWorkRequired(pindexPrev, pblock, chainparams.GetConsensus());
+    pblock->nHeight        = nHeight;
+    pblock->nNonce         = 0;
+    pblock->nMixHash.SetNull();
+    blocktemplate.vTxSigOpsCost[0] = WITNESS_SCALE_FACTOR * GetLegacySigOpCount(*pblock->vtx[0]);
+
+    CValidationState state;
+    if (!TestBlockValidity(state, chainparams, *pblock, pindexPrev, false, false)) {
+        throw std::runtime_error(strprintf("%s: TestBlockValidity failed: %s", __func__, FormatStateMessage(state)));
+    }
+}
+
 std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& scriptPubKeyIn, bool fMineWitnessTx)
 {
     int64_t nTimeStart = GetTimeMicros();
@@ -157,31 +195,10 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     nLastBlockTx = nBlockTx;
     nLastBlockWeight = nBlockWeight;
 
-    // Create coinbase transaction.
-    CMutableTransaction coinbaseTx;
-    coinbaseTx.vin.resize(1);
-    coinbaseTx.vin[0].prevout.SetNull();
-    coinbaseTx.vout.resize(1);
-    coinbaseTx.vout[0].scriptPubKey = scriptPubKeyIn;
-    coinbaseTx.vout[0].nValue = nFees + GetBlockSubsidy(nHeight, chainparams.GetConsensus());
-    coinbaseTx.vin[0].scriptSig = CScript() << nHeight << OP_0;
-    pblock->vtx[0] = MakeTransactionRef(std::move(coinbaseTx));
-    pblocktemplate->vchCoinbaseCommitment = GenerateCoinbaseCommitment(*pblock, pindexPrev, chainparams.GetConsensus());
-    pblocktemplate->vTxFees[0] = -nFees;
+    FinalizeBlockTemplate(*pblocktemplate, scriptPubKeyIn, nFees, pindexPrev, chainparams);
 
     LogPrintf("CreateNewBlock(): block weight: %u txs: %u fees: %ld sigops %d\n", GetBlockWeight(*pblock), nBlockTx, nFees, nBlockSigOpsCost);
 
-    // Fill in header
-    pblock->hashPrevBlock  = pindexPrev->GetBlockHash();
-    UpdateTime(pblock, chainparams.GetConsensus(), pindexPrev);
-    pblock->nBits          = GetNextWorkRequired(pindexPrev, pblock, chainparams.GetConsensus());
-    pblock->nNonce         = 0;
-    pblocktemplate->vTxSigOpsCost[0] = WITNESS_SCALE_FACTOR * GetLegacySigOpCount(*pblock->vtx[0]);
-
-    CValidationState state;
-    if (!TestBlockValidity(state, chainparams, *pblock, pindexPrev, false, false)) {
-        throw std::runtime_error(strprintf("%s: TestBlockValidity failed: %s", __func__, FormatStateMessage(state)));
-    }
     int64_t nTime2 = GetTimeMicros();
 
     LogPrint(BCLog::BENCH, "CreateNewBlock() packages: %.2fms (%d packages, %d updated descendants), validity: %.2fms (total %.2fms)\n", 0.001 * (nTime1 - nTimeStart), nPackagesSelected, nDescendantsUpdated, 0.001 * (nTime2 - nTime1), 0.001 * (nTime2 - nTimeStart));
@@ -439,6 +456,179 @@ void BlockAssembler::addPackageTxs(int &nPackagesSelected, int &nDescendantsUpda
     }
 }
 
+std::unique_ptr<BlockTemplateUpdater> g_template_updater;
+
+BlockTemplateUpdater::BlockTemplateUpdater(const CChainParams& params, const BlockAssembler::Options& optionsIn) :
+    chainparams(params), options(optionsIn), fValid(false), nHeight(0), nLockTimeCutoff(0), fIncludeWitness(false),
+    nBlockWeight(0), nBlockSigOpsCost(0), nFees(0)
+{
+}
+
+BlockTemplateUpdater::BlockTemplateUpdater(const CChainParams& params) : BlockTemplateUpdater(params, DefaultOptions(params)) {}
+
+void BlockTemplateUpdater::Reset(const CBlockTemplate& blocktemplate, const CBlockIndex* pindexPrev, bool fWitness)
+{
+    const CBlock& block = blocktemplate.block;
+    hashPrevBlock = pindexPrev->GetBlockHash();
+    nHeight = pindexPrev->nHeight + 1;
+    nLockTimeCutoff = (STANDARD_LOCKTIME_VERIFY_FLAGS & LOCKTIME_MEDIAN_TIME_PAST)
+                       ? pindexPrev->GetMedianTimePast()
+                       : block.GetBlockTime();
+    fIncludeWitness = fWitness;
+
+    vtx.assign(block.vtx.begin() + 1, block.vtx.end());
+    vTxFees.assign(blocktemplate.vTxFees.begin() + 1, blocktemplate.vTxFees.end());
+    vTxSigOpsCost.assign(blocktemplate.vTxSigOpsCost.begin() + 1, blocktemplate.vTxSigOpsCost.end());
+    setSelected.clear();
+    // Same accounting as BlockAssembler, which reserves room for the coinbase
+    nBlockWeight = 4000;
+    nBlockSigOpsCost = 400;
+    nFees = 0;
+    for (size_t i = 0; i < vtx.size(); ++i) {
+        setSelected.insert(vtx[i]->GetHash());
+        nBlockWeight += GetTransactionWeight(*vtx[i]);
+        nBlockSigOpsCost += vTxSigOpsCost[i];
+        nFees += vTxFees[i];
+    }
+    fValid = true;
+}
+
+std::unique_ptr<CBlockTemplate> BlockTemplateUpdater::CreateNewBlock(const CScript& scriptPubKeyIn, bool fMineWitnessTx)
+{
+    int64_t nTimeStart = GetTimeMicros();
+
+    LOCK2(cs_main, mempool.cs);
+    std::lock_guard<std::mutex> lock(cs_selection);
+    CBlockIndex* pindexPrev = chainActive.Tip();
+    assert(pindexPrev != nullptr);
+    const bool fWitness = IsWitnessEnabled(pindexPrev, chainparams.GetConsensus()) && fMineWitnessTx;
+
+    if (fValid && hashPrevBlock == pindexPrev->GetBlockHash() && fIncludeWitness == fWitness) {
+        std::unique_ptr<CBlockTemplate> pblocktemplate(new CBlockTemplate());
+        CBlock* pblock = &pblocktemplate->block;
+        pblock->vtx.reserve(vtx.size() + 1);
+        pblock->vtx.emplace_back();
+        pblock->vtx.insert(pblock->vtx.end(), vtx.begin(), vtx.end());
+        pblocktemplate->vTxFees.push_back(-1);
+        pblocktemplate->vTxFees.insert(pblocktemplate->vTxFees.end(), vTxFees.begin(), vTxFees.end());
+        pblocktemplate->vTxSigOpsCost.push_back(-1);
+        pblocktemplate->vTxSigOpsCost.insert(pblocktemplate->vTxSigOpsCost.end(), vTxSigOpsCost.begin(), vTxSigOpsCost.end());
+
+        pblock->nVersion = ComputeBlockVersion(pindexPrev, chainparams.GetConsensus());
+        if (chainparams.MineBlocksOnDemand())
+            pblock->nVersion = gArgs.GetArg("-blockversion", pblock->nVersion);
+        pblock->nTime = GetAdjustedTime();
+
+        try {
+            FinalizeBlockTemplate(*pblocktemplate, scriptPubKeyIn, nFees, pindexPrev, chainparams);
+            nLastBlockTx = vtx.size();
+            nLastBlockWeight = nBlockWeight;
+            LogPrint(BCLog::BENCH, "CreateNewBlock() updated template: %u txs, fees %ld, %.2fms\n", vtx.size(), nFees, 0.001 * (GetTimeMicros() - nTimeStart));
+            return pblocktemplate;
+        } catch (const std::runtime_error& e) {
+            // A notification we rely on has not arrived yet (or never will);
+            // the full selection below only looks at the mempool itself.
+            LogPrint(BCLog::BENCH, "CreateNewBlock() updated template rejected, rebuilding: %s\n", e.what());
+        }
+    }
+
+    std::unique_ptr<CBlockTemplate> pblocktemplate = BlockAssembler(chainparams, options).CreateNewBlock(scriptPubKeyIn, fMineWitnessTx);
+    if (pblocktemplate)
+        Reset(*pblocktemplate, pindexPrev, fWitness);
+    return pblocktemplate;
+}
+
+void BlockTemplateUpdater::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload)
+{
+    std::lock_guard<std::mutex> lock(cs_selection);
+    fValid = false;
+}
+
+void BlockTemplateUpdater::TransactionAddedToMempool(const CTransactionRef &ptx)
+{
+    LOCK(mempool.cs);
+    std::lock_guard<std::mutex> lock(cs_selection);
+    if (!fValid || setSelected.count(ptx->GetHash()))
+        return;
+    // Notifications are asynchronous: the transaction may be gone already,
+    // and then a removal notification is on its way too.
+    CTxMemPool::txiter it = mempool.mapTx.find(ptx->GetHash());
+    if (it == mempool.mapTx.end())
+        return;
+
+    CTxMemPool::setEntries ancestors;
+    uint64_t nNoLimit = std::numeric_limits<uint64_t>::max();
+    std::string dummy;
+    mempool.CalculateMemPoolAncestors(*it, ancestors, nNoLimit, nNoLimit, nNoLimit, nNoLimit, dummy, false);
+    for (CTxMemPool::txiter ancestor : ancestors) {
+        if (!setSelected.count(ancestor->GetTx().GetHash())) {
+            // The package would have to be selected as a whole; leave that
+            // to addPackageTxs unless it cannot make it into a block anyway.
+            if (it->GetModFeesWithAncestors() >= options.blockMinFeeRate.GetFee(it->GetSizeWithAncestors()))
+                fValid = false;
+            return;
+        }
+    }
+
+    // With all ancestors selected, the package addPackageTxs would consider
+    // is this transaction alone.
+    if (it->GetModifiedFee() < options.blockMinFeeRate.GetFee(it->GetTxSize()))
+        return;
+    if (!IsFinalTx(it->GetTx(), nHeight, nLockTimeCutoff) || (!fIncludeWitness && it->GetTx().HasWitness()))
+        return;
+    if (nBlockWeight + WITNESS_SCALE_FACTOR * it->GetTxSize() >= options.nBlockMaxWeight ||
+            nBlockSigOpsCost + it->GetSigOpCost() >= MAX_BLOCK_SIGOPS_COST) {
+        // The block is full: whether this one displaces others is for the
+        // full selection to decide.
+        fValid = false;
+        return;
+    }
+
+    vtx.push_back(it->GetSharedTx());
+    vTxFees.push_back(it->GetFee());
+    vTxSigOpsCost.push_back(it->GetSigOpCost());
+    setSelected.insert(ptx->GetHash());
+    nBlockWeight += it->GetTxWeight();
+    nBlockSigOpsCost += it->GetSigOpCost();
+    nFees += it->GetFee();
+}
+
+void BlockTemplateUpdater::TransactionRemovedFromMempool(const CTransactionRef &ptx)
+{
+    std::lock_guard<std::mutex> lock(cs_selection);
+    if (!fValid || !setSelected.count(ptx->GetHash()))
+        return;
+
+    // Parents precede their children in block order, so one pass finds
+    // every selected descendant of the removed transaction.
+    std::set<uint256> setRemoved;
+    setRemoved.insert(ptx->GetHash());
+    size_t j = 0;
+    for (size_t i = 0; i < vtx.size(); ++i) {
+        bool fRemove = setRemoved.count(vtx[i]->GetHash()) > 0;
+        for (const CTxIn& txin : vtx[i]->vin) {
+            if (fRemove)
+                break;
+            fRemove = setRemoved.count(txin.prevout.hash) > 0;
+        }
+        if (fRemove) {
+            setRemoved.insert(vtx[i]->GetHash());
+            setSelected.erase(vtx[i]->GetHash());
+            nBlockWeight -= GetTransactionWeight(*vtx[i]);
+            nBlockSigOpsCost -= vTxSigOpsCost[i];
+            nFees -= vTxFees[i];
+            continue;
+        }
+        vtx[j] = vtx[i];
+        vTxFees[j] = vTxFees[i];
+        vTxSigOpsCost[j] = vTxSigOpsCost[i];
+        ++j;
+    }
+    vtx.resize(j);
+    vTxFees.resize(j);
+    vTxSigOpsCost.resize(j);
+}
+
 void IncrementExtraNonce(CBlock* pblock, const CBlockIndex* pindexPrev, unsigned int& nExtraNonce)
 {
     // Update nExtraNonce
@@ -457,3 +647,113 @@ void IncrementExtraNonce(CBlock* pblock, const CBlockIndex* pindexPrev, unsigned
     pblock->vtx[0] = MakeTransactionRef(std::move(txCoinbase));
     pblock->hashMerkleRoot = BlockMerkleRoot(*pblock);
 }
+
+CBlockSolver::CBlockSolver(int nThreadsIn) : nThreads(std::max(1, nThreadsIn)), fStale(false), nTemplateHeight(0)
+{
+    RegisterValidationInterface(this);
+}
+
+CBlockSolver::~CBlockSolver()
+{
+    UnregisterValidationInterface(this);
+    // Notifications are delivered on the scheduler thread; make sure none is
+    // still running against this object before it goes away.
+    SyncWithValidationInterfaceQueue();
+}
+
+void CBlockSolver::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload)
+{
+    std::lock_guard<std::mutex> lock(cs_template);
+    // Notifications arrive asynchronously, so the one for the block we just
+    // mined may show up while we already work on its successor. Only a tip
+    // other than our parent, at or past our parent's height, is news.
+    if (pindexNew->GetBlockHash() != hashTemplatePrev && pindexNew->nHeight >= nTemplateHeight - 1) {
+        fStale = true;
+    }
+}
+
+/** Take up to nWant tries from a shared budget, returning how many were granted. */
+static uint64_t ReserveTries(std::atomic<uint64_t>& budget, uint64_t nWant)
+{
+    uint64_t nLeft = budget.load();
+    uint64_t nTake;
+    do {
+        nTake = std::min(nLeft, nWant);
+    } while (nTake > 0 && !budget.compare_exchange_weak(nLeft, nLeft - nTake));
+    return nTake;
+}
+
+CBlockSolver::Result CBlockSolver::Solve(CBlock& block, uint64_t& nMaxTries, const Consensus::Params& params)
+{
+    {
+        std::lock_guard<std::mutex> lock(cs_template);
+        hashTemplatePrev = block.hashPrevBlock;
+        nTemplateHeight = block.nHeight;
+        fStale = false;
+    }
+
+    // Everything but the nonce is fixed for this template: prepare the header
+    // hash, seed state and epoch context once for all threads.
+    const kawpow::HeaderHasher hasher(block);
+    const uint64_t nStartNonce = block.nNonce;
+    const uint32_t nBits = block.nBits;
+
+    std::atomic<uint64_t> nNextRange(0);
+    std::atomic<uint64_t> nBudget(nMaxTries);
+    std::atomic<uint64_t> nUsed(0);
+    std::atomic<bool> fFound(false);
+    std::mutex cs_solution;
+    uint64_t nSolutionNonce = 0;
+    uint256 solutionMix;
+
+    auto worker = [&]() {
+        while (!fFound && !fStale && !ShutdownRequested()) {
+            const uint64_t nTries = ReserveTries(nBudget, GENERATE_NONCE_RANGE);
+            if (nTries == 0) return;
+            const uint64_t nFirst = nStartNonce + nNextRange.fetch_add(GENERATE_NONCE_RANGE);
+            for (uint64_t i = 0; i < nTries && !fFound; ++i) {
+                uint256 hash, mix_hash;
+                hasher.Hash(nFirst + i, 1, &hash, &mix_hash);
+                ++nUsed;
+                if (CheckProofOfWork(hash, nBits, params)) {
+                    std::lock_guard<std::mutex> lock(cs_solution);
+                    if (!fFound) {
+                        nSolutionNonce = nFirst + i;
+                        solutionMix = mix_hash;
+                        fFound = true;
+                    }
+                    return;
+                }
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < nThreads; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    // Only charge the hashes actually computed, not ranges abandoned early
+    nMaxTries -= std::min<uint64_t>(nMaxTries, nUsed);
+    if (fFound) {
+        block.nNonce = nSolutionNonce;
+        block.nMixHash = solutionMix;
+        return Result::FOUND;
+    }
+    if (ShutdownRequested()) return Result::INTERRUPTED;
+    if (fStale) return Result::STALE;
+    return Result::EXHAUSTED;
+}
+
+int GetGenerateThreads()
+{
+    int nThreads = gArgs.GetArg("-genthreads", DEFAULT_GENERATE_THREADS);
+    if (nThreads <= 0) {
+        nThreads += GetNumCores();
+    }
+    return std::max(1, nThreads);
+}
@@ -8,9 +8,13 @@
 
 #include <primitives/block.h>
 #include <txmempool.h>
+#include <validationinterface.h>
 
 #include <stdint.h>
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <set>
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/ordered_index.hpp>
 
@@ -21,6 +25,10 @@ class CScript;
 namespace Consensus { struct Params; };
 
 static const bool DEFAULT_PRINTPRIORITY = false;
+/** Default for -genthreads, the number of threads generatetoaddress mines with */
+static const int DEFAULT_GENERATE_THREADS = 1;
+/** Number of nonces a mining thread claims from the shared counter at a time */
+static const uint64_t GENERATE_NONCE_RANGE = 32;
 
 struct CBlockTemplate
 {
@@ -192,6 +200,95 @@ private:
     int UpdatePackagesForAdded(const CTxMemPool::setEntries& alreadyAdded, indexed_modified_transaction_set &mapModifiedTx);
 };
 
+/**
+ * Keeps a block template's transaction selection up to date between tip
+ * changes instead of running the package selection over the whole mempool
+ * for every request. Mempool additions whose in-mempool ancestors are all
+ * selected are appended while they fit, and removals drop the transaction
+ * together with its selected descendants. Anything the shortcut cannot
+ * decide (a new tip, a full block, a child paying for an unselected parent)
+ * makes the next request fall back to BlockAssembler::CreateNewBlock.
+ */
+class BlockTemplateUpdater final : public CValidationInterface
+{
+public:
+    BlockTemplateUpdater(const CChainParams& params, const BlockAssembler::Options& options);
+    explicit BlockTemplateUpdater(const CChainParams& params);
+
+    /** Same result as BlockAssembler::CreateNewBlock, reusing the maintained selection when possible */
+    std::unique_ptr<CBlockTemplate> CreateNewBlock(const CScript& scriptPubKeyIn, bool fMineWitnessTx=true);
+
+protected:
+    void UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload) override;
+    void TransactionAddedToMempool(const CTransactionRef &ptx) override;
+    void TransactionRemovedFromMempool(const CTransactionRef &ptx) override;
+
+private:
+    const CChainParams& chainparams;
+    const BlockAssembler::Options options;
+
+    std::mutex cs_selection;
+    //! False when the next request has to run the full package selection
+    bool fValid;
+    //! Chain context the selection was made for
+    uint256 hashPrevBlock;
+    int nHeight;
+    int64_t nLockTimeCutoff;
+    bool fIncludeWitness;
+    //! Selected transactions in block order, without the coinbase
+    std::vector<CTransactionRef> vtx;
+    std::vector<CAmount> vTxFees;
+    std::vector<int64_t> vTxSigOpsCost;
+    std::set<uint256> setSelected;
+    uint64_t nBlockWeight;
+    int64_t nBlockSigOpsCost;
+    CAmount nFees;
+
+    /** Take over the selection of a freshly assembled template */
+    void Reset(const CBlockTemplate& blocktemplate, const CBlockIndex* pindexPrev, bool fWitness);
+};
+
+/** Template updater shared by getblocktemplate and the stratum server (null until the node is started) */
+extern std::unique_ptr<BlockTemplateUpdater> g_template_updater;
+
+/**
+ * Multithreaded CPU solver used by generatetoaddress. All threads share one
+ * block template and claim nonce ranges from a common counter; the first
+ * solution stops the others, and a tip change from elsewhere abandons the
+ * template so the caller can build a fresh one.
+ */
+class CBlockSolver final : public CValidationInterface
+{
+public:
+    enum class Result {
+        FOUND,       //!< block.nNonce and block.nMixHash hold a solution
+        STALE,       //!< the tip moved on; rebuild the template
+        EXHAUSTED,   //!< nMaxTries ran out
+        INTERRUPTED, //!< shutdown was requested
+    };
+
+    explicit CBlockSolver(int nThreadsIn);
+    ~CBlockSolver();
+
+    /** Search nonces from block.nNonce upwards, charging every hash against nMaxTries. */
+    Result Solve(CBlock& block, uint64_t& nMaxTries, const Consensus::Params& params);
+
+protected:
+    void UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload) override;
+
+private:
+    const int nThreads;
+    std::atomic<bool> fStale;
+
+    std::mutex cs_template;
+    //! Parent and height of the template being solved, to tell our own stale notifications from real tip changes
+    uint256 hashTemplatePrev;
+    int nTemplateHeight;
+};
+
+/** Number of threads to mine with, from -genthreads (0 = all cores, <0 = leave that many cores free) */
+int GetGenerateThreads();
+
 /** Modify the extranonce in a block */
 void IncrementExtraNonce(CBlock* pblock, const CBlockIndex* pindexPrev, unsigned int& nExtraNonce);
 int64_t UpdateTime(CBlockHeader* pblock, const Consensus::Params& consensusParams, const CBlockIndex* pindexPrev);
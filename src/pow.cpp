@@ -7,6 +7,7 @@
 
 #include <arith_uint256.h>
 #include <chain.h>
+#include <kawpow/kawpow.h>
 #include <primitives/block.h>
 #include <uint256.h>
 #include <util.h>
@@ -14,7 +15,7 @@
 unsigned int GetNextWorkRequired(const CBlockIndex* pindexLast, const CBlockHeader *pblock, const Consensus::Params& params)
 {
     //Get next height and compare to forkheight
-    if (pindexLast->nHeight + 1 > params.nDigiSheildHFHeight){
+    if (pindexLast->nHeight + 1 > params.nDigiShieldHFHeight){
         return DigiShieldV4(pindexLast,params);
     }
     return GetNextWorkRequiredLegacy(pindexLast,pblock,params);
@@ -23,13 +24,10 @@ unsigned int GetNextWorkRequired(const CBlockIndex* pindexLast, const CBlockHead
 unsigned int DigiShieldV4(const CBlockIndex* pindexLast, const Consensus::Params& params)
 {
     // find first block in averaging interval
-    // Go back by what we want to be nAveragingInterval blocks per algo
-    const CBlockIndex* pindexFirst = pindexLast;
+    // Go back by what we want to be nAveragingInterval blocks per algo;
+    // the skip list gets there in O(log n) instead of walking pprev
+    const CBlockIndex* pindexFirst = pindexLast->GetAncestor(pindexLast->nHeight - params.nAveragingInterval);
     const arith_uint256 powLimit = UintToArith256(params.powLimit);
-    for (int i = 0; pindexFirst && i < params.nAveragingInterval; i++)
-    {
-        pindexFirst = pindexFirst->pprev;
-    }
 
     const CBlockIndex* pindexPrev = pindexLast->pprev;
     if (pindexPrev == nullptr || pindexFirst == nullptr)
@@ -105,10 +103,7 @@ unsigned int GetNextWorkRequiredLegacy(const CBlockIndex* pindexLast, const CBlo
         blockstogoback = params.DifficultyAdjustmentInterval();
 
     // Go back by what we want to be 14 days worth of blocks
-    const CBlockIndex* pindexFirst = pindexLast;
-    for (int i = 0; pindexFirst && i < blockstogoback; i++)
-        pindexFirst = pindexFirst->pprev;
-
+    const CBlockIndex* pindexFirst = pindexLast->GetAncestor(pindexLast->nHeight - blockstogoback);
     assert(pindexFirst);
 
     return CalculateNextWorkRequired(pindexLast, pindexFirst->GetBlockTime(), params);
@@ -165,3 +160,24 @@ bool CheckProofOfWork(uint256 hash, unsigned int nBits, const Consensus::Params&
 
     return true;
 }
+
+bool CheckBlockProofOfWork(const CBlockHeader& block, const Consensus::Params& params, uint256* pow_hash)
+{
+    // Bogus headers from peers fail here for the cost of one Keccak
+    const uint256 hash = kawpow::HashPoWLight(block);
+    if (!CheckProofOfWork(hash, block.nBits, params))
+        return false;
+
+    if (pow_hash)
+        *pow_hash = hash;
+    return true;
+}
+
+bool CheckBlockMixHash(const CBlockHeader& block)
+{
+    // The final hash is a function of the seed and the mix, so a matching mix
+    // implies the hash checked by CheckBlockProofOfWork().
+    uint256 mix_hash;
+    kawpow::HashPoW(block, mix_hash);
+    return mix_hash == block.nMixHash;
+}
@@ -22,4 +22,20 @@ unsigned int CalculateNextWorkRequired(const CBlockIndex* pindexLast, int64_t nF
 /** Check whether a block hash satisfies the proof-of-work requirement specified by nBits */
 bool CheckProofOfWork(uint256 hash, unsigned int nBits, const Consensus::Params&);
 
+/**
+ * Check the context-free stage of a header's KawPoW solution: the final hash
+ * implied by the claimed nMixHash (one Keccak, no DAG) must meet nBits. On
+ * success that hash is stored in pow_hash if given. The solution is only
+ * proven once CheckBlockMixHash() also passes.
+ */
+bool CheckBlockProofOfWork(const CBlockHeader& block, const Consensus::Params&, uint256* pow_hash = nullptr);
+
+/**
+ * Check that a header's nMixHash is the mix digest recomputed from the DAG.
+ * nHeight selects the epoch whose context this builds or fetches, so only
+ * call it once ContextualCheckBlockHeader() has checked nHeight and nBits
+ * against the chain.
+ */
+bool CheckBlockMixHash(const CBlockHeader& block);
+
 #endif // BITCOIN_POW_H
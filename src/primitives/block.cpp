@@ -10,27 +10,40 @@
 #include <utilstrencodings.h>
 #include <crypto/common.h>
 
-#include <kawpow/kawpow.h>  // Neue Datei – wir erstellen sie später
+#include <kawpow/kawpow.h>
 
 uint256 CBlockHeader::GetHash() const
 {
     return SerializeHash(*this);
 }
 
+uint256 CBlockHeader::GetKAWPOWHeaderHash() const
+{
+    KawpowInput input;
+    kawpow::SerializeInput(*this, input);
+    return Hash(input.begin(), input.end());
+}
+
 uint256 CBlockHeader::GetPoWHash() const
 {
-    return kawpow::HashPoW(*this);
+    uint256 mix_hash;
+    return kawpow::HashPoW(*this, mix_hash);
+}
+
+uint256 CBlockHeader::GetPoWHash(uint256& mix_hash) const
+{
+    return kawpow::HashPoW(*this, mix_hash);
 }
 
 std::string CBlock::ToString() const
 {
     std::stringstream s;
-    s << strprintf("CBlock(hash=%s, ver=0x%08x, hashPrevBlock=%s, hashMerkleRoot=%s, nTime=%u, nBits=%08x, nNonce=%u, vtx=%u)\n",
+    s << strprintf("CBlock(hash=%s, ver=0x%08x, hashPrevBlock=%s, hashMerkleRoot=%s, nTime=%u, nBits=%08x, nHeight=%u, nNonce=%u, nMixHash=%s, vtx=%u)\n",
         GetHash().ToString(),
         nVersion,
         hashPrevBlock.ToString(),
         hashMerkleRoot.ToString(),
-        nTime, nBits, nNonce,
+        nTime, nBits, nHeight, nNonce, nMixHash.ToString(),
         vtx.size());
     for (const auto& tx : vtx) {
         s << "  " << tx->ToString() << "\n";
@@ -26,7 +26,11 @@ public:
     uint256 hashMerkleRoot;
     uint32_t nTime;
     uint32_t nBits;
-    uint32_t nNonce;
+    // KawPoW: the height selects the epoch and program, the 64-bit nonce and
+    // the mix digest are the miner's solution.
+    uint32_t nHeight;
+    uint64_t nNonce;
+    uint256 nMixHash;
 
     CBlockHeader()
     {
@@ -42,7 +46,9 @@ public:
         READWRITE(hashMerkleRoot);
         READWRITE(nTime);
         READWRITE(nBits);
+        READWRITE(nHeight);
         READWRITE(nNonce);
+        READWRITE(nMixHash);
     }
 
     void SetNull()
@@ -52,7 +58,9 @@ public:
         hashMerkleRoot.SetNull();
         nTime = 0;
         nBits = 0;
+        nHeight = 0;
         nNonce = 0;
+        nMixHash.SetNull();
     }
 
     bool IsNull() const
@@ -62,8 +70,15 @@ public:
 
     uint256 GetHash() const;
 
+    /** Double-SHA256 of the 80-byte KawPoW input (the header up to and including nHeight). */
+    uint256 GetKAWPOWHeaderHash() const;
+
+    /** Full KawPoW hash, recomputing the mix digest from the DAG. */
     uint256 GetPoWHash() const;
 
+    /** As GetPoWHash(), also returning the recomputed mix digest. */
+    uint256 GetPoWHash(uint256& mix_hash) const;
+
     int64_t GetBlockTime() const
     {
         return (int64_t)nTime;
@@ -114,13 +129,52 @@ public:
         block.hashMerkleRoot = hashMerkleRoot;
         block.nTime          = nTime;
         block.nBits          = nBits;
+        block.nHeight        = nHeight;
         block.nNonce         = nNonce;
+        block.nMixHash       = nMixHash;
         return block;
     }
 
     std::string ToString() const;
 };
 
+/**
+ * The part of a header that KawPoW commits to through its header hash:
+ * everything but the nonce and the mix digest. Serializes to exactly 80 bytes.
+ */
+class CKAWPOWInput
+{
+public:
+    int32_t nVersion;
+    uint256 hashPrevBlock;
+    uint256 hashMerkleRoot;
+    uint32_t nTime;
+    uint32_t nBits;
+    uint32_t nHeight;
+
+    explicit CKAWPOWInput(const CBlockHeader& header)
+    {
+        nVersion = header.nVersion;
+        hashPrevBlock = header.hashPrevBlock;
+        hashMerkleRoot = header.hashMerkleRoot;
+        nTime = header.nTime;
+        nBits = header.nBits;
+        nHeight = header.nHeight;
+    }
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(this->nVersion);
+        READWRITE(hashPrevBlock);
+        READWRITE(hashMerkleRoot);
+        READWRITE(nTime);
+        READWRITE(nBits);
+        READWRITE(nHeight);
+    }
+};
+
 /** Describes a place in the block chain to another node such that if the
  * other node doesn't have the same branch, it can find a recent common trunk.
  * The further back it is, the further before the fork it may be.
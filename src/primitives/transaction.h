@@ -8,6 +8,7 @@
 
 #include <stdint.h>
 #include <amount.h>
+#include <hash.h>
 #include <script/script.h>
 #include <serialize.h>
 #include <uint256.h>
@@ -176,6 +177,74 @@ public:
 
 struct CMutableTransaction;
 
+/**
+ * Stream wrapper for deserializing a transaction that keeps a copy of the
+ * bytes read, so its txid and wtxid can be hashed from the serialization it
+ * arrived in rather than from a second serialization pass.
+ */
+template<typename Stream>
+class TxRawReader
+{
+private:
+    Stream& m_source;
+    std::vector<unsigned char> m_raw;
+    /** Offset of the witness data in m_raw, or 0 for the basic format */
+    size_t m_witness_begin;
+
+public:
+    explicit TxRawReader(Stream& source) : m_source(source), m_witness_begin(0) {}
+
+    int GetVersion() const { return m_source.GetVersion(); }
+    int GetType() const { return m_source.GetType(); }
+
+    void read(char* pch, size_t nSize)
+    {
+        m_source.read(pch, nSize);
+        m_raw.insert(m_raw.end(), (const unsigned char*)pch, (const unsigned char*)pch + nSize);
+    }
+
+    template<typename T>
+    TxRawReader& operator>>(T&& obj)
+    {
+        ::Unserialize(*this, obj);
+        return *this;
+    }
+
+    void MarkWitness() { m_witness_begin = m_raw.size(); }
+
+    /** Hash of the transaction without witness data (the txid) */
+    uint256 GetHash() const
+    {
+        uint256 result;
+        if (!m_witness_begin) {
+            CHash256().Write(m_raw.data(), m_raw.size()).Finalize(result.begin());
+            return result;
+        }
+        // Leave out the marker and flag after nVersion, and the witness before nLockTime
+        CHash256()
+            .Write(m_raw.data(), 4)
+            .Write(m_raw.data() + 6, m_witness_begin - 6)
+            .Write(m_raw.data() + m_raw.size() - 4, 4)
+            .Finalize(result.begin());
+        return result;
+    }
+
+    /** Hash of the full serialization, including witness data (the wtxid) */
+    uint256 GetWitnessHash() const
+    {
+        uint256 result;
+        CHash256().Write(m_raw.data(), m_raw.size()).Finalize(result.begin());
+        return result;
+    }
+};
+
+/** Called where the witness data starts; only TxRawReader keeps track of it. */
+template<typename Stream>
+inline void MarkTxWitness(Stream& s) {}
+
+template<typename Stream>
+inline void MarkTxWitness(TxRawReader<Stream>& s) { s.MarkWitness(); }
+
 /**
  * Basic transaction serialization format:
  * - int32_t nVersion
@@ -217,6 +286,7 @@ inline void UnserializeTransaction(TxType& tx, Stream& s) {
     if ((flags & 1) && fAllowWitness) {
         /* The witness flag is present, and we support witnesses. */
         flags ^= 1;
+        MarkTxWitness(s);
         for (size_t i = 0; i < tx.vin.size(); i++) {
             s >> tx.vin[i].scriptWitness.stack;
         }
@@ -286,8 +356,15 @@ public:
 private:
     /** Memory only. */
     const uint256 hash;
+    const uint256 m_witness_hash;
 
     uint256 ComputeHash() const;
+    uint256 ComputeWitnessHash() const;
+
+    struct Deserialized;
+    template <typename Stream>
+    static Deserialized DeserializeHashed(Stream& s);
+    CTransaction(Deserialized&& tx);
 
 public:
     /** Construct a CTransaction that qualifies as IsNull() */
@@ -303,9 +380,10 @@ public:
     }
 
     /** This deserializing constructor is provided instead of an Unserialize method.
-     *  Unserialize is not possible, since it would require overwriting const fields. */
+     *  Unserialize is not possible, since it would require overwriting const fields.
+     *  The hashes are computed from the bytes read, without serializing again. */
     template <typename Stream>
-    CTransaction(deserialize_type, Stream& s) : CTransaction(CMutableTransaction(deserialize, s)) {}
+    CTransaction(deserialize_type, Stream& s) : CTransaction(DeserializeHashed(s)) {}
 
     bool IsNull() const {
         return vin.empty() && vout.empty();
@@ -315,8 +393,10 @@ public:
         return hash;
     }
 
-    // Compute a hash that includes both transaction and witness data
-    uint256 GetWitnessHash() const;
+    // Hash that includes both transaction and witness data
+    const uint256& GetWitnessHash() const {
+        return m_witness_hash;
+    }
 
     // Return sum of txouts.
     CAmount GetValueOut() const;
@@ -406,6 +486,29 @@ struct CMutableTransaction
     }
 };
 
+/** A transaction as just read from a stream, with the hashes of the bytes it was read from. */
+struct CTransaction::Deserialized
+{
+    CMutableTransaction tx;
+    uint256 hash;
+    uint256 witness_hash;
+};
+
+template <typename Stream>
+CTransaction::Deserialized CTransaction::DeserializeHashed(Stream& s)
+{
+    TxRawReader<Stream> reader(s);
+    Deserialized result;
+    UnserializeTransaction(result.tx, reader);
+    result.hash = reader.GetHash();
+    // As in ComputeWitnessHash, wtxid == txid without witness data, even if
+    // the transaction was serialized in the extended format
+    result.witness_hash = result.tx.HasWitness() ? reader.GetWitnessHash() : result.hash;
+    return result;
+}
+
+inline CTransaction::CTransaction(Deserialized&& tx) : vin(std::move(tx.tx.vin)), vout(std::move(tx.tx.vout)), nVersion(tx.tx.nVersion), nLockTime(tx.tx.nLockTime), hash(tx.hash), m_witness_hash(tx.witness_hash) {}
+
 typedef std::shared_ptr<const CTransaction> CTransactionRef;
 static inline CTransactionRef MakeTransactionRef() { return std::make_shared<const CTransaction>(); }
 template <typename Tx> static inline CTransactionRef MakeTransactionRef(Tx&& txIn) { return std::make_shared<const CTransaction>(std::forward<Tx>(txIn)); }
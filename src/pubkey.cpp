@@ -6,6 +6,7 @@
 #include <pubkey.h>
 
 #include <secp256k1.h>
+#include <secp256k1_batch.h>
 #include <secp256k1_recovery.h>
 
 namespace
@@ -183,6 +184,63 @@ bool CPubKey::Verify(const uint256 &hash, const std::vector<unsigned char>& vchS
     return secp256k1_ecdsa_verify(secp256k1_context_verify, &sig, hash.begin(), &pubkey);
 }
 
+bool CPubKey::VerifyBatch(const std::vector<CPubKey>& pubkeys, const std::vector<uint256>& hashes, const std::vector<std::vector<unsigned char>>& sigs, std::vector<bool>* results) {
+    assert(pubkeys.size() == hashes.size() && sigs.size() == hashes.size());
+    const size_t n = hashes.size();
+    std::vector<secp256k1_pubkey> vPubKey(n);
+    std::vector<secp256k1_ecdsa_signature> vSig(n);
+    std::vector<const secp256k1_pubkey*> vpPubKey;
+    std::vector<const secp256k1_ecdsa_signature*> vpSig;
+    std::vector<const unsigned char*> vpHash;
+    std::vector<size_t> vIndex;
+    vpPubKey.reserve(n);
+    vpSig.reserve(n);
+    vpHash.reserve(n);
+    vIndex.reserve(n);
+    if (results) results->assign(n, false);
+
+    // Entries that do not even parse are invalid, the rest go to libsecp256k1.
+    for (size_t i = 0; i < n; ++i) {
+        if (!pubkeys[i].IsValid() ||
+            !secp256k1_ec_pubkey_parse(secp256k1_context_verify, &vPubKey[i], pubkeys[i].begin(), pubkeys[i].size()) ||
+            !ecdsa_signature_parse_der_lax(secp256k1_context_verify, &vSig[i], sigs[i].data(), sigs[i].size())) {
+            continue;
+        }
+        secp256k1_ecdsa_signature_normalize(secp256k1_context_verify, &vSig[i], &vSig[i]);
+        vpPubKey.push_back(&vPubKey[i]);
+        vpSig.push_back(&vSig[i]);
+        vpHash.push_back(hashes[i].begin());
+        vIndex.push_back(i);
+    }
+
+    std::vector<int> vValid(vIndex.size());
+    bool fAllValid = secp256k1_ecdsa_verify_batch(secp256k1_context_verify, vValid.data(), vpSig.data(), vpHash.data(), vpPubKey.data(), vIndex.size());
+    if (results) {
+        for (size_t i = 0; i < vIndex.size(); ++i) {
+            (*results)[vIndex[i]] = vValid[i];
+        }
+    }
+    return fAllValid && vIndex.size() == n;
+}
+
+std::vector<CKeyID> CPubKey::GetIDs(const std::vector<CPubKey>& pubkeys) {
+    std::vector<const unsigned char*> inputs;
+    std::vector<size_t> lengths;
+    inputs.reserve(pubkeys.size());
+    lengths.reserve(pubkeys.size());
+    for (const CPubKey& pubkey : pubkeys) {
+        inputs.push_back(pubkey.begin());
+        lengths.push_back(pubkey.size());
+    }
+    std::vector<CKeyID> ids(pubkeys.size());
+    std::vector<unsigned char> out(CRIPEMD160::OUTPUT_SIZE * pubkeys.size());
+    Hash160Batch(out.data(), inputs.data(), lengths.data(), pubkeys.size());
+    for (size_t i = 0; i < ids.size(); ++i) {
+        memcpy(ids[i].begin(), out.data() + CRIPEMD160::OUTPUT_SIZE * i, CRIPEMD160::OUTPUT_SIZE);
+    }
+    return ids;
+}
+
 bool CPubKey::RecoverCompact(const uint256 &hash, const std::vector<unsigned char>& vchSig) {
     if (vchSig.size() != COMPACT_SIGNATURE_SIZE)
         return false;
@@ -151,6 +151,9 @@ public:
         return CKeyID(Hash160(vch, vch + size()));
     }
 
+    //! Get the KeyIDs of many public keys at once (multi-lane HASH160 when available)
+    static std::vector<CKeyID> GetIDs(const std::vector<CPubKey>& pubkeys);
+
     //! Get the 256-bit hash of this public key.
     uint256 GetHash() const
     {
@@ -182,6 +185,13 @@ public:
      */
     bool Verify(const uint256& hash, const std::vector<unsigned char>& vchSig) const;
 
+    /**
+     * Verify the DER signatures sigs[i] of hashes[i] by pubkeys[i], with the
+     * same rules as Verify but sharing work between them. Returns whether all
+     * of them are valid; the individual results are stored in results if given.
+     */
+    static bool VerifyBatch(const std::vector<CPubKey>& pubkeys, const std::vector<uint256>& hashes, const std::vector<std::vector<unsigned char>>& sigs, std::vector<bool>* results = nullptr);
+
     /**
      * Check whether a signature is normalized (lower-S).
      */
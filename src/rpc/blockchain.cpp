@@ -102,6 +102,7 @@ UniValue blockheaderToJSON(const CBlockIndex* blockindex)
     result.push_back(Pair("time", (int64_t)blockindex->nTime));
     result.push_back(Pair("mediantime", (int64_t)blockindex->GetMedianTimePast()));
     result.push_back(Pair("nonce", (uint64_t)blockindex->nNonce));
+    result.push_back(Pair("mixhash", blockindex->nMixHash.GetHex()));
     result.push_back(Pair("bits", strprintf("%08x", blockindex->nBits)));
     result.push_back(Pair("difficulty", GetDifficulty(blockindex)));
     result.push_back(Pair("chainwork", blockindex->nChainWork.GetHex()));
@@ -148,6 +149,7 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool tx
     result.push_back(Pair("time", block.GetBlockTime()));
     result.push_back(Pair("mediantime", (int64_t)blockindex->GetMedianTimePast()));
     result.push_back(Pair("nonce", (uint64_t)block.nNonce));
+    result.push_back(Pair("mixhash", block.nMixHash.GetHex()));
     result.push_back(Pair("bits", strprintf("%08x", block.nBits)));
     result.push_back(Pair("difficulty", GetDifficulty(blockindex)));
     result.push_back(Pair("chainwork", blockindex->nChainWork.GetHex()));
@@ -825,20 +827,14 @@ struct CCoinsStats
 
 static void ApplyStats(CCoinsStats &stats, CHashWriter& ss, const uint256& hash, const std::map<uint32_t, Coin>& outputs)
 {
-    assert(!outputs.empty());
-    ss << hash;
-    ss << VARINT(outputs.begin()->second.nHeight * 2 + outputs.begin()->second.fCoinBase);
+    ApplyTxOutSetHash(ss, hash, outputs);
     stats.nTransactions++;
-    for (const auto output : outputs) {
-        ss << VARINT(output.first + 1);
-        ss << output.second.out.scriptPubKey;
-        ss << VARINT(output.second.out.nValue);
+    for (const auto& output : outputs) {
         stats.nTransactionOutputs++;
         stats.nTotalAmount += output.second.out.nValue;
         stats.nBogoSize += 32 /* txid */ + 4 /* vout index */ + 4 /* height + coinbase */ + 8 /* amount */ +
                            2 /* scriptPubKey len */ + output.second.out.scriptPubKey.size() /* scriptPubKey */;
     }
-    ss << VARINT(0);
 }
 
 //! Calculate statistics about the unspent transaction output set
@@ -1172,6 +1168,12 @@ UniValue getblockchaininfo(const JSONRPCRequest& request)
             "  \"pruneheight\": xxxxxx,        (numeric) lowest-height complete block stored (only present if pruning is enabled)\n"
             "  \"automatic_pruning\": xx,      (boolean) whether automatic pruning is enabled (only present if pruning is enabled)\n"
             "  \"prune_target_size\": xxxxxx,  (numeric) the target size used by pruning (only present if automatic pruning is enabled)\n"
+            "  \"assumevalid\": {              (object) script checks skipped below the assumed-valid block (only present if -assumevalid is set)\n"
+            "     \"blockhash\": \"...\",         (string) the hash of the assumed-valid block\n"
+            "     \"skipped_blocks\": xx,        (numeric) the number of blocks connected without script checks since startup\n"
+            "     \"skipped_inputs\": xx,        (numeric) the number of inputs whose scripts were not checked\n"
+            "     \"last_skipped_height\": xx,   (numeric) the height of the last block connected without script checks, or -1\n"
+            "  },\n"
             "  \"softforks\": [                (array) status of softforks in progress\n"
             "     {\n"
             "        \"id\": \"xxxx\",           (string) name of softfork\n"
@@ -1235,6 +1237,16 @@ UniValue getblockchaininfo(const JSONRPCRequest& request)
         }
     }
 
+    if (!hashAssumeValid.IsNull()) {
+        const AssumeValidStats stats = GetAssumeValidStats();
+        UniValue assumevalid(UniValue::VOBJ);
+        assumevalid.push_back(Pair("blockhash",           hashAssumeValid.GetHex()));
+        assumevalid.push_back(Pair("skipped_blocks",      stats.blocks));
+        assumevalid.push_back(Pair("skipped_inputs",      stats.inputs));
+        assumevalid.push_back(Pair("last_skipped_height", stats.last_height));
+        obj.push_back(Pair("assumevalid", assumevalid));
+    }
+
     const Consensus::Params& consensusParams = Params().GetConsensus();
     CBlockIndex* tip = chainActive.Tip();
     UniValue softforks(UniValue::VARR);
@@ -1599,6 +1611,67 @@ UniValue getchaintxstats(const JSONRPCRequest& request)
     return ret;
 }
 
+/** Default distance of the dumpassumevalid block below the tip: a day of 2 minute blocks, well clear of any reorg. */
+static const int DEFAULT_ASSUMEVALID_DEPTH = 720;
+
+UniValue dumpassumevalid(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() > 1)
+        throw std::runtime_error(
+            "dumpassumevalid ( depth )\n"
+            "\nReturn chain parameters that let new nodes skip script checks for the active chain up to\n"
+            "the block depth blocks below the tip, in the form chainparams.cpp takes them.\n"
+            "See contrib/devtools/gen-assumevalid.py.\n"
+            "\nArguments:\n"
+            "1. depth        (numeric, optional, default=" + std::to_string(DEFAULT_ASSUMEVALID_DEPTH) + ") How many blocks below the tip the assumed-valid block lies.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"network\": \"xxxx\",           (string) current network name (main, test, regtest)\n"
+            "  \"height\": xxxxx,              (numeric) the height of the assumed-valid block\n"
+            "  \"defaultassumevalid\": \"hash\", (string) the hash of the assumed-valid block\n"
+            "  \"minimumchainwork\": \"xxxx\",  (string) the total work of the chain up to that block, in hexadecimal\n"
+            "  \"chaintxdata\": {              (object) transaction statistics at that block, as for getchaintxstats\n"
+            "    \"time\": xxxxx,              (numeric) the block timestamp in UNIX format\n"
+            "    \"txcount\": xxxxx,           (numeric) the total number of transactions in the chain up to that block\n"
+            "    \"txrate\": x.xx              (numeric) the average rate of transactions per second over the month before\n"
+            "  }\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("dumpassumevalid", "")
+            + HelpExampleRpc("dumpassumevalid", "720")
+        );
+
+    int depth = DEFAULT_ASSUMEVALID_DEPTH;
+    if (!request.params[0].isNull()) {
+        depth = request.params[0].get_int();
+    }
+
+    LOCK(cs_main);
+    const CBlockIndex* tip = chainActive.Tip();
+    if (depth < 0 || depth > tip->nHeight) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid depth: should be between 0 and the chain height");
+    }
+    const CBlockIndex* pindex = chainActive[tip->nHeight - depth];
+
+    // Same window as getchaintxstats, so the rate feeds GuessVerificationProgress sensibly
+    const int window = std::max(0, std::min(30 * 24 * 60 * 60 / (int)Params().GetConsensus().nPowTargetSpacing, pindex->nHeight - 1));
+    const CBlockIndex* pindexPast = pindex->GetAncestor(pindex->nHeight - window);
+    const int nTimeDiff = pindex->GetMedianTimePast() - pindexPast->GetMedianTimePast();
+
+    UniValue txdata(UniValue::VOBJ);
+    txdata.push_back(Pair("time", (int64_t)pindex->nTime));
+    txdata.push_back(Pair("txcount", (int64_t)pindex->nChainTx));
+    txdata.push_back(Pair("txrate", nTimeDiff > 0 ? ((double)(pindex->nChainTx - pindexPast->nChainTx)) / nTimeDiff : 0.0));
+
+    UniValue ret(UniValue::VOBJ);
+    ret.push_back(Pair("network", Params().NetworkIDString()));
+    ret.push_back(Pair("height", pindex->nHeight));
+    ret.push_back(Pair("defaultassumevalid", pindex->GetBlockHash().GetHex()));
+    ret.push_back(Pair("minimumchainwork", pindex->nChainWork.GetHex()));
+    ret.push_back(Pair("chaintxdata", txdata));
+    return ret;
+}
+
 UniValue savemempool(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() != 0) {
@@ -1618,11 +1691,54 @@ UniValue savemempool(const JSONRPCRequest& request)
     return NullUniValue;
 }
 
+UniValue dumptxoutset(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1) {
+        throw std::runtime_error(
+            "dumptxoutset \"path\"\n"
+            "\nWrites the UTXO set at the chain tip, with the headers leading to it, to a snapshot file.\n"
+            "Another node can start from it with -loadutxosnapshot instead of downloading and validating the blocks below it.\n"
+            "\nArguments:\n"
+            "1. \"path\"    (string, required) The snapshot file to write; a relative path is relative to the data directory.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"path\": \"xxxx\",              (string) the absolute path of the snapshot file\n"
+            "  \"base_hash\": \"hash\",         (string) the hash of the block the UTXO set belongs to\n"
+            "  \"base_height\": n,            (numeric) the height of that block\n"
+            "  \"coins_written\": n,          (numeric) the number of unspent transaction outputs written\n"
+            "  \"hash_serialized_2\": \"hash\", (string) the serialized hash of the UTXO set, as gettxoutsetinfo reports it\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("dumptxoutset", "\"utxo.dat\"")
+            + HelpExampleRpc("dumptxoutset", "\"utxo.dat\"")
+        );
+    }
+
+    const fs::path path = fs::absolute(request.params[0].get_str(), GetDataDir());
+    if (fs::exists(path)) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, path.string() + " already exists");
+    }
+
+    UTXOSnapshotInfo info;
+    if (!DumpUTXOSnapshot(path, info)) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Unable to write the UTXO snapshot");
+    }
+
+    UniValue ret(UniValue::VOBJ);
+    ret.push_back(Pair("path", path.string()));
+    ret.push_back(Pair("base_hash", info.base_blockhash.GetHex()));
+    ret.push_back(Pair("base_height", info.base_height));
+    ret.push_back(Pair("coins_written", (int64_t)info.coins_count));
+    ret.push_back(Pair("hash_serialized_2", info.txoutset_hash.GetHex()));
+    return ret;
+}
+
 static const CRPCCommand commands[] =
 { //  category              name                      actor (function)         argNames
   //  --------------------- ------------------------  -----------------------  ----------
     { "blockchain",         "getblockchaininfo",      &getblockchaininfo,      {} },
     { "blockchain",         "getchaintxstats",        &getchaintxstats,        {"nblocks", "blockhash"} },
+    { "blockchain",         "dumpassumevalid",        &dumpassumevalid,        {"depth"} },
     { "blockchain",         "getbestblockhash",       &getbestblockhash,       {} },
     { "blockchain",         "getblockcount",          &getblockcount,          {} },
     { "blockchain",         "getblock",               &getblock,               {"blockhash","verbosity|verbose"} },
@@ -1637,6 +1753,7 @@ static const CRPCCommand commands[] =
     { "blockchain",         "getrawmempool",          &getrawmempool,          {"verbose"} },
     { "blockchain",         "gettxout",               &gettxout,               {"txid","n","include_mempool"} },
     { "blockchain",         "gettxoutsetinfo",        &gettxoutsetinfo,        {} },
+    { "blockchain",         "dumptxoutset",           &dumptxoutset,           {"path"} },
     { "blockchain",         "pruneblockchain",        &pruneblockchain,        {"height"} },
     { "blockchain",         "savemempool",            &savemempool,            {} },
     { "blockchain",         "verifychain",            &verifychain,            {"checklevel","nblocks"} },
@@ -16,6 +16,7 @@
 #include <rpc/blockchain.h>
 #include <rpc/server.h>
 #include <rpc/util.h>
+#include <script/sigcache.h>
 #include <timedata.h>
 #include <util.h>
 #include <utilstrencodings.h>
@@ -458,6 +459,17 @@ static UniValue RPCLockedMemoryInfo()
     return obj;
 }
 
+static UniValue RPCCacheInfo(const CacheStats& stats)
+{
+    UniValue obj(UniValue::VOBJ);
+    obj.push_back(Pair("hits", stats.hits));
+    obj.push_back(Pair("misses", stats.misses));
+    obj.push_back(Pair("inserts", stats.inserts));
+    obj.push_back(Pair("evictions", stats.evictions));
+    obj.push_back(Pair("capacity", stats.capacity));
+    return obj;
+}
+
 #ifdef HAVE_MALLOC_INFO
 static std::string RPCMallocInfo()
 {
@@ -499,6 +511,16 @@ UniValue getmemoryinfo(const JSONRPCRequest& request)
             "    \"locked\": xxxxxx,       (numeric) Amount of bytes that succeeded locking. If this number is smaller than total, locking pages failed at some point and key data could be swapped to disk.\n"
             "    \"chunks_used\": xxxxx,   (numeric) Number allocated chunks\n"
             "    \"chunks_free\": xxxxx,   (numeric) Number unused chunks\n"
+            "  },\n"
+            "  \"sigcache\": {             (json object) Signature cache usage since startup\n"
+            "    \"hits\": xxxxx,          (numeric) Lookups that found the signature\n"
+            "    \"misses\": xxxxx,        (numeric) Lookups that did not find the signature\n"
+            "    \"inserts\": xxxxx,       (numeric) Signatures added to the cache\n"
+            "    \"evictions\": xxxxx,     (numeric) Signatures dropped to make room for others\n"
+            "    \"capacity\": xxxxx,      (numeric) Number of signatures the cache can hold\n"
+            "  },\n"
+            "  \"scriptcache\": {          (json object) Script execution cache usage since startup, same fields\n"
+            "    ...\n"
             "  }\n"
             "}\n"
             "\nResult (mode \"mallocinfo\"):\n"
@@ -512,6 +534,8 @@ UniValue getmemoryinfo(const JSONRPCRequest& request)
     if (mode == "stats") {
         UniValue obj(UniValue::VOBJ);
         obj.push_back(Pair("locked", RPCLockedMemoryInfo()));
+        obj.push_back(Pair("sigcache", RPCCacheInfo(GetSignatureCacheStats())));
+        obj.push_back(Pair("scriptcache", RPCCacheInfo(GetScriptExecutionCacheStats())));
         return obj;
     } else if (mode == "mallocinfo") {
 #ifdef HAVE_MALLOC_INFO
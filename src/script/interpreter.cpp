@@ -10,8 +10,11 @@
 #include <crypto/sha256.h>
 #include <pubkey.h>
 #include <script/script.h>
+#include <streams.h>
 #include <uint256.h>
 
+#include <algorithm>
+
 typedef std::vector<unsigned char> valtype;
 
 namespace {
@@ -1176,6 +1179,9 @@ uint256 GetOutputsHash(const CTransaction& txTo) {
 
 } // namespace
 
+/** Size of an input in the legacy signature serialization with its script blanked. */
+static const size_t BLANKED_INPUT_SIZE = 36 + 1 + 4;
+
 PrecomputedTransactionData::PrecomputedTransactionData(const CTransaction& txTo)
 {
     // Cache is calculated only for transactions with witness
@@ -1185,8 +1191,76 @@ PrecomputedTransactionData::PrecomputedTransactionData(const CTransaction& txTo)
         hashOutputs = GetOutputsHash(txTo);
         ready = true;
     }
+
+    // Legacy SIGHASH_ALL hashes the whole transaction for every input, all of
+    // it the same apart from which input carries the scriptCode. Serialize the
+    // common form once, and remember the hash state at the start of each input
+    // so only that input and what follows it are hashed per signature.
+    const bool fLegacyInputs = std::any_of(txTo.vin.begin(), txTo.vin.end(), [](const CTxIn& txin) { return txin.scriptWitness.IsNull(); });
+    if (txTo.IsCoinBase() || !fLegacyInputs) return;
+    CVectorWriter writer(SER_GETHASH, 0, legacyBlankedTx, 0);
+    writer << txTo.nVersion;
+    WriteCompactSize(writer, txTo.vin.size());
+    legacyInputsOffset = legacyBlankedTx.size();
+    for (const auto& txin : txTo.vin) {
+        writer << txin.prevout << CScript() << txin.nSequence;
+    }
+    writer << txTo.vout << txTo.nLockTime;
+
+    legacyMidstates.reserve(txTo.vin.size());
+    CSHA256 sha;
+    sha.Write(legacyBlankedTx.data(), legacyInputsOffset);
+    for (size_t i = 0; i < txTo.vin.size(); ++i) {
+        legacyMidstates.push_back(sha);
+        sha.Write(legacyBlankedTx.data() + legacyInputsOffset + BLANKED_INPUT_SIZE * i, BLANKED_INPUT_SIZE);
+    }
+    legacyReady = true;
+}
+
+namespace {
+
+/** Serialize into a running SHA256 (the first half of CHashWriter). */
+class CSHA256Writer
+{
+private:
+    CSHA256& sha;
+
+public:
+    explicit CSHA256Writer(CSHA256& shaIn) : sha(shaIn) {}
+    int GetType() const { return SER_GETHASH; }
+    int GetVersion() const { return 0; }
+    void write(const char* pch, size_t size) { sha.Write((const unsigned char*)pch, size); }
+
+    template<typename T>
+    CSHA256Writer& operator<<(const T& obj)
+    {
+        ::Serialize(*this, obj);
+        return *this;
+    }
+};
+
+/** SignatureHash for legacy SIGHASH_ALL from the precomputed blanked transaction. */
+uint256 LegacySignatureHashAll(const CScript& scriptCode, const CTransaction& txTo, unsigned int nIn, int nHashType, const PrecomputedTransactionData& cache)
+{
+    const unsigned char* input = cache.legacyBlankedTx.data() + cache.legacyInputsOffset + BLANKED_INPUT_SIZE * nIn;
+    const unsigned char* end = cache.legacyBlankedTx.data() + cache.legacyBlankedTx.size();
+    CSHA256 sha = cache.legacyMidstates[nIn];
+    CSHA256Writer writer(sha);
+    // The prevout, then the scriptCode in place of the blank script
+    sha.Write(input, 36);
+    CTransactionSignatureSerializer(txTo, scriptCode, nIn, nHashType).SerializeScriptCode(writer);
+    // This input's nSequence, the remaining inputs, the outputs and nLockTime
+    sha.Write(input + 37, end - (input + 37));
+    writer << nHashType;
+
+    uint256 hash;
+    sha.Finalize(hash.begin());
+    sha.Reset().Write(hash.begin(), CSHA256::OUTPUT_SIZE).Finalize(hash.begin());
+    return hash;
 }
 
+} // namespace
+
 uint256 SignatureHash(const CScript& scriptCode, const CTransaction& txTo, unsigned int nIn, int nHashType, const CAmount& amount, SigVersion sigversion, const PrecomputedTransactionData* cache)
 {
     assert(nIn < txTo.vin.size());
@@ -1247,6 +1321,11 @@ uint256 SignatureHash(const CScript& scriptCode, const CTransaction& txTo, unsig
         }
     }
 
+    if (cache && cache->legacyReady && !(nHashType & SIGHASH_ANYONECANPAY) &&
+        (nHashType & 0x1f) != SIGHASH_SINGLE && (nHashType & 0x1f) != SIGHASH_NONE) {
+        return LegacySignatureHashAll(scriptCode, txTo, nIn, nHashType, *cache);
+    }
+
     // Wrapper to serialize only the necessary parts of the transaction being signed
     CTransactionSignatureSerializer txTmp(txTo, scriptCode, nIn, nHashType);
 
@@ -6,6 +6,7 @@
 #ifndef BITCOIN_SCRIPT_INTERPRETER_H
 #define BITCOIN_SCRIPT_INTERPRETER_H
 
+#include <crypto/sha256.h>
 #include <script/script_error.h>
 #include <primitives/transaction.h>
 
@@ -124,6 +125,13 @@ struct PrecomputedTransactionData
     uint256 hashPrevouts, hashSequence, hashOutputs;
     bool ready = false;
 
+    /** For legacy SIGHASH_ALL: the transaction as signed with every scriptSig
+     *  blanked, and the SHA256 state after the part preceding each input. */
+    std::vector<unsigned char> legacyBlankedTx;
+    std::vector<CSHA256> legacyMidstates;
+    size_t legacyInputsOffset = 0;
+    bool legacyReady = false;
+
     explicit PrecomputedTransactionData(const CTransaction& tx);
 };
 
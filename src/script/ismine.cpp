@@ -15,10 +15,14 @@ typedef std::vector<unsigned char> valtype;
 
 unsigned int HaveKeys(const std::vector<valtype>& pubkeys, const CKeyStore& keystore)
 {
-    unsigned int nResult = 0;
+    std::vector<CPubKey> vPubKeys;
+    vPubKeys.reserve(pubkeys.size());
     for (const valtype& pubkey : pubkeys)
+        vPubKeys.emplace_back(pubkey);
+
+    unsigned int nResult = 0;
+    for (const CKeyID& keyID : CPubKey::GetIDs(vPubKeys))
     {
-        CKeyID keyID = CPubKey(pubkey).GetID();
         if (keystore.HaveKey(keyID))
             ++nResult;
     }
@@ -12,7 +12,141 @@
 #include <util.h>
 
 #include <cuckoocache.h>
-#include <boost/thread.hpp>
+
+#include <algorithm>
+
+CShardedCache::CShardedCache()
+    : id([] { static std::atomic<size_t> next_id{0}; return next_id++; }())
+{
+}
+
+uint64_t CShardedCache::setup_bytes(size_t bytes)
+{
+    {
+        std::lock_guard<std::mutex> lock(cs_buffers);
+        for (const std::shared_ptr<Buffer>& buffer : buffers) {
+            std::lock_guard<std::mutex> buffer_lock(buffer->cs);
+            buffer->entries.clear();
+        }
+    }
+    capacity = 0;
+    for (Shard& shard : shards) {
+        boost::unique_lock<boost::shared_mutex> lock(shard.cs);
+        capacity += shard.cache.setup_bytes(bytes / SHARDS);
+    }
+    return capacity;
+}
+
+CShardedCache::Buffer& CShardedCache::LocalBuffer()
+{
+    // Indexed by cache id
+    static thread_local std::vector<std::shared_ptr<Buffer>> local_buffers;
+    if (local_buffers.size() <= id) local_buffers.resize(id + 1);
+    std::shared_ptr<Buffer>& buffer = local_buffers[id];
+    if (!buffer) {
+        buffer = std::make_shared<Buffer>();
+        std::lock_guard<std::mutex> lock(cs_buffers);
+        buffers.push_back(buffer);
+    }
+    return *buffer;
+}
+
+bool CShardedCache::Contains(const uint256& entry, bool erase)
+{
+    Shard& shard = GetShard(entry);
+    bool found;
+    {
+        boost::shared_lock<boost::shared_mutex> lock(shard.cs);
+        found = shard.cache.contains(entry, erase);
+    }
+    Buffer& buffer = LocalBuffer();
+    if (!found) {
+        // Entries this thread inserted but has not written out yet
+        std::lock_guard<std::mutex> lock(buffer.cs);
+        found = buffer.entries.count(entry) != 0;
+    }
+    std::atomic<uint64_t>& counter = found ? buffer.hits : buffer.misses;
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    return found;
+}
+
+void CShardedCache::Insert(const uint256& entry)
+{
+    Buffer& buffer = LocalBuffer();
+    std::vector<uint256> entries;
+    {
+        std::lock_guard<std::mutex> lock(buffer.cs);
+        buffer.entries.insert(entry);
+        if (buffer.entries.size() < INSERT_BUFFER_SIZE) return;
+        entries.assign(buffer.entries.begin(), buffer.entries.end());
+        buffer.entries.clear();
+    }
+    Write(entries);
+}
+
+void CShardedCache::Flush()
+{
+    std::vector<uint256> entries;
+    {
+        std::lock_guard<std::mutex> lock(cs_buffers);
+        // Buffers only referenced from here belong to threads that have exited
+        for (auto it = buffers.begin(); it != buffers.end();) {
+            {
+                std::lock_guard<std::mutex> buffer_lock((*it)->cs);
+                entries.insert(entries.end(), (*it)->entries.begin(), (*it)->entries.end());
+                (*it)->entries.clear();
+            }
+            if (it->use_count() == 1) {
+                retired_hits += (*it)->hits;
+                retired_misses += (*it)->misses;
+                it = buffers.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    Write(entries);
+}
+
+void CShardedCache::Write(std::vector<uint256>& entries)
+{
+    // Group the entries by shard, so each shard is only written to once
+    std::sort(entries.begin(), entries.end(), [](const uint256& a, const uint256& b) { return *a.begin() % SHARDS < *b.begin() % SHARDS; });
+    for (auto begin = entries.begin(); begin != entries.end();) {
+        Shard& shard = GetShard(*begin);
+        auto end = std::find_if(begin, entries.end(), [&](const uint256& entry) { return &GetShard(entry) != &shard; });
+        uint64_t evictions = 0;
+        {
+            boost::unique_lock<boost::shared_mutex> lock(shard.cs);
+            for (auto it = begin; it != end; ++it) {
+                evictions += shard.cache.insert(*it);
+            }
+        }
+        shard.inserts += end - begin;
+        shard.evictions += evictions;
+        begin = end;
+    }
+}
+
+CacheStats CShardedCache::GetStats()
+{
+    CacheStats stats;
+    {
+        std::lock_guard<std::mutex> lock(cs_buffers);
+        stats.hits = retired_hits;
+        stats.misses = retired_misses;
+        for (const std::shared_ptr<Buffer>& buffer : buffers) {
+            stats.hits += buffer->hits;
+            stats.misses += buffer->misses;
+        }
+    }
+    for (const Shard& shard : shards) {
+        stats.inserts += shard.inserts;
+        stats.evictions += shard.evictions;
+    }
+    stats.capacity = capacity;
+    return stats;
+}
 
 namespace {
 /**
@@ -25,9 +159,7 @@ class CSignatureCache
 private:
      //! Entries are SHA256(nonce || signature hash || public key || signature):
     uint256 nonce;
-    typedef CuckooCache::cache<uint256, SignatureCacheHasher> map_type;
-    map_type setValid;
-    boost::shared_mutex cs_sigcache;
+    CShardedCache setValid;
 
 public:
     CSignatureCache()
@@ -44,19 +176,25 @@ public:
     bool
     Get(const uint256& entry, const bool erase)
     {
-        boost::shared_lock<boost::shared_mutex> lock(cs_sigcache);
-        return setValid.contains(entry, erase);
+        return setValid.Contains(entry, erase);
     }
 
-    void Set(uint256& entry)
+    void Set(const uint256& entry)
     {
-        boost::unique_lock<boost::shared_mutex> lock(cs_sigcache);
-        setValid.insert(entry);
+        setValid.Insert(entry);
     }
-    uint32_t setup_bytes(size_t n)
+    uint64_t setup_bytes(size_t n)
     {
         return setValid.setup_bytes(n);
     }
+    void Flush()
+    {
+        setValid.Flush();
+    }
+    CacheStats GetStats()
+    {
+        return setValid.GetStats();
+    }
 };
 
 /* In previous versions of this code, signatureCache was a local static variable
@@ -80,15 +218,60 @@ void InitSignatureCache()
             (nElems*sizeof(uint256)) >>20, (nMaxCacheSize*2)>>20, nElems);
 }
 
+void FlushSignatureCache()
+{
+    signatureCache.Flush();
+}
+
+CacheStats GetSignatureCacheStats()
+{
+    return signatureCache.GetStats();
+}
+
 bool CachingTransactionSignatureChecker::VerifySignature(const std::vector<unsigned char>& vchSig, const CPubKey& pubkey, const uint256& sighash) const
 {
     uint256 entry;
     signatureCache.ComputeEntry(entry, sighash, vchSig, pubkey);
     if (signatureCache.Get(entry, !store))
         return true;
+    if (batch) {
+        batch->Add(vchSig, pubkey, sighash, entry, store);
+        return true;
+    }
     if (!TransactionSignatureChecker::VerifySignature(vchSig, pubkey, sighash))
         return false;
     if (store)
         signatureCache.Set(entry);
     return true;
 }
+
+void CSignatureBatch::Add(const std::vector<unsigned char>& vchSig, const CPubKey& pubkey, const uint256& sighash, const uint256& entry, bool store)
+{
+    pubkeys.push_back(pubkey);
+    hashes.push_back(sighash);
+    sigs.push_back(vchSig);
+    entries.push_back(entry);
+    stores.push_back(store);
+}
+
+void CSignatureBatch::Truncate(size_t n)
+{
+    if (n >= size()) return;
+    pubkeys.resize(n);
+    hashes.resize(n);
+    sigs.resize(n);
+    entries.resize(n);
+    stores.resize(n);
+}
+
+bool CSignatureBatch::Verify(std::vector<bool>* results)
+{
+    std::vector<bool> valid;
+    bool fAllValid = CPubKey::VerifyBatch(pubkeys, hashes, sigs, &valid);
+    for (size_t i = 0; i < size(); ++i) {
+        if (valid[i] && stores[i])
+            signatureCache.Set(entries[i]);
+    }
+    if (results) results->swap(valid);
+    return fAllValid;
+}
@@ -6,10 +6,18 @@
 #ifndef BITCOIN_SCRIPT_SIGCACHE_H
 #define BITCOIN_SCRIPT_SIGCACHE_H
 
+#include <cuckoocache.h>
+#include <pubkey.h>
 #include <script/interpreter.h>
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
 #include <vector>
 
+#include <boost/thread/shared_mutex.hpp>
+
 // DoS prevention: limit cache size to 32MB (over 1000000 entries on 64-bit
 // systems). Due to how we count cache size, actual memory usage is slightly
 // more (~32.25 MB)
@@ -17,8 +25,6 @@ static const unsigned int DEFAULT_MAX_SIG_CACHE_SIZE = 32;
 // Maximum sig cache size allowed
 static const int64_t MAX_MAX_SIG_CACHE_SIZE = 16384;
 
-class CPubKey;
-
 /**
  * We're hashing a nonce into the entries themselves, so we don't need extra
  * blinding in the set hash computation.
@@ -40,17 +46,136 @@ public:
     }
 };
 
+/** Usage counters of a CShardedCache, see getmemoryinfo */
+struct CacheStats
+{
+    //! Lookups that found / did not find the entry
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    //! Entries written to the cache, and live entries dropped to make room
+    uint64_t inserts = 0;
+    uint64_t evictions = 0;
+    //! Number of entries the cache can hold
+    uint64_t capacity = 0;
+};
+
+/**
+ * The signature and script execution caches: CuckooCaches split into shards.
+ *
+ * Each shard has its own lock: lookups share it, even erasing ones, as those
+ * only set an atomic flag in the CuckooCache, while writes take it
+ * exclusively. Inserts go to a buffer owned by the calling
+ * thread, and are only written to the shards, in bulk, once the buffer fills
+ * up or on Flush(). Until then only lookups from the same thread find them;
+ * for other threads that merely costs a cache miss.
+ */
+class CShardedCache
+{
+public:
+    static const unsigned int SHARDS = 16;
+    static const size_t INSERT_BUFFER_SIZE = 256;
+
+    CShardedCache();
+
+    /** Set up the shards to use about bytes in total, dropping buffered inserts. Returns the capacity. */
+    uint64_t setup_bytes(size_t bytes);
+
+    /** Whether entry is in the cache. If erase, it is marked as discardable when found. */
+    bool Contains(const uint256& entry, bool erase);
+    void Insert(const uint256& entry);
+    /** Write the buffered inserts of all threads to the shards */
+    void Flush();
+
+    CacheStats GetStats();
+
+private:
+    struct Shard
+    {
+        boost::shared_mutex cs;
+        CuckooCache::cache<uint256, SignatureCacheHasher> cache;
+        std::atomic<uint64_t> inserts{0};
+        std::atomic<uint64_t> evictions{0};
+    };
+
+    struct EntryHasher
+    {
+        size_t operator()(const uint256& entry) const { return entry.GetCheapHash(); }
+    };
+
+    //! Inserts and lookup counts of one thread
+    struct Buffer
+    {
+        std::mutex cs;
+        std::unordered_set<uint256, EntryHasher> entries;
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> misses{0};
+    };
+
+    const size_t id;
+    Shard shards[SHARDS];
+    uint64_t capacity = 0;
+    std::mutex cs_buffers;
+    std::vector<std::shared_ptr<Buffer>> buffers;
+    //! Counts of threads that have exited
+    uint64_t retired_hits = 0;
+    uint64_t retired_misses = 0;
+
+    Shard& GetShard(const uint256& entry) { return shards[*entry.begin() % SHARDS]; }
+    Buffer& LocalBuffer();
+    void Write(std::vector<uint256>& entries);
+};
+
+/**
+ * Signature checks deferred by CachingTransactionSignatureChecker, so that
+ * they can be verified together with CPubKey::VerifyBatch. Signatures that
+ * are found in the signature cache are never deferred.
+ */
+class CSignatureBatch
+{
+private:
+    std::vector<CPubKey> pubkeys;
+    std::vector<uint256> hashes;
+    std::vector<std::vector<unsigned char>> sigs;
+    //! Signature cache entries, and whether to store them once verified
+    std::vector<uint256> entries;
+    std::vector<bool> stores;
+
+public:
+    void Add(const std::vector<unsigned char>& vchSig, const CPubKey& pubkey, const uint256& sighash, const uint256& entry, bool store);
+
+    /** Drop all checks deferred after the first n */
+    void Truncate(size_t n);
+
+    /**
+     * Verify all deferred checks, storing the valid ones in the signature
+     * cache where requested. Returns whether all of them are valid; the
+     * individual results are stored in results if given.
+     */
+    bool Verify(std::vector<bool>* results = nullptr);
+
+    size_t size() const { return hashes.size(); }
+};
+
 class CachingTransactionSignatureChecker : public TransactionSignatureChecker
 {
 private:
     bool store;
+    CSignatureBatch* batch;
 
 public:
-    CachingTransactionSignatureChecker(const CTransaction* txToIn, unsigned int nInIn, const CAmount& amountIn, bool storeIn, PrecomputedTransactionData& txdataIn) : TransactionSignatureChecker(txToIn, nInIn, amountIn, txdataIn), store(storeIn) {}
+    /**
+     * If batch is given, signatures that are not in the cache are assumed to
+     * be valid and deferred to it. The outcome of a script evaluated that way
+     * only holds if all of its deferred signatures turn out to be valid.
+     */
+    CachingTransactionSignatureChecker(const CTransaction* txToIn, unsigned int nInIn, const CAmount& amountIn, bool storeIn, PrecomputedTransactionData& txdataIn, CSignatureBatch* batchIn = nullptr) : TransactionSignatureChecker(txToIn, nInIn, amountIn, txdataIn), store(storeIn), batch(batchIn) {}
 
     bool VerifySignature(const std::vector<unsigned char>& vchSig, const CPubKey& vchPubKey, const uint256& sighash) const override;
 };
 
 void InitSignatureCache();
+/** Make inserts into the signature cache by all threads visible */
+void FlushSignatureCache();
+CacheStats GetSignatureCacheStats();
 
 #endif // BITCOIN_SCRIPT_SIGCACHE_H
@@ -0,0 +1,41 @@
+#ifndef SECP256K1_BATCH_H
+#define SECP256K1_BATCH_H
+
+#include "secp256k1.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Verify a batch of ECDSA signatures.
+ *
+ *  Returns: 1: all signatures are correct
+ *           0: at least one signature is incorrect or unparseable
+ *  Args:    ctx:       a secp256k1 context object, initialized for verification.
+ *  Out:     results:   an array of n ints, set to 1 for each correct signature and
+ *                      to 0 for each incorrect one (can be NULL)
+ *  In:      sigs:      an array of n pointers to the signatures being verified
+ *           msgs32:    an array of n pointers to the 32-byte message hashes
+ *           pubkeys:   an array of n pointers to initialized public keys
+ *           n:         the number of signatures
+ *
+ * The result for each signature is the same as that of secp256k1_ecdsa_verify,
+ * so only lower-S signatures are accepted. ECDSA signatures do not commit to
+ * the full R point, so they cannot be checked with a single multi-scalar
+ * multiplication; instead the inversions of s, which take a sizable part of
+ * each verification, are shared across the batch.
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_ecdsa_verify_batch(
+    const secp256k1_context* ctx,
+    int *results,
+    const secp256k1_ecdsa_signature * const *sigs,
+    const unsigned char * const *msgs32,
+    const secp256k1_pubkey * const *pubkeys,
+    size_t n
+) SECP256K1_ARG_NONNULL(1);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SECP256K1_BATCH_H */
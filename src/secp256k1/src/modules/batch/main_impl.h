@@ -0,0 +1,70 @@
+/**********************************************************************
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+#ifndef SECP256K1_MODULE_BATCH_MAIN_H
+#define SECP256K1_MODULE_BATCH_MAIN_H
+
+#include "include/secp256k1_batch.h"
+
+/** Number of signatures whose s values are inverted together. */
+#define SECP256K1_BATCH_CHUNK 64
+
+int secp256k1_ecdsa_verify_batch(const secp256k1_context* ctx, int *results, const secp256k1_ecdsa_signature * const *sigs, const unsigned char * const *msgs32, const secp256k1_pubkey * const *pubkeys, size_t n) {
+    secp256k1_scalar r[SECP256K1_BATCH_CHUNK], sinv[SECP256K1_BATCH_CHUNK], acc[SECP256K1_BATCH_CHUNK];
+    secp256k1_scalar s, m, inv;
+    secp256k1_ge q;
+    int ok[SECP256K1_BATCH_CHUNK];
+    int all = 1;
+    size_t begin, i, len;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(n == 0 || (sigs != NULL && msgs32 != NULL && pubkeys != NULL));
+
+    for (begin = 0; begin < n; begin += len) {
+        len = n - begin < SECP256K1_BATCH_CHUNK ? n - begin : SECP256K1_BATCH_CHUNK;
+
+        /* Load the signatures, and accumulate the products of all usable s
+         * values, substituting 1 for the ones that are rejected up front. */
+        secp256k1_scalar_set_int(&inv, 1);
+        for (i = 0; i < len; i++) {
+            ARG_CHECK(sigs[begin + i] != NULL);
+            secp256k1_ecdsa_signature_load(ctx, &r[i], &s, sigs[begin + i]);
+            ok[i] = !secp256k1_scalar_is_zero(&r[i]) && !secp256k1_scalar_is_zero(&s) && !secp256k1_scalar_is_high(&s);
+            if (!ok[i]) {
+                secp256k1_scalar_set_int(&s, 1);
+            }
+            sinv[i] = s;
+            acc[i] = inv;
+            secp256k1_scalar_mul(&inv, &inv, &s);
+        }
+
+        /* One inversion for the whole chunk (Montgomery's trick): walking back,
+         * inv is the inverse of the product of the first i + 1 values. */
+        secp256k1_scalar_inverse_var(&inv, &inv);
+        for (i = len; i-- > 0;) {
+            s = sinv[i];
+            secp256k1_scalar_mul(&sinv[i], &inv, &acc[i]);
+            secp256k1_scalar_mul(&inv, &inv, &s);
+        }
+
+        for (i = 0; i < len; i++) {
+            ARG_CHECK(msgs32[begin + i] != NULL);
+            ARG_CHECK(pubkeys[begin + i] != NULL);
+            if (ok[i]) {
+                secp256k1_scalar_set_b32(&m, msgs32[begin + i], NULL);
+                ok[i] = secp256k1_pubkey_load(ctx, &q, pubkeys[begin + i]) &&
+                        secp256k1_ecdsa_sig_verify_inv(&ctx->ecmult_ctx, &r[i], &sinv[i], &q, &m);
+            }
+            all &= ok[i];
+            if (results != NULL) {
+                results[begin + i] = ok[i];
+            }
+        }
+    }
+    return all;
+}
+
+#endif /* SECP256K1_MODULE_BATCH_MAIN_H */
@@ -0,0 +1,75 @@
+/**********************************************************************
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+#ifndef SECP256K1_MODULE_BATCH_TESTS_H
+#define SECP256K1_MODULE_BATCH_TESTS_H
+
+#define BATCH_TEST_MAX 150
+
+void test_ecdsa_verify_batch(size_t n) {
+    secp256k1_ecdsa_signature sigs[BATCH_TEST_MAX];
+    secp256k1_pubkey pubkeys[BATCH_TEST_MAX];
+    unsigned char msgs[BATCH_TEST_MAX][32];
+    const secp256k1_ecdsa_signature *psigs[BATCH_TEST_MAX] = {0};
+    const unsigned char *pmsgs[BATCH_TEST_MAX] = {0};
+    const secp256k1_pubkey *ppubkeys[BATCH_TEST_MAX] = {0};
+    int results[BATCH_TEST_MAX] = {0};
+    int expected = 1;
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+        unsigned char privkey[32];
+        secp256k1_scalar key;
+        random_scalar_order_test(&key);
+        secp256k1_scalar_get_b32(privkey, &key);
+        secp256k1_rand256_test(msgs[i]);
+        CHECK(secp256k1_ec_pubkey_create(ctx, &pubkeys[i], privkey) == 1);
+        CHECK(secp256k1_ecdsa_sign(ctx, &sigs[i], msgs[i], privkey, NULL, NULL) == 1);
+        switch (secp256k1_rand_int(16)) {
+        case 0:
+            /* Wrong message */
+            msgs[i][secp256k1_rand_int(32)] ^= 1 + secp256k1_rand_int(255);
+            break;
+        case 1: {
+            /* High S */
+            secp256k1_scalar r, s;
+            secp256k1_ecdsa_signature_load(ctx, &r, &s, &sigs[i]);
+            secp256k1_scalar_negate(&s, &s);
+            secp256k1_ecdsa_signature_save(&sigs[i], &r, &s);
+            break;
+        }
+        case 2:
+            /* Zero signature */
+            memset(&sigs[i], 0, sizeof(sigs[i]));
+            break;
+        case 3:
+            /* Someone else's key */
+            if (i > 0) {
+                pubkeys[i] = pubkeys[i - 1];
+            }
+            break;
+        }
+        psigs[i] = &sigs[i];
+        pmsgs[i] = msgs[i];
+        ppubkeys[i] = &pubkeys[i];
+    }
+
+    CHECK(secp256k1_ecdsa_verify_batch(ctx, results, psigs, pmsgs, ppubkeys, n) == secp256k1_ecdsa_verify_batch(ctx, NULL, psigs, pmsgs, ppubkeys, n));
+    for (i = 0; i < n; i++) {
+        CHECK(results[i] == secp256k1_ecdsa_verify(ctx, &sigs[i], msgs[i], &pubkeys[i]));
+        expected &= results[i];
+    }
+    CHECK(secp256k1_ecdsa_verify_batch(ctx, NULL, psigs, pmsgs, ppubkeys, n) == expected);
+}
+
+void run_batch_tests(void) {
+    int i;
+    test_ecdsa_verify_batch(0);
+    for (i = 0; i < count; i++) {
+        test_ecdsa_verify_batch(1 + secp256k1_rand_int(BATCH_TEST_MAX));
+    }
+}
+
+#endif /* SECP256K1_MODULE_BATCH_TESTS_H */
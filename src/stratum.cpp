@@ -0,0 +1,734 @@
+// Copyright (c) 2024 The NoteCoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <stratum.h>
+
+#include <arith_uint256.h>
+#include <base58.h>
+#include <chainparams.h>
+#include <crypto/common.h>
+#include <kawpow/header_hasher.h>
+#include <miner.h>
+#include <netbase.h>
+#include <primitives/block.h>
+#include <script/standard.h>
+#include <sync.h>
+#include <ui_interface.h>
+#include <univalue.h>
+#include <util.h>
+#include <utilstrencodings.h>
+#include <utiltime.h>
+#include <validation.h>
+#include <validationinterface.h>
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <set>
+#include <thread>
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+#include <event2/buffer.h>
+#include <event2/bufferevent.h>
+#include <event2/event.h>
+#include <event2/listener.h>
+#include <event2/thread.h>
+#include <event2/util.h>
+
+/** Maximum length of a line received from a miner */
+static const size_t MAX_STRATUM_LINE_LENGTH = 16384;
+/** Number of recent jobs a share may still be submitted against */
+static const size_t MAX_STRATUM_JOBS = 8;
+/** Minimum time between templates rebuilt for mempool changes only, in seconds */
+static const int STRATUM_MEMPOOL_REFRESH = 5;
+/** Shares of one client that may wait for full verification at once */
+static const size_t MAX_STRATUM_PENDING_SHARES = 16;
+/** Shares of one client sent to full verification per second */
+static const int MAX_STRATUM_SHARES_PER_SECOND = 20;
+/** Shares of all clients that may wait for full verification at once */
+static const size_t MAX_STRATUM_VERIFY_QUEUE = 256;
+
+/**
+ * One block template handed out to miners. The coinbase and the merkle root
+ * are fixed when the job is built: KawPoW miners only vary the 64-bit nonce,
+ * so there is no extranonce to roll into the coinbase and nothing to
+ * recompute per share.
+ */
+struct StratumJob
+{
+    std::string id;
+    std::shared_ptr<CBlock> block;
+    std::unique_ptr<kawpow::HeaderHasher> hasher;
+    uint256 header_hash;
+    arith_uint256 block_target;
+    arith_uint256 share_target;
+    /** Nonces of shares already accepted for this job */
+    std::set<uint64_t> nonces;
+};
+
+class StratumServer;
+
+struct StratumClient
+{
+    StratumServer* server;
+    struct bufferevent* bev;
+    std::string peer;
+    /** Unique per connection, so verified shares of a client that went away are dropped */
+    uint64_t id;
+    /** Top 16 bits of every nonce this client submits */
+    uint16_t nonce_prefix;
+    bool subscribed;
+    bool authorized;
+    /** Shares waiting for full verification */
+    size_t nPendingShares;
+    /** Second in which nSharesInWindow shares were sent to full verification */
+    int64_t nShareWindow;
+    int nSharesInWindow;
+};
+
+/**
+ * A share whose claimed mix hash meets the share target. Recomputing the mix
+ * costs a few thousand DAG item derivations, so it is done on the share
+ * verification thread rather than the event thread.
+ */
+struct ShareCheck
+{
+    uint64_t client_id;
+    UniValue request_id;
+    std::shared_ptr<StratumJob> job;
+    uint64_t nNonce;
+    uint256 mix_hash;
+    /** Results, set by the verification thread */
+    bool fValid;
+    bool fBlockRejected;
+};
+
+/**
+ * Keeps the current jobs and the miner connections. Everything runs on the
+ * stratum event thread, except the full verification of shares.
+ */
+class StratumServer : public CValidationInterface
+{
+public:
+    StratumServer(struct event_base* base, const CScript& script, const arith_uint256& share_limit, const std::string& password);
+    ~StratumServer();
+
+    bool Bind(const CService& addr);
+    void StartVerifier();
+    void StopVerifier();
+
+protected:
+    void UpdatedBlockTip(const CBlockIndex* pindexNew, const CBlockIndex* pindexFork, bool fInitialDownload) override;
+    void TransactionAddedToMempool(const CTransactionRef& ptx) override;
+
+private:
+    struct event_base* base;
+    struct evconnlistener* listener;
+    /** Raised from the validation interface thread to wake the event loop */
+    struct event* update_ev;
+    /** Delays mempool-only template refreshes */
+    struct event* refresh_ev;
+    /** Raised from the share verification thread when results are ready */
+    struct event* verified_ev;
+
+    CScript coinbase_script;
+    arith_uint256 share_limit;
+    /** Required by mining.authorize when not empty */
+    std::string password;
+    unsigned int nExtraNonce;
+    uint32_t nJobCounter;
+    uint16_t nNextNoncePrefix;
+    uint64_t nNextClientId;
+    int64_t nLastTemplateTime;
+
+    std::atomic<bool> fNewTip;
+    std::atomic<bool> fMempoolChanged;
+
+    std::deque<std::shared_ptr<StratumJob>> jobs;
+    std::set<StratumClient*> clients;
+
+    CWaitableCriticalSection cs_verify;
+    CConditionVariable cond_verify;
+    std::deque<ShareCheck> verify_queue;
+    std::deque<ShareCheck> verified;
+    bool fStopVerify;
+    std::thread verifyThread;
+
+    void Update();
+    bool BuildJob(bool fClean);
+    void SendJob(StratumClient* client, const StratumJob& job, bool fClean);
+    void Notify(StratumClient* client, const std::string& method, const UniValue& params);
+    void Send(StratumClient* client, const UniValue& msg);
+    void Reply(StratumClient* client, const UniValue& id, const UniValue& result, int code = 0, const std::string& message = "");
+    void HandleLine(StratumClient* client, const std::string& line);
+    void HandleSubmit(StratumClient* client, const UniValue& id, const UniValue& params);
+    void HandleVerified();
+    void ThreadVerifyShares();
+    StratumClient* FindClient(uint64_t id);
+    void Disconnect(StratumClient* client);
+
+    /** Libevent handlers: internal */
+    static void acceptcb(struct evconnlistener* listener, evutil_socket_t fd, struct sockaddr* addr, int socklen, void* arg);
+    static void readcb(struct bufferevent* bev, void* ctx);
+    static void eventcb(struct bufferevent* bev, short what, void* ctx);
+    static void update_cb(evutil_socket_t fd, short what, void* arg);
+    static void verified_cb(evutil_socket_t fd, short what, void* arg);
+};
+
+StratumServer::StratumServer(struct event_base* _base, const CScript& script, const arith_uint256& _share_limit, const std::string& _password) :
+    base(_base), listener(nullptr), coinbase_script(script), share_limit(_share_limit), password(_password),
+    nExtraNonce(0), nJobCounter(0), nNextNoncePrefix(0), nNextClientId(0), nLastTemplateTime(0),
+    fNewTip(true), fMempoolChanged(false), fStopVerify(false)
+{
+    update_ev = event_new(base, -1, 0, update_cb, this);
+    refresh_ev = evtimer_new(base, update_cb, this);
+    verified_ev = event_new(base, -1, 0, verified_cb, this);
+}
+
+StratumServer::~StratumServer()
+{
+    for (StratumClient* client : clients) {
+        bufferevent_free(client->bev);
+        delete client;
+    }
+    clients.clear();
+    if (listener)
+        evconnlistener_free(listener);
+    event_free(verified_ev);
+    event_free(refresh_ev);
+    event_free(update_ev);
+}
+
+bool StratumServer::Bind(const CService& addr)
+{
+    struct sockaddr_storage addrbind;
+    socklen_t addrlen = sizeof(addrbind);
+    if (!addr.GetSockAddr((struct sockaddr*)&addrbind, &addrlen))
+        return false;
+    listener = evconnlistener_new_bind(base, acceptcb, this, LEV_OPT_CLOSE_ON_FREE | LEV_OPT_REUSEABLE, -1,
+                                       (struct sockaddr*)&addrbind, addrlen);
+    if (!listener)
+        return false;
+    // Hand out the first job as soon as the loop runs
+    event_active(update_ev, 0, 0);
+    return true;
+}
+
+void StratumServer::StartVerifier()
+{
+    verifyThread = std::thread(&TraceThread<std::function<void()> >, "stratumverify", std::function<void()>(std::bind(&StratumServer::ThreadVerifyShares, this)));
+}
+
+void StratumServer::StopVerifier()
+{
+    {
+        WaitableLock lock(cs_verify);
+        fStopVerify = true;
+    }
+    cond_verify.notify_all();
+    verifyThread.join();
+}
+
+void StratumServer::UpdatedBlockTip(const CBlockIndex* pindexNew, const CBlockIndex* pindexFork, bool fInitialDownload)
+{
+    fNewTip = true;
+    event_active(update_ev, 0, 0);
+}
+
+void StratumServer::TransactionAddedToMempool(const CTransactionRef& ptx)
+{
+    fMempoolChanged = true;
+    event_active(update_ev, 0, 0);
+}
+
+void StratumServer::update_cb(evutil_socket_t fd, short what, void* arg)
+{
+    static_cast<StratumServer*>(arg)->Update();
+}
+
+void StratumServer::Update()
+{
+    if (fNewTip.exchange(false)) {
+        fMempoolChanged = false;
+        evtimer_del(refresh_ev);
+        BuildJob(true);
+        return;
+    }
+    if (!fMempoolChanged)
+        return;
+
+    // New transactions only add fees: batch them instead of rebuilding the
+    // template (and making every miner switch jobs) for each one.
+    int64_t nWait = nLastTemplateTime + STRATUM_MEMPOOL_REFRESH - GetTime();
+    if (nWait > 0) {
+        if (!evtimer_pending(refresh_ev, nullptr)) {
+            struct timeval tv = {(long)nWait, 0};
+            evtimer_add(refresh_ev, &tv);
+        }
+        return;
+    }
+    fMempoolChanged = false;
+    BuildJob(false);
+}
+
+bool StratumServer::BuildJob(bool fClean)
+{
+    const CChainParams& chainparams = Params();
+    if (IsInitialBlockDownload() && !chainparams.MineBlocksOnDemand()) {
+        LogPrint(BCLog::STRATUM, "stratum: Still downloading blocks, not building a job\n");
+        return false;
+    }
+
+    std::unique_ptr<CBlockTemplate> pblocktemplate;
+    try {
+        if (g_template_updater)
+            pblocktemplate = g_template_updater->CreateNewBlock(coinbase_script);
+        else
+            pblocktemplate = BlockAssembler(chainparams).CreateNewBlock(coinbase_script);
+    } catch (const std::exception& e) {
+        LogPrintf("stratum: CreateNewBlock failed: %s\n", e.what());
+        return false;
+    }
+    if (!pblocktemplate)
+        return false;
+
+    auto job = std::make_shared<StratumJob>();
+    job->block = std::make_shared<CBlock>(pblocktemplate->block);
+    {
+        LOCK(cs_main);
+        // The tip moved while the template was assembled; the notification
+        // for it is already queued and will rebuild on the new tip.
+        if (chainActive.Tip()->GetBlockHash() != job->block->hashPrevBlock)
+            return false;
+        IncrementExtraNonce(job->block.get(), chainActive.Tip(), nExtraNonce);
+    }
+    nLastTemplateTime = GetTime();
+
+    job->id = strprintf("%x", ++nJobCounter);
+    job->hasher.reset(new kawpow::HeaderHasher(*job->block));
+    job->header_hash = job->block->GetKAWPOWHeaderHash();
+    bool fNegative, fOverflow;
+    job->block_target.SetCompact(job->block->nBits, &fNegative, &fOverflow);
+    job->share_target = std::max(job->block_target, share_limit);
+
+    if (fClean)
+        jobs.clear();
+    jobs.push_back(job);
+    while (jobs.size() > MAX_STRATUM_JOBS)
+        jobs.pop_front();
+
+    LogPrint(BCLog::STRATUM, "stratum: New job %s at height %u with %u transactions%s\n",
+        job->id, job->block->nHeight, job->block->vtx.size(), fClean ? " (new tip)" : "");
+    for (StratumClient* client : clients) {
+        if (client->authorized)
+            SendJob(client, *job, fClean);
+    }
+    return true;
+}
+
+void StratumServer::SendJob(StratumClient* client, const StratumJob& job, bool fClean)
+{
+    UniValue target(UniValue::VARR);
+    target.push_back(ArithToUint256(job.share_target).GetHex());
+    Notify(client, "mining.set_target", target);
+
+    const uint256 seed = progpow::GetEpochSeed(progpow::GetEpochNumber(job.block->nHeight));
+    UniValue params(UniValue::VARR);
+    params.push_back(job.id);
+    params.push_back(job.header_hash.GetHex());
+    params.push_back(HexStr(seed.begin(), seed.end()));
+    params.push_back(ArithToUint256(job.share_target).GetHex());
+    params.push_back(fClean);
+    params.push_back((int64_t)job.block->nHeight);
+    params.push_back(strprintf("%08x", job.block->nBits));
+    Notify(client, "mining.notify", params);
+}
+
+void StratumServer::Notify(StratumClient* client, const std::string& method, const UniValue& params)
+{
+    UniValue msg(UniValue::VOBJ);
+    msg.pushKV("id", NullUniValue);
+    msg.pushKV("method", method);
+    msg.pushKV("params", params);
+    Send(client, msg);
+}
+
+void StratumServer::Send(StratumClient* client, const UniValue& msg)
+{
+    std::string line = msg.write() + "\n";
+    bufferevent_write(client->bev, line.data(), line.size());
+}
+
+void StratumServer::Reply(StratumClient* client, const UniValue& id, const UniValue& result, int code, const std::string& message)
+{
+    UniValue reply(UniValue::VOBJ);
+    reply.pushKV("id", id);
+    if (code) {
+        UniValue error(UniValue::VARR);
+        error.push_back(code);
+        error.push_back(message);
+        error.push_back(NullUniValue);
+        reply.pushKV("result", NullUniValue);
+        reply.pushKV("error", error);
+    } else {
+        reply.pushKV("result", result);
+        reply.pushKV("error", NullUniValue);
+    }
+    Send(client, reply);
+}
+
+void StratumServer::HandleLine(StratumClient* client, const std::string& line)
+{
+    UniValue request;
+    if (!request.read(line) || !request.isObject()) {
+        LogPrint(BCLog::STRATUM, "stratum: Malformed request from %s\n", client->peer);
+        Disconnect(client);
+        return;
+    }
+    const UniValue& id = find_value(request, "id");
+    const UniValue& method = find_value(request, "method");
+    const UniValue& params = find_value(request, "params");
+    if (!method.isStr() || !params.isArray()) {
+        Reply(client, id, NullUniValue, 20, "Malformed request");
+        return;
+    }
+
+    const std::string& strMethod = method.get_str();
+    if (strMethod == "mining.subscribe") {
+        client->subscribed = true;
+        UniValue result(UniValue::VARR);
+        result.push_back(NullUniValue);
+        result.push_back(strprintf("%04x", client->nonce_prefix));
+        Reply(client, id, result);
+    } else if (strMethod == "mining.authorize") {
+        if (!client->subscribed) {
+            Reply(client, id, NullUniValue, 25, "Not subscribed");
+            return;
+        }
+        // [worker, password]
+        if (!password.empty() && (params.size() < 2 || !params[1].isStr() || !TimingResistantEqual(params[1].get_str(), password))) {
+            LogPrint(BCLog::STRATUM, "stratum: Wrong password from %s\n", client->peer);
+            Reply(client, id, NullUniValue, 24, "Unauthorized worker");
+            return;
+        }
+        client->authorized = true;
+        Reply(client, id, true);
+        if (!jobs.empty())
+            SendJob(client, *jobs.back(), true);
+    } else if (strMethod == "mining.submit") {
+        HandleSubmit(client, id, params);
+    } else {
+        Reply(client, id, NullUniValue, 20, "Method not found");
+    }
+}
+
+void StratumServer::HandleSubmit(StratumClient* client, const UniValue& id, const UniValue& params)
+{
+    if (!client->authorized) {
+        Reply(client, id, NullUniValue, 24, "Unauthorized worker");
+        return;
+    }
+    // [worker, job id, nonce, header hash, mix hash]
+    if (params.size() < 5 || !params[1].isStr() || !params[2].isStr() || !params[3].isStr() || !params[4].isStr()) {
+        Reply(client, id, NullUniValue, 20, "Invalid parameters");
+        return;
+    }
+
+    std::shared_ptr<StratumJob> job;
+    for (const auto& j : jobs) {
+        if (j->id == params[1].get_str())
+            job = j;
+    }
+    if (!job) {
+        Reply(client, id, NullUniValue, 21, "Job not found");
+        return;
+    }
+
+    std::string strNonce = params[2].get_str();
+    if (strNonce.compare(0, 2, "0x") == 0)
+        strNonce = strNonce.substr(2);
+    std::vector<unsigned char> vchNonce = ParseHex(strNonce);
+    if (strNonce.size() != 16 || vchNonce.size() != 8) {
+        Reply(client, id, NullUniValue, 20, "Invalid nonce");
+        return;
+    }
+    const uint64_t nNonce = ReadBE64(vchNonce.data());
+    if ((nNonce >> 48) != client->nonce_prefix) {
+        Reply(client, id, NullUniValue, 20, "Nonce outside of assigned range");
+        return;
+    }
+    if (uint256S(params[3].get_str()) != job->header_hash) {
+        Reply(client, id, NullUniValue, 20, "Header hash mismatch");
+        return;
+    }
+    if (job->nonces.count(nNonce)) {
+        Reply(client, id, NullUniValue, 22, "Duplicate share");
+        return;
+    }
+
+    // Cheap stage first: most bad shares fail on the claimed mix alone. The
+    // mix is the submitter's choice though, so passing proves nothing yet.
+    const uint256 mix_hash = uint256S(params[4].get_str());
+    uint256 hash;
+    job->hasher->HashLight(&nNonce, &mix_hash, 1, &hash);
+    if (UintToArith256(hash) > job->share_target) {
+        Reply(client, id, NullUniValue, 23, "Low difficulty share");
+        return;
+    }
+
+    const int64_t nNow = GetTime();
+    if (client->nShareWindow != nNow) {
+        client->nShareWindow = nNow;
+        client->nSharesInWindow = 0;
+    }
+    if (client->nPendingShares >= MAX_STRATUM_PENDING_SHARES || client->nSharesInWindow >= MAX_STRATUM_SHARES_PER_SECOND) {
+        Reply(client, id, NullUniValue, 20, "Too many shares, raise the share difficulty");
+        return;
+    }
+
+    ShareCheck check;
+    check.client_id = client->id;
+    check.request_id = id;
+    check.job = job;
+    check.nNonce = nNonce;
+    check.mix_hash = mix_hash;
+    check.fValid = false;
+    check.fBlockRejected = false;
+    {
+        WaitableLock lock(cs_verify);
+        if (verify_queue.size() >= MAX_STRATUM_VERIFY_QUEUE) {
+            lock.unlock();
+            Reply(client, id, NullUniValue, 20, "Server busy");
+            return;
+        }
+        verify_queue.push_back(std::move(check));
+    }
+    cond_verify.notify_one();
+    // A resubmission of the nonce is a duplicate even while this one is pending
+    job->nonces.insert(nNonce);
+    client->nPendingShares++;
+    client->nSharesInWindow++;
+}
+
+void StratumServer::ThreadVerifyShares()
+{
+    while (true) {
+        ShareCheck check;
+        {
+            WaitableLock lock(cs_verify);
+            cond_verify.wait(lock, [this] { return fStopVerify || !verify_queue.empty(); });
+            if (fStopVerify)
+                return;
+            check = std::move(verify_queue.front());
+            verify_queue.pop_front();
+        }
+
+        const StratumJob& job = *check.job;
+        uint256 hash, real_mix_hash;
+        job.hasher->Hash(check.nNonce, 1, &hash, &real_mix_hash);
+        check.fValid = real_mix_hash == check.mix_hash;
+
+        if (check.fValid && UintToArith256(hash) <= job.block_target) {
+            std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>(*job.block);
+            pblock->nNonce = check.nNonce;
+            pblock->nMixHash = check.mix_hash;
+            bool fNewBlock = false;
+            bool fAccepted = ProcessNewBlock(Params(), pblock, true, &fNewBlock);
+            LogPrintf("stratum: Block %s found (%s)\n", pblock->GetHash().ToString(),
+                fAccepted ? (fNewBlock ? "accepted" : "duplicate") : "rejected");
+            check.fBlockRejected = !fAccepted;
+        }
+
+        {
+            WaitableLock lock(cs_verify);
+            verified.push_back(std::move(check));
+        }
+        event_active(verified_ev, 0, 0);
+    }
+}
+
+void StratumServer::verified_cb(evutil_socket_t fd, short what, void* arg)
+{
+    static_cast<StratumServer*>(arg)->HandleVerified();
+}
+
+void StratumServer::HandleVerified()
+{
+    std::deque<ShareCheck> done;
+    {
+        WaitableLock lock(cs_verify);
+        done.swap(verified);
+    }
+    for (const ShareCheck& check : done) {
+        StratumClient* client = FindClient(check.client_id);
+        if (!client)
+            continue;
+        client->nPendingShares--;
+        if (!check.fValid) {
+            // Honest miners compute the mix exactly; a wrong one that passed the
+            // light check was picked to make us run the full hash.
+            LogPrintf("stratum: Disconnecting %s for a share with an invalid mix hash\n", client->peer);
+            Disconnect(client);
+        } else if (check.fBlockRejected) {
+            Reply(client, check.request_id, NullUniValue, 20, "Block rejected");
+        } else {
+            Reply(client, check.request_id, true);
+        }
+    }
+}
+
+StratumClient* StratumServer::FindClient(uint64_t id)
+{
+    for (StratumClient* client : clients) {
+        if (client->id == id)
+            return client;
+    }
+    return nullptr;
+}
+
+void StratumServer::Disconnect(StratumClient* client)
+{
+    LogPrint(BCLog::STRATUM, "stratum: Disconnecting %s\n", client->peer);
+    clients.erase(client);
+    bufferevent_free(client->bev);
+    delete client;
+}
+
+void StratumServer::acceptcb(struct evconnlistener* listener, evutil_socket_t fd, struct sockaddr* addr, int socklen, void* arg)
+{
+    StratumServer* self = static_cast<StratumServer*>(arg);
+    CService peer;
+    peer.SetSockAddr(addr);
+
+    StratumClient* client = new StratumClient();
+    client->server = self;
+    client->bev = bufferevent_socket_new(self->base, fd, BEV_OPT_CLOSE_ON_FREE);
+    client->peer = peer.ToString();
+    client->id = self->nNextClientId++;
+    client->nonce_prefix = self->nNextNoncePrefix++;
+    client->subscribed = false;
+    client->authorized = false;
+    client->nPendingShares = 0;
+    client->nShareWindow = 0;
+    client->nSharesInWindow = 0;
+    if (!client->bev) {
+        evutil_closesocket(fd);
+        delete client;
+        return;
+    }
+    self->clients.insert(client);
+    bufferevent_setcb(client->bev, readcb, nullptr, eventcb, client);
+    bufferevent_enable(client->bev, EV_READ | EV_WRITE);
+    LogPrint(BCLog::STRATUM, "stratum: Accepted connection from %s\n", client->peer);
+}
+
+void StratumServer::readcb(struct bufferevent* bev, void* ctx)
+{
+    StratumClient* client = static_cast<StratumClient*>(ctx);
+    StratumServer* self = client->server;
+    struct evbuffer* input = bufferevent_get_input(bev);
+    size_t n_read_out = 0;
+    char* line;
+    while ((line = evbuffer_readln(input, &n_read_out, EVBUFFER_EOL_CRLF)) != nullptr) {
+        std::string s(line, n_read_out);
+        free(line);
+        if (s.empty())
+            continue;
+        self->HandleLine(client, s);
+        if (!self->clients.count(client))
+            return;
+    }
+    if (evbuffer_get_length(input) > MAX_STRATUM_LINE_LENGTH) {
+        LogPrintf("stratum: Disconnecting %s because MAX_STRATUM_LINE_LENGTH exceeded\n", client->peer);
+        self->Disconnect(client);
+    }
+}
+
+void StratumServer::eventcb(struct bufferevent* bev, short what, void* ctx)
+{
+    StratumClient* client = static_cast<StratumClient*>(ctx);
+    if (what & (BEV_EVENT_EOF | BEV_EVENT_ERROR))
+        client->server->Disconnect(client);
+}
+
+/****** Thread ********/
+static struct event_base* gBase;
+static boost::thread stratumThread;
+static std::unique_ptr<StratumServer> g_stratum;
+
+static void StratumThread()
+{
+    event_base_dispatch(gBase);
+}
+
+bool StartStratumServer()
+{
+    assert(!gBase);
+    const CChainParams& chainparams = Params();
+
+    const std::string strAddress = gArgs.GetArg("-stratumaddress", "");
+    CTxDestination dest = DecodeDestination(strAddress);
+    if (!IsValidDestination(dest))
+        return InitError(strprintf(_("Invalid or missing -stratumaddress: '%s'"), strAddress));
+
+    int64_t nDifficulty = gArgs.GetArg("-stratumdifficulty", DEFAULT_STRATUM_DIFFICULTY);
+    if (nDifficulty < 1)
+        return InitError(strprintf(_("Invalid -stratumdifficulty: %d"), nDifficulty));
+    arith_uint256 share_limit = UintToArith256(chainparams.GetConsensus().powLimit);
+    share_limit /= arith_uint256((uint64_t)nDifficulty);
+
+    const std::string strBind = gArgs.GetArg("-stratumbind", DEFAULT_STRATUM_BIND);
+    CService addrBind;
+    if (!Lookup(strBind.c_str(), addrBind, gArgs.GetArg("-stratumport", DEFAULT_STRATUM_PORT), false))
+        return InitError(strprintf(_("Invalid -stratumbind address: '%s'"), strBind));
+
+#ifdef WIN32
+    evthread_use_windows_threads();
+#else
+    evthread_use_pthreads();
+#endif
+    gBase = event_base_new();
+    if (!gBase)
+        return InitError(_("Unable to create the stratum event base."));
+
+    g_stratum.reset(new StratumServer(gBase, GetScriptForDestination(dest), share_limit, gArgs.GetArg("-stratumpassword", "")));
+    if (!g_stratum->Bind(addrBind)) {
+        g_stratum.reset();
+        event_base_free(gBase);
+        gBase = nullptr;
+        return InitError(strprintf(_("Unable to bind the stratum server to %s."), addrBind.ToString()));
+    }
+    g_stratum->StartVerifier();
+    RegisterValidationInterface(g_stratum.get());
+    LogPrintf("stratum: Listening on %s\n", addrBind.ToString());
+
+    stratumThread = boost::thread(boost::bind(&TraceThread<void (*)()>, "stratum", &StratumThread));
+    return true;
+}
+
+void InterruptStratumServer()
+{
+    if (gBase) {
+        LogPrintf("stratum: Thread interrupt\n");
+        event_base_loopbreak(gBase);
+    }
+}
+
+void StopStratumServer()
+{
+    if (gBase) {
+        UnregisterValidationInterface(g_stratum.get());
+        // Let notifications already in flight finish before their events go away
+        SyncWithValidationInterfaceQueue();
+        stratumThread.join();
+        // The event loop is gone, so nothing queues shares any more
+        g_stratum->StopVerifier();
+        g_stratum.reset();
+        event_base_free(gBase);
+        gBase = nullptr;
+    }
+}
@@ -0,0 +1,27 @@
+// Copyright (c) 2024 The NoteCoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/**
+ * Built-in stratum endpoint for local KawPoW miners.
+ */
+#ifndef BITCOIN_STRATUM_H
+#define BITCOIN_STRATUM_H
+
+#include <stdint.h>
+#include <string>
+
+static const bool DEFAULT_STRATUM_ENABLE = false;
+static const std::string DEFAULT_STRATUM_BIND = "127.0.0.1";
+static const unsigned short DEFAULT_STRATUM_PORT = 3333;
+/** Share difficulty, as a divisor of the proof-of-work limit */
+static const int64_t DEFAULT_STRATUM_DIFFICULTY = 1;
+
+/** Start the stratum server. Returns false (after reporting an InitError) on failure. */
+bool StartStratumServer();
+/** Interrupt the stratum event loop */
+void InterruptStratumServer();
+/** Stop the stratum server and drop all miner connections */
+void StopStratumServer();
+
+#endif // BITCOIN_STRATUM_H
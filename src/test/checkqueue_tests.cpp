@@ -381,6 +381,48 @@ BOOST_AUTO_TEST_CASE(test_CheckQueue_FrozenCleanup)
 }
 
 
+// Test that the statistics of a round count every check once, whichever
+// thread ran or stole it, and start over for the next round.
+BOOST_AUTO_TEST_CASE(test_CheckQueue_Stats)
+{
+    auto queue = std::unique_ptr<Correct_Queue>(new Correct_Queue {QUEUE_BATCH_SIZE});
+    boost::thread_group tg;
+    for (auto x = 0; x < nScriptCheckThreads; ++x) {
+       tg.create_thread([&]{queue->Thread();});
+    }
+    // Wait for the workers to register, so that the thread count is stable.
+    // Every round, even an empty one, records the current count.
+    for (const int64_t nDeadline = GetTimeMillis() + 30000; GetTimeMillis() < nDeadline; MilliSleep(1)) {
+        CCheckQueueControl<FakeCheckCheckCompletion> control(queue.get());
+        BOOST_REQUIRE(control.Wait());
+        if (queue->GetLastStats().threads == (unsigned int)nScriptCheckThreads + 1) break;
+    }
+
+    for (size_t count : {(size_t)0, (size_t)1, (size_t)5000}) {
+        {
+            CCheckQueueControl<FakeCheckCheckCompletion> control(queue.get());
+            std::vector<FakeCheckCheckCompletion> vChecks;
+            for (size_t total = count; total;) {
+                vChecks.resize(std::min(total, (size_t) InsecureRandRange(10)));
+                total -= vChecks.size();
+                control.Add(vChecks);
+            }
+            BOOST_REQUIRE(control.Wait());
+        }
+        const CheckQueueStats stats = queue->GetLastStats();
+        BOOST_CHECK_EQUAL(stats.checks, count);
+        BOOST_CHECK_EQUAL(stats.threads, (unsigned int)nScriptCheckThreads + 1);
+        BOOST_CHECK(stats.steals <= stats.checks);
+        BOOST_CHECK(stats.Utilization() >= 0.0);
+        if (count == 0) {
+            BOOST_CHECK_EQUAL(stats.wall_micros, 0);
+            BOOST_CHECK_EQUAL(stats.busy_micros, 0);
+        }
+    }
+    tg.interrupt_all();
+    tg.join_all();
+}
+
 /** Test that CCheckQueueControl is threadsafe */
 BOOST_AUTO_TEST_CASE(test_CheckQueueControl_Locks)
 {
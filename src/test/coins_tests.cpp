@@ -656,6 +656,90 @@ BOOST_AUTO_TEST_CASE(ccoins_access)
     CheckAccessCoin(VALUE1, VALUE2, VALUE2, DIRTY|FRESH, DIRTY|FRESH);
 }
 
+BOOST_AUTO_TEST_CASE(ccoins_fetch_many)
+{
+    // Fetching many outpoints at once through a stack of caches must give the
+    // same result and cache contents as looking them up one at a time.
+    CCoinsViewTest base;
+    std::vector<COutPoint> outpoints;
+    std::vector<int> where;
+    {
+        CCoinsViewCacheTest filler(&base);
+        for (int i = 0; i < 200; ++i) {
+            outpoints.emplace_back(InsecureRand256(), InsecureRandRange(4));
+            where.push_back(InsecureRandRange(4));
+            if (where.back() >= 2) {
+                filler.AddCoin(outpoints.back(), Coin(CTxOut(1 + InsecureRandRange(1000), CScript() << OP_TRUE), 1, false), false);
+            }
+        }
+        filler.Flush();
+    }
+
+    CCoinsViewCacheTest middle(&base);
+    std::vector<COutPoint> lookups;
+    bool expected = true;
+    for (size_t i = 0; i < outpoints.size(); ++i) {
+        switch (where[i]) {
+        case 0: expected = false; break; // absent
+        case 1: middle.AddCoin(outpoints[i], Coin(CTxOut(1, CScript() << OP_TRUE), 1, false), false); break;
+        case 2: break; // in the base view only
+        case 3: middle.SpendCoin(outpoints[i]); expected = false; break;
+        }
+        lookups.push_back(outpoints[i]);
+        if (InsecureRandBool()) lookups.push_back(outpoints[i]);
+    }
+
+    CCoinsViewCacheTest batched(&middle);
+    CCoinsViewCacheTest single(&middle);
+    BOOST_CHECK_EQUAL(batched.FetchCoins(lookups), expected);
+    for (const COutPoint& outpoint : lookups) {
+        single.AccessCoin(outpoint);
+    }
+    batched.SelfTest();
+    single.SelfTest();
+    BOOST_CHECK_EQUAL(batched.GetCacheSize(), single.GetCacheSize());
+    for (const COutPoint& outpoint : lookups) {
+        BOOST_CHECK(batched.AccessCoin(outpoint) == single.AccessCoin(outpoint));
+        BOOST_CHECK_EQUAL(batched.map().count(outpoint), single.map().count(outpoint));
+    }
+
+    // Only present coins, already cached now
+    std::vector<COutPoint> present;
+    for (size_t i = 0; i < outpoints.size(); ++i) {
+        if (where[i] == 1 || where[i] == 2) present.push_back(outpoints[i]);
+    }
+    BOOST_CHECK(batched.FetchCoins(present));
+    BOOST_CHECK_EQUAL(batched.GetCacheSize(), single.GetCacheSize());
+}
+
+BOOST_FIXTURE_TEST_CASE(ccoins_db_getcoins, TestingSetup)
+{
+    // The database hands large batches to the coin fetching threads; the
+    // result must match looking the outpoints up one at a time.
+    std::vector<COutPoint> outpoints;
+    {
+        CCoinsViewCache cache(pcoinsdbview.get());
+        for (int i = 0; i < 300; ++i) {
+            outpoints.emplace_back(InsecureRand256(), InsecureRandRange(4));
+            if (InsecureRandBool()) {
+                cache.AddCoin(outpoints.back(), Coin(CTxOut(1 + InsecureRandRange(1000), CScript() << OP_TRUE), i, false), false);
+            }
+        }
+        BOOST_CHECK(cache.Flush());
+    }
+
+    std::vector<Coin> coins;
+    std::vector<bool> found;
+    pcoinsdbview->GetCoins(outpoints, coins, found);
+    BOOST_REQUIRE_EQUAL(coins.size(), outpoints.size());
+    BOOST_REQUIRE_EQUAL(found.size(), outpoints.size());
+    for (size_t i = 0; i < outpoints.size(); ++i) {
+        Coin coin;
+        BOOST_CHECK_EQUAL(found[i], pcoinsdbview->GetCoin(outpoints[i], coin));
+        BOOST_CHECK(coins[i] == coin);
+    }
+}
+
 void CheckSpendCoins(CAmount base_value, CAmount cache_value, CAmount expected_value, char cache_flags, char expected_flags)
 {
     SingleEntryCacheTest test(base_value, cache_value, cache_flags);
@@ -10,6 +10,7 @@
 #include <crypto/sha512.h>
 #include <crypto/hmac_sha256.h>
 #include <crypto/hmac_sha512.h>
+#include <hash.h>
 #include <random.h>
 #include <utilstrencodings.h>
 #include <test/test_bitcoin.h>
@@ -268,6 +269,54 @@ BOOST_AUTO_TEST_CASE(sha256_testvectors) {
     TestSHA256(test1, "a316d55510b49662420f49d145d42fb83f31ef8dc016aa4e32df049991a91e26");
 }
 
+BOOST_AUTO_TEST_CASE(sha256d64)
+{
+    // Every batch size up to 32 so the 8-, 4- and 2-way paths and their tails are all used
+    for (int i = 0; i <= 32; ++i) {
+        unsigned char in[64 * 32];
+        unsigned char out1[32 * 32], out2[32 * 32];
+        for (int j = 0; j < 64 * i; ++j) {
+            in[j] = InsecureRandBits(8);
+        }
+        for (int j = 0; j < i; ++j) {
+            CHash256().Write(in + 64 * j, 64).Finalize(out1 + 32 * j);
+        }
+        SHA256D64(out2, in, i);
+        BOOST_CHECK(memcmp(out1, out2, 32 * i) == 0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(hash160_batch)
+{
+    // Mixed lengths around the one/two/three block padding boundaries, in
+    // batches of every size up to 20 so both the 8-lane path and its tail run
+    const size_t lengths[] = {0, 33, 65, 55, 56, 63, 64, 119, 120, 1, 33, 33, 25, 22, 71, 140, 33, 65, 34, 23};
+    unsigned char in[20][140];
+    const unsigned char* inputs[20];
+    for (int i = 0; i < 20; ++i) {
+        for (size_t j = 0; j < lengths[i]; ++j) {
+            in[i][j] = InsecureRandBits(8);
+        }
+        inputs[i] = in[i];
+    }
+    for (size_t n = 0; n <= 20; ++n) {
+        unsigned char sha1[32 * 20], sha2[32 * 20];
+        unsigned char ripemd1[20 * 20], ripemd2[20 * 20];
+        unsigned char hash1[20 * 20], hash2[20 * 20];
+        for (size_t i = 0; i < n; ++i) {
+            CSHA256().Write(inputs[i], lengths[i]).Finalize(sha1 + 32 * i);
+            CRIPEMD160().Write(sha1 + 32 * i, 32).Finalize(ripemd1 + 20 * i);
+            CHash160().Write(inputs[i], lengths[i]).Finalize(hash1 + 20 * i);
+        }
+        SHA256Batch(sha2, inputs, lengths, n);
+        RIPEMD160_32(ripemd2, sha1, n);
+        Hash160Batch(hash2, inputs, lengths, n);
+        BOOST_CHECK(memcmp(sha1, sha2, 32 * n) == 0);
+        BOOST_CHECK(memcmp(ripemd1, ripemd2, 20 * n) == 0);
+        BOOST_CHECK(memcmp(hash1, hash2, 20 * n) == 0);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(sha512_testvectors) {
     TestSHA512("",
                "cf83e1357eefb8bdf1542850d66d8007d620e4050b5715dc83f4a921d36ce9ce"
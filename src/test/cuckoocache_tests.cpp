@@ -377,4 +377,47 @@ BOOST_AUTO_TEST_CASE(cuckoocache_generations)
     test_cache_generations<CuckooCache::cache<uint256, SignatureCacheHasher>>();
 }
 
+/* Test that the sharded cache finds everything inserted by any thread once
+ * flushed, with lookups racing the inserts, and counts what happened.
+ */
+BOOST_AUTO_TEST_CASE(sharded_cache_parallel_ok)
+{
+    CShardedCache cache;
+    const uint64_t capacity = cache.setup_bytes(4 << 20);
+    BOOST_CHECK(capacity >= (4 << 20) / sizeof(uint256) - CShardedCache::SHARDS);
+
+    const size_t n_threads = 4;
+    std::vector<uint256> hashes(4 * CShardedCache::INSERT_BUFFER_SIZE * n_threads);
+    for (uint256& hash : hashes)
+        insecure_GetRandHash(hash);
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < n_threads; ++t) {
+        threads.emplace_back([&, t] {
+            for (size_t i = t; i < hashes.size(); i += n_threads) {
+                cache.Insert(hashes[i]);
+                cache.Contains(hashes[hashes.size() - 1 - i], false);
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+    CacheStats stats = cache.GetStats();
+    BOOST_CHECK_EQUAL(stats.hits + stats.misses, hashes.size());
+
+    cache.Flush();
+    for (const uint256& hash : hashes)
+        BOOST_CHECK(cache.Contains(hash, false));
+    uint256 unknown;
+    insecure_GetRandHash(unknown);
+    BOOST_CHECK(!cache.Contains(unknown, false));
+
+    const CacheStats flushed = cache.GetStats();
+    BOOST_CHECK_EQUAL(flushed.hits, stats.hits + hashes.size());
+    BOOST_CHECK_EQUAL(flushed.misses, stats.misses + 1);
+    BOOST_CHECK_EQUAL(flushed.inserts, hashes.size());
+    BOOST_CHECK_EQUAL(flushed.evictions, 0U);
+    BOOST_CHECK_EQUAL(flushed.capacity, capacity);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -2,6 +2,7 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <crypto/siphash.h>
 #include <hash.h>
 #include <utilstrencodings.h>
 #include <test/test_bitcoin.h>
@@ -147,4 +148,27 @@ BOOST_AUTO_TEST_CASE(siphash)
     }
 }
 
+BOOST_AUTO_TEST_CASE(siphash_many)
+{
+    // Every count up to 16, so both the multi-lane path and its tail are used
+    for (size_t n = 0; n <= 16; ++n) {
+        const uint64_t k0 = InsecureRandBits(64), k1 = InsecureRandBits(64);
+        std::vector<uint256> vals(n);
+        std::vector<const unsigned char*> inputs(n);
+        std::vector<uint32_t> extras(n);
+        for (size_t i = 0; i < n; ++i) {
+            vals[i] = InsecureRand256();
+            inputs[i] = vals[i].begin();
+            extras[i] = InsecureRand32();
+        }
+        std::vector<uint64_t> out(n), out_extra(n);
+        SipHash32Many(k0, k1, inputs.data(), nullptr, out.data(), n);
+        SipHash32Many(k0, k1, inputs.data(), extras.data(), out_extra.data(), n);
+        for (size_t i = 0; i < n; ++i) {
+            BOOST_CHECK_EQUAL(out[i], SipHashUint256(k0, k1, vals[i]));
+            BOOST_CHECK_EQUAL(out_extra[i], SipHashUint256Extra(k0, k1, vals[i], extras[i]));
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,222 @@
+// Copyright (c) 2024 The NoteCoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <crypto/keccak.h>
+#include <crypto/progpow/progpow.hpp>
+#include <hash.h>
+#include <kawpow/header_hasher.h>
+#include <kawpow/kawpow.h>
+#include <primitives/block.h>
+#include <random.h>
+#include <streams.h>
+#include <uint256.h>
+#include <utilstrencodings.h>
+#include <version.h>
+#include <test/test_bitcoin.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(kawpow_tests, BasicTestingSetup)
+
+static std::string Keccak256Hex(const std::string& in)
+{
+    unsigned char hash[32];
+    Keccak256((const unsigned char*)in.data(), in.size(), hash);
+    return HexStr(hash, hash + sizeof(hash));
+}
+
+BOOST_AUTO_TEST_CASE(keccak_testvectors)
+{
+    BOOST_CHECK_EQUAL(Keccak256Hex(""), "c5d2460186f7233c927e7db2dcc703c0e500b653ca82273b7bfad8045d85a470");
+    BOOST_CHECK_EQUAL(Keccak256Hex("abc"), "4e03657aea45a94fc7d47ba826c8d667c0d1e6e33a64a036ec44f58fa12d6c45");
+
+    unsigned char hash[64];
+    Keccak512(nullptr, 0, hash);
+    BOOST_CHECK_EQUAL(HexStr(hash, hash + 64), "0eab42de4c3ceb9235fc91acffe746b29c29a8c366b7c60e4e67c466f36a4304c00fa9caf9d87976ba469bcbe06713b435f091ef2769fb160cdab33d3670680e");
+}
+
+BOOST_AUTO_TEST_CASE(epoch_parameters)
+{
+    // Sizes are those of ethash; only the epoch length differs.
+    BOOST_CHECK_EQUAL(progpow::GetLightCacheNumItems(0) * 64, 16776896);
+    BOOST_CHECK_EQUAL(progpow::GetLightCacheNumItems(1) * 64, 16907456);
+    BOOST_CHECK_EQUAL(progpow::GetFullDatasetNumItems(0) * 128, 1073739904);
+    BOOST_CHECK_EQUAL(progpow::GetFullDatasetNumItems(1) * 128, 1082130304);
+    // The upper bound reaches 2^31 items here; 2^31 - 1 is prime
+    BOOST_CHECK_EQUAL(progpow::GetFullDatasetNumItems(32640), 2147483647U);
+
+    BOOST_CHECK_EQUAL(progpow::GetEpochNumber(0), 0);
+    BOOST_CHECK_EQUAL(progpow::GetEpochNumber(7499), 0);
+    BOOST_CHECK_EQUAL(progpow::GetEpochNumber(7500), 1);
+
+    BOOST_CHECK(progpow::GetEpochSeed(0).IsNull());
+    uint256 seed1 = progpow::GetEpochSeed(1);
+    BOOST_CHECK_EQUAL(HexStr(seed1.begin(), seed1.end()), "290decd9548b62a8d60345a988386fc84ba6bc95484008f6362f93160ef3e563");
+}
+
+BOOST_AUTO_TEST_CASE(epoch_context_cache)
+{
+    std::shared_ptr<const progpow::EpochContext> context = progpow::GetEpochContext(0);
+    BOOST_CHECK_EQUAL(context->epoch_number, 0);
+    BOOST_CHECK_EQUAL(context->light_cache.size(), (size_t)context->light_cache_num_items * 16);
+    BOOST_CHECK_EQUAL(context->l1_cache.size(), progpow::L1_CACHE_NUM_ITEMS);
+
+    // A second lookup must hit the cache rather than rebuild.
+    BOOST_CHECK(progpow::GetEpochContext(0) == context);
+}
+
+BOOST_AUTO_TEST_CASE(kawpow_hash_consistency)
+{
+    std::shared_ptr<const progpow::EpochContext> context = progpow::GetEpochContext(0);
+    const uint256 header_hash = uint256S("7e44cb826f1bac5f7ef17e6bdb31e1c0e0fe95f9e6e1ff11e7c7b22f9e1c7e3d");
+
+    uint256 mix1, mix2;
+    const uint256 hash1 = progpow::hash(*context, header_hash, 0x123456789abcdefULL, 10, &mix1);
+    const uint256 hash2 = progpow::hash(header_hash, 0x123456789abcdefULL, 10, &mix2);
+    BOOST_CHECK(hash1 == hash2);
+    BOOST_CHECK(mix1 == mix2);
+    BOOST_CHECK(!mix1.IsNull());
+
+    // Nonce and program period both feed the result.
+    BOOST_CHECK(progpow::hash(*context, header_hash, 0x123456789abcdeeULL, 10) != hash1);
+    BOOST_CHECK(progpow::hash(*context, header_hash, 0x123456789abcdefULL, 13) != hash1);
+    // Heights within one period run the same program.
+    BOOST_CHECK(progpow::hash(*context, header_hash, 0x123456789abcdefULL, 11) == hash1);
+}
+
+BOOST_AUTO_TEST_CASE(keccak_f800_testvector)
+{
+    // Keccak-f[800] of the all-zero state, from the Keccak team's known answers
+    uint32_t state[25] = {};
+    KeccakF800(state);
+    const uint32_t expected[8] = {0xe531d45d, 0xf404c6fb, 0x23a0bf99, 0xf1f8452f, 0x51ffd042, 0xe539f578, 0xf00b80a7, 0xaf973664};
+    BOOST_CHECK(std::equal(expected, expected + 8, state));
+}
+
+/** Same layout as cpp-kawpow's kawpow_hash_test_case, hex in ethash byte order */
+struct KawpowHashTestCase
+{
+    int block_number;
+    const char* header_hash_hex;
+    const char* nonce_hex;
+    const char* mix_hash_hex;
+    const char* final_hash_hex;
+};
+
+// Regression vectors from contrib/testgen/gen_kawpow_test_vectors.py, an
+// independent implementation of the specifications. They show agreement
+// with that script only; cpp-kawpow's kawpow_hash_test_cases rows can be
+// added here unchanged.
+static const KawpowHashTestCase kawpow_hash_test_cases[] = {
+    {0, "0000000000000000000000000000000000000000000000000000000000000000", "0000000000000000",
+        "40ce8bf6046c09f90f812f015d4ab8a1b504e7313e86d8a96197d5dadc3634e5",
+        "e6480cfa901dd209a9d8bef73275896be179f86b42e136efe692e14a41cb17b2"},
+    {49, "63155f732f2bf556967f906155b510c917e48e99685ead76ea83f4eca03ab12b", "0000000007073c07",
+        "62f6b49f39092b76fc04bb8db1e435fa5c3182a15f3c179ae7353a073c752c11",
+        "c3a419fc1e295899c0e0e596b1e9c7b609df96802b4b46157d07a632b8043979"},
+    {2999, "c5e6bd8d593e5c3c2f94624d9edbde2f9da928925a1ecbe7acf1e25c82da3086", "743a9633efe42777",
+        "0380f7837c86b94fc55368659ed65faca090e2a3541cb9d9c814f0dbcd63d580",
+        "aa6cf464d9bf413946a9481546d0a934144bb5788b746665bbad2b18f11a1ce4"},
+    {7500, "ed2f0e83c6f8180c97ac844cfa06fcf25f035ca4f326770b57d6c1d2d59c2852", "600e7cb18645ed5e",
+        "442ea646cfea5b0b519628291183c6a1925689d9ac614bab86d39bfde69fe2d4",
+        "0be19aadbb80eab7accadddaf219efeb7fa96e5e31eceff1312554febe2c0022"},
+    {14999, "a6cf41e170e9aaea9391dd45fe1b5553d1ea2d043faab5752e7c04e412aa8a5f", "edbcdc6d625ec6d2",
+        "8e7caf4a8e78499897238664615ab15389777df3a0b8b725d04506536a0d10a3",
+        "b2ffad2455e571b81a20c8da998a7316121cc23a9a2aaa4d707584233f64b6c7"},
+};
+
+BOOST_AUTO_TEST_CASE(kawpow_hash_test_vectors)
+{
+    for (const KawpowHashTestCase& test : kawpow_hash_test_cases) {
+        const uint256 header_hash = uint256S(test.header_hash_hex);
+        const uint64_t nonce = std::stoull(test.nonce_hex, nullptr, 16);
+        uint256 mix_hash;
+        const uint256 final_hash = progpow::hash(header_hash, nonce, test.block_number, &mix_hash);
+        BOOST_CHECK_EQUAL(mix_hash.GetHex(), test.mix_hash_hex);
+        BOOST_CHECK_EQUAL(final_hash.GetHex(), test.final_hash_hex);
+        BOOST_CHECK(progpow::hash_light(header_hash, nonce, uint256S(test.mix_hash_hex)) == final_hash);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(kawpow_input_serialization)
+{
+    CBlockHeader header;
+    header.nVersion = 0x20000000;
+    header.hashPrevBlock = InsecureRand256();
+    header.hashMerkleRoot = InsecureRand256();
+    header.nTime = 1710000123;
+    header.nBits = 0x1d00ffff;
+    header.nHeight = 123456;
+    header.nNonce = 0xdeadbeefcafef00dULL;
+
+    // The stack-only serializer must agree byte for byte with CKAWPOWInput
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << CKAWPOWInput(header);
+    KawpowInput input;
+    kawpow::SerializeInput(header, input);
+    BOOST_CHECK_EQUAL(ss.size(), input.size());
+    BOOST_CHECK(std::equal(input.begin(), input.end(), (const unsigned char*)ss.data()));
+    BOOST_CHECK(header.GetKAWPOWHeaderHash() == SerializeHash(CKAWPOWInput(header)));
+}
+
+BOOST_AUTO_TEST_CASE(seed_hasher_reuse)
+{
+    std::shared_ptr<const progpow::EpochContext> context = progpow::GetEpochContext(0);
+    const uint256 header_hash = InsecureRand256();
+    const progpow::SeedHasher hasher(header_hash);
+
+    for (uint64_t nonce = 0; nonce < 4; ++nonce) {
+        uint256 mix1, mix2;
+        BOOST_CHECK(progpow::hash(*context, hasher, nonce, 100, &mix1) == progpow::hash(*context, header_hash, nonce, 100, &mix2));
+        BOOST_CHECK(mix1 == mix2);
+        BOOST_CHECK(progpow::hash_light(hasher, nonce, mix1) == progpow::hash_light(header_hash, nonce, mix1));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(header_hasher_ranges)
+{
+    CBlockHeader header;
+    header.nVersion = 0x20000000;
+    header.hashPrevBlock = InsecureRand256();
+    header.hashMerkleRoot = InsecureRand256();
+    header.nTime = 1710000123;
+    header.nBits = 0x1d00ffff;
+    header.nHeight = 100;
+    const kawpow::HeaderHasher hasher(header);
+    const progpow::SeedHasher seeder(header.GetKAWPOWHeaderHash());
+
+    // Full hashes of a nonce range that wraps around
+    const uint64_t nFirst = 0xfffffffffffffff8ULL;
+    const size_t count = 11;
+    std::vector<uint256> hashes(count), mixes(count);
+    hasher.Hash(nFirst, count, hashes.data(), mixes.data());
+    std::vector<uint64_t> nonces;
+    for (size_t j = 0; j < count; ++j) {
+        header.nNonce = nFirst + j;
+        uint256 mix;
+        BOOST_CHECK(hashes[j] == header.GetPoWHash(mix));
+        BOOST_CHECK(mixes[j] == mix);
+        nonces.push_back(header.nNonce);
+    }
+
+    // Light hashes of the same candidates, including a bogus mix digest
+    mixes[4] = InsecureRand256();
+    std::vector<uint256> light(count);
+    hasher.HashLight(nonces.data(), mixes.data(), count, light.data());
+    for (size_t j = 0; j < count; ++j) {
+        BOOST_CHECK(light[j] == progpow::hash_light(seeder, nonces[j], mixes[j]));
+        BOOST_CHECK_EQUAL(light[j] == hashes[j], j != 4);
+    }
+
+    // The midstate block hash matches the serialized header hash
+    header.nNonce = nonces[5];
+    header.nMixHash = mixes[5];
+    BOOST_CHECK(hasher.GetBlockHash(header.nNonce, header.nMixHash) == header.GetHash());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -3,6 +3,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <consensus/merkle.h>
+#include <hash.h>
 #include <test/test_bitcoin.h>
 
 #include <boost/test/unit_test.hpp>
@@ -53,6 +54,45 @@ static std::vector<uint256> BlockGetMerkleBranch(const CBlock& block, const std:
     return vMerkleBranch;
 }
 
+// Older version of the merkle root computation code (MerkleComputation without
+// branch support), for comparison with the batched ComputeMerkleRoot.
+static uint256 MerkleComputationRoot(const std::vector<uint256>& leaves, bool* pmutated)
+{
+    if (leaves.size() == 0) {
+        *pmutated = false;
+        return uint256();
+    }
+    bool mutated = false;
+    uint32_t count = 0;
+    uint256 inner[32];
+    while (count < leaves.size()) {
+        uint256 h = leaves[count];
+        count++;
+        int level;
+        for (level = 0; !(count & (((uint32_t)1) << level)); level++) {
+            mutated |= (inner[level] == h);
+            CHash256().Write(inner[level].begin(), 32).Write(h.begin(), 32).Finalize(h.begin());
+        }
+        inner[level] = h;
+    }
+    int level = 0;
+    while (!(count & (((uint32_t)1) << level))) {
+        level++;
+    }
+    uint256 h = inner[level];
+    while (count != (((uint32_t)1) << level)) {
+        CHash256().Write(h.begin(), 32).Write(h.begin(), 32).Finalize(h.begin());
+        count += (((uint32_t)1) << level);
+        level++;
+        while (!(count & (((uint32_t)1) << level))) {
+            CHash256().Write(inner[level].begin(), 32).Write(h.begin(), 32).Finalize(h.begin());
+            level++;
+        }
+    }
+    *pmutated = mutated;
+    return h;
+}
+
 static inline int ctz(uint32_t i) {
     if (i == 0) return 0;
     int j = 0;
@@ -132,4 +172,50 @@ BOOST_AUTO_TEST_CASE(merkle_test)
     }
 }
 
+BOOST_AUTO_TEST_CASE(merkle_batched_test)
+{
+    for (int i = 0; i < 48; i++) {
+        // All sizes from 0 to 32 inclusive, so every SHA256D64 batch width and
+        // remainder is hit on each level, and then 15 random sizes.
+        const size_t nleaves = (i <= 32) ? i : 33 + InsecureRandRange(4000);
+        std::vector<uint256> leaves(nleaves);
+        for (uint256& leaf : leaves) {
+            leaf = InsecureRand256();
+        }
+        // No mutation, a duplicated pair of leaves, and a duplicated subtree.
+        for (int mutate = 0; mutate <= 2; mutate++) {
+            if (mutate && nleaves < 2) break;
+            std::vector<uint256> mutated_leaves = leaves;
+            int level = 0;
+            if (mutate == 2) {
+                while ((size_t)2 << (level + 1) <= nleaves && InsecureRandBool()) level++;
+            }
+            const size_t subtree = (size_t)1 << level;
+            const size_t pos = InsecureRandRange(nleaves / (2 * subtree)) * 2 * subtree;
+            if (mutate) {
+                std::copy(mutated_leaves.begin() + pos, mutated_leaves.begin() + pos + subtree, mutated_leaves.begin() + pos + subtree);
+            }
+
+            bool old_mutated = false;
+            bool new_mutated = false;
+            const uint256 old_root = MerkleComputationRoot(mutated_leaves, &old_mutated);
+            const uint256 new_root = ComputeMerkleRoot(mutated_leaves, &new_mutated);
+            BOOST_CHECK(old_root == new_root);
+            BOOST_CHECK_EQUAL(old_mutated, new_mutated);
+            BOOST_CHECK_EQUAL(new_mutated, mutate != 0);
+            BOOST_CHECK(ComputeMerkleRoot(mutated_leaves) == new_root);
+        }
+    }
+
+    // Identical leaves everywhere, including the odd ones hashed with themselves
+    for (size_t nleaves = 1; nleaves <= 17; nleaves++) {
+        std::vector<uint256> leaves(nleaves, InsecureRand256());
+        bool old_mutated = false;
+        bool new_mutated = false;
+        BOOST_CHECK(MerkleComputationRoot(leaves, &old_mutated) == ComputeMerkleRoot(leaves, &new_mutated));
+        BOOST_CHECK_EQUAL(old_mutated, new_mutated);
+        BOOST_CHECK_EQUAL(new_mutated, nleaves > 1);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -8,14 +8,19 @@
 #include <consensus/merkle.h>
 #include <consensus/tx_verify.h>
 #include <consensus/validation.h>
+#include <key.h>
 #include <validation.h>
 #include <miner.h>
 #include <policy/policy.h>
+#include <pow.h>
+#include <random.h>
 #include <pubkey.h>
+#include <script/interpreter.h>
 #include <script/standard.h>
 #include <txmempool.h>
 #include <uint256.h>
 #include <util.h>
+#include <validationinterface.h>
 #include <utilstrencodings.h>
 
 #include <test/test_bitcoin.h>
@@ -39,12 +44,16 @@ private:
 
 static CFeeRate blockMinFeeRate = CFeeRate(DEFAULT_BLOCK_MIN_TX_FEE);
 
-static BlockAssembler AssemblerForTest(const CChainParams& params) {
+static BlockAssembler::Options AssemblerOptionsForTest() {
     BlockAssembler::Options options;
 
     options.nBlockMaxWeight = MAX_BLOCK_WEIGHT;
     options.blockMinFeeRate = blockMinFeeRate;
-    return BlockAssembler(params, options);
+    return options;
+}
+
+static BlockAssembler AssemblerForTest(const CChainParams& params) {
+    return BlockAssembler(params, AssemblerOptionsForTest());
 }
 
 static
@@ -520,4 +529,96 @@ BOOST_AUTO_TEST_CASE(CreateNewBlock_validity)
     fCheckpointsEnabled = true;
 }
 
+BOOST_AUTO_TEST_CASE(block_solver)
+{
+    Consensus::Params params = Params().GetConsensus();
+    params.powLimit = uint256S("7fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
+
+    CBlock block;
+    block.nVersion = 4;
+    block.hashPrevBlock = InsecureRand256();
+    block.hashMerkleRoot = InsecureRand256();
+    block.nTime = 1710000000;
+    block.nBits = 0x207fffff;
+    block.nHeight = 7;
+
+    // Several threads share the template; the winner's solution must verify
+    CBlockSolver solver(4);
+    uint64_t nMaxTries = 1000;
+    BOOST_CHECK(solver.Solve(block, nMaxTries, params) == CBlockSolver::Result::FOUND);
+    BOOST_CHECK(CheckBlockProofOfWork(block, params) && CheckBlockMixHash(block));
+    BOOST_CHECK(nMaxTries < 1000);
+
+    // An empty budget gives up without touching the header
+    CBlock block2 = block;
+    block2.nNonce = 0;
+    block2.nMixHash.SetNull();
+    nMaxTries = 0;
+    BOOST_CHECK(solver.Solve(block2, nMaxTries, params) == CBlockSolver::Result::EXHAUSTED);
+    BOOST_CHECK(block2.nMixHash.IsNull());
+}
+
+BOOST_FIXTURE_TEST_CASE(template_updater, TestChain100Setup)
+{
+    CScript scriptPubKey = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    BlockTemplateUpdater updater(Params(), AssemblerOptionsForTest());
+    RegisterValidationInterface(&updater);
+    GetMainSignals().RegisterWithMempoolSignals(mempool);
+
+    // Spend a mature coinbase, then spend that transaction again
+    std::vector<CMutableTransaction> spends(2);
+    for (int i = 0; i < 2; i++) {
+        spends[i].nVersion = 1;
+        spends[i].vin.resize(1);
+        spends[i].vin[0].prevout.hash = i == 0 ? coinbaseTxns[0].GetHash() : spends[0].GetHash();
+        spends[i].vin[0].prevout.n = 0;
+        spends[i].vout.resize(1);
+        spends[i].vout[0].nValue = (i == 0 ? coinbaseTxns[0].vout[0].nValue : spends[0].vout[0].nValue) - 10000;
+        spends[i].vout[0].scriptPubKey = scriptPubKey;
+
+        std::vector<unsigned char> vchSig;
+        uint256 hash = SignatureHash(scriptPubKey, spends[i], 0, SIGHASH_ALL, 0, SIGVERSION_BASE);
+        BOOST_CHECK(coinbaseKey.Sign(hash, vchSig));
+        vchSig.push_back((unsigned char)SIGHASH_ALL);
+        spends[i].vin[0].scriptSig << vchSig;
+    }
+
+    std::unique_ptr<CBlockTemplate> pblocktemplate = updater.CreateNewBlock(scriptPubKey);
+    BOOST_CHECK_EQUAL(pblocktemplate->block.vtx.size(), 1U);
+
+    // Additions are appended to the selection, fees included
+    for (int i = 0; i < 2; i++) {
+        LOCK(cs_main);
+        CValidationState state;
+        BOOST_CHECK(AcceptToMemoryPool(mempool, state, MakeTransactionRef(spends[i]), nullptr, nullptr, true, 0));
+    }
+    SyncWithValidationInterfaceQueue();
+    pblocktemplate = updater.CreateNewBlock(scriptPubKey);
+    BOOST_REQUIRE_EQUAL(pblocktemplate->block.vtx.size(), 3U);
+    BOOST_CHECK(pblocktemplate->block.vtx[1]->GetHash() == spends[0].GetHash());
+    BOOST_CHECK(pblocktemplate->block.vtx[2]->GetHash() == spends[1].GetHash());
+    BOOST_CHECK_EQUAL(pblocktemplate->vTxFees[0], -20000);
+
+    // ... and match what a full package selection picks
+    std::unique_ptr<CBlockTemplate> pfulltemplate = AssemblerForTest(Params()).CreateNewBlock(scriptPubKey);
+    BOOST_CHECK_EQUAL(pfulltemplate->block.vtx.size(), pblocktemplate->block.vtx.size());
+    BOOST_CHECK_EQUAL(pfulltemplate->vTxFees[0], pblocktemplate->vTxFees[0]);
+
+    // Removing the parent drops its child as well
+    mempool.removeRecursive(spends[0]);
+    SyncWithValidationInterfaceQueue();
+    pblocktemplate = updater.CreateNewBlock(scriptPubKey);
+    BOOST_CHECK_EQUAL(pblocktemplate->block.vtx.size(), 1U);
+    BOOST_CHECK_EQUAL(pblocktemplate->vTxFees[0], 0);
+
+    // A new tip starts over from the mempool
+    CBlock block = CreateAndProcessBlock({}, scriptPubKey);
+    SyncWithValidationInterfaceQueue();
+    pblocktemplate = updater.CreateNewBlock(scriptPubKey);
+    BOOST_CHECK(pblocktemplate->block.hashPrevBlock == block.GetHash());
+
+    GetMainSignals().UnregisterWithMempoolSignals(mempool);
+    UnregisterValidationInterface(&updater);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
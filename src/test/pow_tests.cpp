@@ -4,9 +4,12 @@
 
 #include <chain.h>
 #include <chainparams.h>
+#include <kawpow/kawpow.h>
 #include <pow.h>
 #include <random.h>
+#include <streams.h>
 #include <util.h>
+#include <version.h>
 #include <test/test_bitcoin.h>
 
 #include <boost/test/unit_test.hpp>
@@ -83,4 +86,106 @@ BOOST_AUTO_TEST_CASE(GetBlockProofEquivalentTime_test)
     }
 }
 
+/* The skip list and cached median time past must not change the retarget */
+BOOST_AUTO_TEST_CASE(digishield_ancestor_lookup)
+{
+    const auto chainParams = CreateChainParams(CBaseChainParams::MAIN);
+    Consensus::Params params = chainParams->GetConsensus();
+    params.nAveragingInterval = 10;
+    params.multiAlgoTargetSpacingV4 = params.nPowTargetSpacing;
+    params.nAveragingTargetTimespanV4 = params.nAveragingInterval * params.multiAlgoTargetSpacingV4;
+    params.nMaxAdjustDownV4 = 16;
+    params.nMaxAdjustUpV4 = 8;
+    params.nMinActualTimespanV4 = params.nAveragingTargetTimespanV4 * (100 - params.nMaxAdjustUpV4) / 100;
+    params.nMaxActualTimespanV4 = params.nAveragingTargetTimespanV4 * (100 + params.nMaxAdjustDownV4) / 100;
+    params.nLocalTargetAdjustment = 4;
+
+    std::vector<CBlockIndex> blocks(2000);
+    for (int i = 0; i < 2000; i++) {
+        blocks[i].pprev = i ? &blocks[i - 1] : nullptr;
+        blocks[i].nHeight = i;
+        blocks[i].nTime = 1269211443 + i * params.nPowTargetSpacing + InsecureRandRange(2 * params.nPowTargetSpacing);
+        blocks[i].nBits = 0x1c0ffff0 + InsecureRandRange(16);
+        blocks[i].BuildSkip();
+        blocks[i].BuildMedianTimePast();
+    }
+
+    std::vector<unsigned int> results;
+    std::vector<int64_t> medians;
+    for (int i = 0; i < 2000; i++) {
+        results.push_back(DigiShieldV4(&blocks[i], params));
+        medians.push_back(blocks[i].GetMedianTimePast());
+    }
+    BOOST_CHECK_EQUAL(results[5], UintToArith256(params.powLimit).GetCompact());
+
+    // Same chain walked through pprev only, with medians computed on demand
+    for (int i = 0; i < 2000; i++) {
+        blocks[i].pskip = nullptr;
+        blocks[i].nMedianTimePast = 0;
+    }
+    for (int i = 0; i < 2000; i++) {
+        BOOST_CHECK_EQUAL(blocks[i].GetMedianTimePast(), medians[i]);
+        BOOST_CHECK_EQUAL(DigiShieldV4(&blocks[i], params), results[i]);
+    }
+}
+
+/* Test the two stages of the KawPoW header check */
+BOOST_AUTO_TEST_CASE(check_block_proof_of_work)
+{
+    Consensus::Params params = CreateChainParams(CBaseChainParams::MAIN)->GetConsensus();
+    params.powLimit = uint256S("7fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
+
+    CBlockHeader header;
+    header.nVersion = 4;
+    header.hashPrevBlock = InsecureRand256();
+    header.hashMerkleRoot = InsecureRand256();
+    header.nTime = 1710000000;
+    header.nBits = 0x207fffff;
+    header.nHeight = 42;
+    while (!CheckProofOfWork(header.GetPoWHash(header.nMixHash), header.nBits, params)) ++header.nNonce;
+    uint256 pow_hash;
+    BOOST_CHECK(CheckBlockProofOfWork(header, params, &pow_hash));
+    BOOST_CHECK(CheckBlockMixHash(header));
+    BOOST_CHECK(pow_hash == header.GetPoWHash());
+
+    // The light hash over the genuine mix is the full hash
+    uint256 mix_hash;
+    BOOST_CHECK(kawpow::HashPoWLight(header) == header.GetPoWHash(mix_hash));
+    BOOST_CHECK(mix_hash == header.nMixHash);
+
+    // A forged mix digest fails, whichever stage catches it
+    CBlockHeader forged = header;
+    forged.nMixHash = InsecureRand256();
+    BOOST_CHECK(!CheckBlockProofOfWork(forged, params) || !CheckBlockMixHash(forged));
+
+    // The height is committed to by the solution
+    CBlockHeader moved = header;
+    moved.nHeight = 45;
+    BOOST_CHECK(!CheckBlockProofOfWork(moved, params) || !CheckBlockMixHash(moved));
+}
+
+/* The verified PoW hash is only stored for entries flagged BLOCK_POW_VERIFIED */
+BOOST_AUTO_TEST_CASE(disk_block_index_pow_hash)
+{
+    CBlockIndex index;
+    index.nBits = 0x207fffff;
+    index.nMixHash = InsecureRand256();
+    index.hashPoW = InsecureRand256();
+
+    CDataStream legacy(SER_DISK, PROTOCOL_VERSION);
+    legacy << CDiskBlockIndex(&index);
+    CDiskBlockIndex read;
+    legacy >> read;
+    BOOST_CHECK(read.hashPoW.IsNull());
+    BOOST_CHECK(read.nMixHash == index.nMixHash);
+
+    index.nStatus |= BLOCK_POW_VERIFIED;
+    CDataStream verified(SER_DISK, PROTOCOL_VERSION);
+    verified << CDiskBlockIndex(&index);
+    BOOST_CHECK_EQUAL(verified.size(), legacy.size() + 32 + 1);
+    verified >> read;
+    BOOST_CHECK(read.hashPoW == index.hashPoW);
+    BOOST_CHECK(read.nStatus & BLOCK_POW_VERIFIED);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,153 @@
+// Copyright (c) 2024 The NoteCoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <base58.h>
+#include <chainparams.h>
+#include <compat.h>
+#include <key.h>
+#include <netbase.h>
+#include <stratum.h>
+#include <test/test_bitcoin.h>
+#include <univalue.h>
+#include <util.h>
+#include <utilstrencodings.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+struct StratumTestingSetup : public TestingSetup {
+    StratumTestingSetup() : TestingSetup(CBaseChainParams::REGTEST) {}
+};
+
+BOOST_FIXTURE_TEST_SUITE(stratum_tests, StratumTestingSetup)
+
+/** Minimal line-based stratum client over a plain local TCP socket */
+class TestStratumClient
+{
+public:
+    explicit TestStratumClient(const CService& addr) : buffer()
+    {
+        sock = CreateSocket(addr);
+        BOOST_REQUIRE(sock != INVALID_SOCKET);
+        BOOST_REQUIRE(ConnectSocketDirectly(addr, sock, 5000));
+    }
+    ~TestStratumClient() { CloseSocket(sock); }
+
+    void Send(int id, const std::string& method, const std::string& params)
+    {
+        std::string line = strprintf("{\"id\":%d,\"method\":\"%s\",\"params\":%s}\n", id, method, params);
+        BOOST_REQUIRE_EQUAL(send(sock, line.data(), line.size(), MSG_NOSIGNAL), (ssize_t)line.size());
+    }
+
+    /** Next message with the given id, or (id < 0) the next notification for method */
+    UniValue Receive(int id, const std::string& method = "")
+    {
+        while (true) {
+            UniValue msg = ReadMessage();
+            if (id >= 0 && find_value(msg, "id").isNum() && find_value(msg, "id").get_int() == id)
+                return msg;
+            if (id < 0 && find_value(msg, "method").isStr() && find_value(msg, "method").get_str() == method)
+                return msg;
+        }
+    }
+
+private:
+    SOCKET sock;
+    std::string buffer;
+
+    UniValue ReadMessage()
+    {
+        size_t pos;
+        while ((pos = buffer.find('\n')) == std::string::npos) {
+            fd_set fdset;
+            FD_ZERO(&fdset);
+            FD_SET(sock, &fdset);
+            struct timeval timeout = {30, 0};
+            BOOST_REQUIRE(select(sock + 1, &fdset, nullptr, nullptr, &timeout) == 1);
+            char chunk[4096];
+            ssize_t n = recv(sock, chunk, sizeof(chunk), 0);
+            BOOST_REQUIRE(n > 0);
+            buffer.append(chunk, n);
+        }
+        UniValue msg;
+        BOOST_REQUIRE(msg.read(buffer.substr(0, pos)));
+        buffer.erase(0, pos + 1);
+        return msg;
+    }
+};
+
+static int ErrorCode(const UniValue& reply)
+{
+    const UniValue& error = find_value(reply, "error");
+    return error.isArray() ? error[0].get_int() : 0;
+}
+
+BOOST_AUTO_TEST_CASE(stratum_protocol)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    gArgs.ForceSetArg("-stratumaddress", EncodeDestination(key.GetPubKey().GetID()));
+    gArgs.ForceSetArg("-stratumport", "28333");
+    gArgs.ForceSetArg("-stratumpassword", "secret");
+    BOOST_REQUIRE(StartStratumServer());
+
+    {
+        TestStratumClient client(LookupNumeric("127.0.0.1", 28333));
+
+        // Workers have to subscribe before they can authorize
+        client.Send(1, "mining.authorize", "[\"worker\",\"x\"]");
+        BOOST_CHECK_EQUAL(ErrorCode(client.Receive(1)), 25);
+
+        client.Send(2, "mining.subscribe", "[]");
+        UniValue subscribed = find_value(client.Receive(2), "result");
+        BOOST_REQUIRE(subscribed.isArray() && subscribed.size() == 2);
+        const std::string prefix = subscribed[1].get_str();
+        BOOST_CHECK_EQUAL(prefix.size(), 4U);
+
+        // Shares are only taken from workers that authorized with the password
+        client.Send(3, "mining.authorize", "[\"worker\",\"x\"]");
+        BOOST_CHECK_EQUAL(ErrorCode(client.Receive(3)), 24);
+        client.Send(3, "mining.submit", strprintf("[\"worker\",\"1\",\"0x%s000000000000\",\"%s\",\"%s\"]", prefix, uint256().GetHex(), uint256().GetHex()));
+        BOOST_CHECK_EQUAL(ErrorCode(client.Receive(3)), 24);
+
+        client.Send(3, "mining.authorize", "[\"worker\",\"secret\"]");
+        BOOST_CHECK(find_value(client.Receive(3), "result").get_bool());
+
+        // The current job follows the authorization, built on our tip
+        const UniValue target = find_value(client.Receive(-1, "mining.set_target"), "params");
+        const UniValue notify = find_value(client.Receive(-1, "mining.notify"), "params");
+        BOOST_REQUIRE_EQUAL(notify.size(), 7U);
+        BOOST_CHECK_EQUAL(target[0].get_str(), notify[3].get_str());
+        BOOST_CHECK(notify[4].get_bool());
+        {
+            LOCK(cs_main);
+            BOOST_CHECK_EQUAL(notify[5].get_int(), chainActive.Height() + 1);
+        }
+        const std::string job_id = notify[0].get_str();
+        const std::string header_hash = notify[1].get_str();
+        const std::string mix_hash = uint256().GetHex();
+        const std::string nonce = "0x" + prefix + "000000000000";
+
+        client.Send(4, "mining.submit", strprintf("[\"worker\",\"unknown\",\"%s\",\"%s\",\"%s\"]", nonce, header_hash, mix_hash));
+        BOOST_CHECK_EQUAL(ErrorCode(client.Receive(4)), 21);
+
+        const std::string other_prefix = strprintf("0x%04x000000000000", (ParseHex(prefix)[0] ^ 0x80) << 8);
+        client.Send(5, "mining.submit", strprintf("[\"worker\",\"%s\",\"%s\",\"%s\",\"%s\"]", job_id, other_prefix, header_hash, mix_hash));
+        BOOST_CHECK_EQUAL(ErrorCode(client.Receive(5)), 20);
+
+        client.Send(6, "mining.submit", strprintf("[\"worker\",\"%s\",\"%s\",\"%s\",\"%s\"]", job_id, nonce, uint256().GetHex(), mix_hash));
+        BOOST_CHECK_EQUAL(ErrorCode(client.Receive(6)), 20);
+
+        // A made-up mix digest does not reach the share target
+        client.Send(7, "mining.submit", strprintf("[\"worker\",\"%s\",\"%s\",\"%s\",\"%s\"]", job_id, nonce, header_hash, mix_hash));
+        BOOST_CHECK_EQUAL(ErrorCode(client.Receive(7)), 23);
+    }
+
+    InterruptStratumServer();
+    StopStratumServer();
+    gArgs.ForceSetArg("-stratumaddress", "");
+    gArgs.ForceSetArg("-stratumpassword", "");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
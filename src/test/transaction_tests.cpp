@@ -178,6 +178,40 @@ BOOST_AUTO_TEST_CASE(tx_valid)
     }
 }
 
+BOOST_AUTO_TEST_CASE(tx_hash_from_raw_bytes)
+{
+    // Hashes taken from the bytes read must match those of a fresh serialization
+    UniValue tests = read_json(std::string(json_tests::tx_valid, json_tests::tx_valid + sizeof(json_tests::tx_valid)));
+    for (unsigned int idx = 0; idx < tests.size(); idx++) {
+        if (!tests[idx][0].isArray()) continue;
+        const std::vector<unsigned char> raw = ParseHex(tests[idx][1].get_str());
+        CDataStream stream(raw, SER_NETWORK, PROTOCOL_VERSION);
+        const CTransaction tx(deserialize, stream);
+        const CTransaction reserialized{CMutableTransaction(tx)};
+        BOOST_CHECK(tx.GetHash() == reserialized.GetHash());
+        BOOST_CHECK(tx.GetWitnessHash() == reserialized.GetWitnessHash());
+        BOOST_CHECK(tx.GetWitnessHash() == (tx.HasWitness() ? Hash(raw.begin(), raw.end()) : tx.GetHash()));
+    }
+
+    // The extended format with only empty witnesses still has wtxid == txid
+    CMutableTransaction mtx;
+    mtx.vin.resize(2);
+    mtx.vout.resize(1);
+    CDataStream basic(SER_NETWORK, PROTOCOL_VERSION);
+    basic << mtx;
+    std::vector<unsigned char> extended(basic.begin(), basic.begin() + 4);
+    extended.push_back(0x00); // marker
+    extended.push_back(0x01); // flag
+    extended.insert(extended.end(), basic.begin() + 4, basic.end() - 4);
+    extended.push_back(0x00); // empty witness for each input
+    extended.push_back(0x00);
+    extended.insert(extended.end(), basic.end() - 4, basic.end());
+    CDataStream stream(extended, SER_NETWORK, PROTOCOL_VERSION);
+    const CTransaction tx(deserialize, stream);
+    BOOST_CHECK(tx.GetHash() == mtx.GetHash());
+    BOOST_CHECK(tx.GetWitnessHash() == tx.GetHash());
+}
+
 BOOST_AUTO_TEST_CASE(tx_invalid)
 {
     // Read tests from test/data/tx_invalid.json
@@ -494,6 +528,51 @@ BOOST_AUTO_TEST_CASE(test_big_witness_transaction) {
     threadGroup.join_all();
 }
 
+BOOST_AUTO_TEST_CASE(test_batched_script_checks)
+{
+    CKey key1, key2;
+    key1.MakeNewKey(true);
+    key2.MakeNewKey(true);
+    CBasicKeyStore keystore1, keystore2;
+    keystore1.AddKey(key1);
+    keystore2.AddKey(key2);
+    const CPubKey pubkey1 = key1.GetPubKey();
+
+    std::vector<CTxOut> spent(4);
+    spent[0].scriptPubKey = GetScriptForDestination(pubkey1.GetID());
+    spent[1].scriptPubKey = GetScriptForMultisig(1, {pubkey1, key2.GetPubKey()});
+    spent[2].scriptPubKey = CScript() << ToByteVector(pubkey1) << OP_CHECKSIG << OP_NOT;
+    spent[3].scriptPubKey = CScript() << ToByteVector(pubkey1) << OP_CHECKSIG;
+
+    CMutableTransaction mtx;
+    mtx.vin.resize(spent.size());
+    mtx.vout.resize(1);
+    for (uint32_t i = 0; i < spent.size(); i++) {
+        mtx.vin[i].prevout = COutPoint(InsecureRand256(), i);
+        spent[i].nValue = 1000;
+    }
+    BOOST_CHECK(SignSignature(keystore1, spent[0].scriptPubKey, mtx, 0, 1000, SIGHASH_ALL));
+    // Signed with the second key, so a batch that assumes the first one matched is wrong
+    BOOST_CHECK(SignSignature(keystore2, spent[1].scriptPubKey, mtx, 1, 1000, SIGHASH_ALL));
+    // A signature for another input: expected to fail by input 2, and failing input 3
+    std::vector<std::vector<unsigned char>> stack;
+    BOOST_CHECK(EvalScript(stack, mtx.vin[0].scriptSig, SCRIPT_VERIFY_NONE, BaseSignatureChecker(), SIGVERSION_BASE));
+    mtx.vin[2].scriptSig = CScript() << stack[0];
+    mtx.vin[3].scriptSig = CScript() << stack[0];
+
+    const CTransaction tx(mtx);
+    PrecomputedTransactionData txdata(tx);
+    std::vector<CScriptCheck> vChecks;
+    for (uint32_t i = 0; i < 3; i++) {
+        vChecks.emplace_back(spent[i], tx, i, SCRIPT_VERIFY_P2SH, false, &txdata);
+    }
+    BOOST_CHECK(RunChecks(vChecks));
+
+    vChecks.emplace_back(spent[3], tx, 3, SCRIPT_VERIFY_P2SH, false, &txdata);
+    BOOST_CHECK(!RunChecks(vChecks));
+    BOOST_CHECK_EQUAL(vChecks[3].GetScriptError(), SCRIPT_ERR_EVAL_FALSE);
+}
+
 BOOST_AUTO_TEST_CASE(test_witness)
 {
     CBasicKeyStore keystore, keystore2;
@@ -46,6 +46,10 @@ struct TestSubscriber : public CValidationInterface {
     }
 };
 
+// Heights of the blocks built so far; headers commit to their height for KawPoW.
+// The genesis block is never added and reads as height 0.
+static std::map<uint256, uint32_t> block_heights;
+
 std::shared_ptr<CBlock> Block(const uint256& prev_hash)
 {
     static int i = 0;
@@ -57,6 +61,7 @@ std::shared_ptr<CBlock> Block(const uint256& prev_hash)
     auto ptemplate = BlockAssembler(Params()).CreateNewBlock(pubKey, false);
     auto pblock = std::make_shared<CBlock>(ptemplate->block);
     pblock->hashPrevBlock = prev_hash;
+    pblock->nHeight = block_heights[prev_hash] + 1;
     pblock->nTime = ++time;
 
     CMutableTransaction txCoinbase(*pblock->vtx[0]);
@@ -71,9 +76,10 @@ std::shared_ptr<CBlock> FinalizeBlock(std::shared_ptr<CBlock> pblock)
 {
     pblock->hashMerkleRoot = BlockMerkleRoot(*pblock);
 
-    while (!CheckProofOfWork(pblock->GetPoWHash(), pblock->nBits, Params().GetConsensus())) {
+    while (!CheckProofOfWork(pblock->GetPoWHash(pblock->nMixHash), pblock->nBits, Params().GetConsensus())) {
         ++(pblock->nNonce);
     }
+    block_heights[pblock->GetHash()] = pblock->nHeight;
 
     return pblock;
 }
@@ -181,4 +187,61 @@ BOOST_AUTO_TEST_CASE(processnewblock_signals_ordering)
     BOOST_CHECK_EQUAL(sub.m_expected_tip, chainActive.Tip()->GetBlockHash());
 }
 
+BOOST_AUTO_TEST_CASE(processnewblockheaders_parallel_pow)
+{
+    std::vector<CBlockHeader> headers;
+    uint256 prev_hash = Params().GenesisBlock().GetHash();
+    for (int i = 0; i < 8; i++) {
+        headers.push_back(GoodBlock(prev_hash)->GetBlockHeader());
+        prev_hash = headers.back().GetHash();
+    }
+    // Forge one mix digest in the middle of the batch
+    headers[5].nMixHash = InsecureRand256();
+
+    CValidationState state;
+    CBlockHeader first_invalid;
+    BOOST_CHECK(!ProcessNewBlockHeaders(headers, state, Params(), nullptr, &first_invalid));
+    BOOST_CHECK_EQUAL(state.GetRejectReason(), "high-hash");
+    BOOST_CHECK(first_invalid.GetHash() == headers[5].GetHash());
+
+    // Headers before the forged one are accepted with their checked hash
+    LOCK(cs_main);
+    for (int i = 0; i < 5; i++) {
+        BlockMap::const_iterator it = mapBlockIndex.find(headers[i].GetHash());
+        BOOST_REQUIRE(it != mapBlockIndex.end());
+        BOOST_CHECK(it->second->nStatus & BLOCK_POW_VERIFIED);
+        BOOST_CHECK(it->second->hashPoW == headers[i].GetPoWHash());
+    }
+    for (int i = 5; i < 8; i++) {
+        BOOST_CHECK(!mapBlockIndex.count(headers[i].GetHash()));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(checkblock_parallel_tx_checks)
+{
+    // Enough transactions for CheckBlock to use the check threads
+    auto pblock = Block(Params().GenesisBlock().GetHash());
+    for (int i = 0; i < 150; i++) {
+        CMutableTransaction tx;
+        for (int j = 0; j < 1 + i % 3; j++) {
+            tx.vin.push_back(CTxIn(COutPoint(InsecureRand256(), j), CScript() << OP_CHECKSIG, 0));
+        }
+        tx.vout.push_back(CTxOut(1000, CScript() << OP_TRUE));
+        pblock->vtx.push_back(MakeTransactionRef(tx));
+    }
+    CValidationState state;
+    BOOST_CHECK(CheckBlock(*pblock, state, Params().GetConsensus(), false, false));
+
+    // The error reported is that of the first failing transaction
+    CMutableTransaction negative(*pblock->vtx[120]);
+    negative.vout[0].nValue = -1;
+    pblock->vtx[120] = MakeTransactionRef(negative);
+    CMutableTransaction duplicate(*pblock->vtx[70]);
+    duplicate.vin.push_back(duplicate.vin[0]);
+    pblock->vtx[70] = MakeTransactionRef(duplicate);
+    BOOST_CHECK(!CheckBlock(*pblock, state, Params().GetConsensus(), false, false));
+    BOOST_CHECK_EQUAL(state.GetRejectReason(), "bad-txns-inputs-duplicate");
+    BOOST_CHECK(state.GetDebugMessage().find(duplicate.GetHash().ToString()) != std::string::npos);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -7,12 +7,14 @@
 
 #include <chainparams.h>
 #include <hash.h>
+#include <kawpow/kawpow.h>
 #include <random.h>
 #include <pow.h>
 #include <uint256.h>
 #include <util.h>
 #include <ui_interface.h>
 #include <init.h>
+#include <validation.h>
 
 #include <stdint.h>
 
@@ -52,6 +54,42 @@ struct CoinEntry {
     }
 };
 
+/**
+ * Closure reading a run of coins from the database into the caller's
+ * slots. found is a byte per coin, as threads cannot share a vector<bool>.
+ */
+class CCoinsFetch
+{
+private:
+    const CCoinsViewDB* pview;
+    const COutPoint* poutpoints;
+    Coin* pcoins;
+    char* pfound;
+    size_t nCount;
+
+public:
+    CCoinsFetch(const CCoinsViewDB& view, const COutPoint* outpoints, Coin* coins, char* found, size_t count) :
+        pview(&view), poutpoints(outpoints), pcoins(coins), pfound(found), nCount(count) {}
+
+    bool operator()() {
+        try {
+            for (size_t i = 0; i < nCount; ++i)
+                pfound[i] = pview->GetCoin(poutpoints[i], pcoins[i]);
+        } catch (const std::runtime_error& e) {
+            // Reported again on the calling thread, which is where the
+            // caller's error handling lives.
+            LogPrintf("Error reading coins from database: %s\n", e.what());
+            return false;
+        }
+        return true;
+    }
+};
+
+/** Below this many lookups, handing them to other threads costs more than it saves. */
+static const size_t MIN_PARALLEL_FETCH = 32;
+/** Lookups per task; several per thread, so that slow reads even out. */
+static const size_t FETCH_CHUNK_SIZE = 16;
+
 }
 
 CCoinsViewDB::CCoinsViewDB(size_t nCacheSize, bool fMemory, bool fWipe) : db(GetDataDir() / "chainstate", nCacheSize, fMemory, fWipe, true) 
@@ -66,6 +104,23 @@ bool CCoinsViewDB::HaveCoin(const COutPoint &outpoint) const {
     return db.Exists(CoinEntry(&outpoint));
 }
 
+void CCoinsViewDB::GetCoins(const std::vector<COutPoint>& outpoints, std::vector<Coin>& coins, std::vector<bool>& found) const {
+    if (nScriptCheckThreads == 0 || outpoints.size() < MIN_PARALLEL_FETCH)
+        return CCoinsView::GetCoins(outpoints, coins, found);
+
+    // The reads are independent, and LevelDB serves concurrent readers, so
+    // the disk latency of a block's worth of lookups overlaps.
+    coins.assign(outpoints.size(), Coin());
+    std::vector<char> vFound(outpoints.size());
+    std::vector<CCheckTask> vTasks;
+    for (size_t nPos = 0; nPos < outpoints.size(); nPos += FETCH_CHUNK_SIZE) {
+        vTasks.emplace_back(CCoinsFetch(*this, &outpoints[nPos], &coins[nPos], &vFound[nPos], std::min(FETCH_CHUNK_SIZE, outpoints.size() - nPos)));
+    }
+    if (!RunCheckTasks(vTasks))
+        throw dbwrapper_error("Database I/O error");
+    found.assign(vFound.begin(), vFound.end());
+}
+
 uint256 CCoinsViewDB::GetBestBlock() const {
     uint256 hashBestChain;
     if (!db.Read(DB_BEST_BLOCK, hashBestChain))
@@ -170,6 +225,48 @@ bool CBlockTreeDB::ReadLastBlockFile(int &nFile) {
     return Read(DB_LAST_BLOCK, nFile);
 }
 
+bool CCoinsViewDB::WriteSnapshotCoins(const std::vector<std::pair<COutPoint, Coin>>& coins, const uint256& hashBlock, bool fFinal) {
+    CDBBatch batch(db);
+    size_t batch_size = (size_t)gArgs.GetArg("-dbbatchsize", nDefaultDbBatchSize);
+    assert(!hashBlock.IsNull());
+
+    for (const auto& entry : coins) {
+        batch.Write(CoinEntry(&entry.first), entry.second);
+        if (batch.SizeEstimate() > batch_size) {
+            LogPrint(BCLog::COINDB, "Writing partial snapshot batch of %.2f MiB\n", batch.SizeEstimate() * (1.0 / 1048576.0));
+            if (!db.WriteBatch(batch)) return false;
+            batch.Clear();
+        }
+    }
+
+    if (fFinal) {
+        batch.Write(DB_BEST_BLOCK, hashBlock);
+    } else {
+        // The cache may have written the genesis block as the best block
+        batch.Erase(DB_BEST_BLOCK);
+    }
+    return db.WriteBatch(batch, fFinal);
+}
+
+bool CCoinsViewDB::EraseSnapshotCoins() {
+    std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
+    CDBBatch batch(db);
+    size_t batch_size = (size_t)gArgs.GetArg("-dbbatchsize", nDefaultDbBatchSize);
+
+    COutPoint outpoint;
+    CoinEntry entry(&outpoint);
+    for (pcursor->Seek(DB_COIN); pcursor->Valid(); pcursor->Next()) {
+        if (!pcursor->GetKey(entry) || entry.key != DB_COIN) break;
+        batch.Erase(entry);
+        if (batch.SizeEstimate() > batch_size) {
+            if (!db.WriteBatch(batch)) return false;
+            batch.Clear();
+        }
+    }
+    batch.Erase(DB_BEST_BLOCK);
+    return db.WriteBatch(batch, true);
+}
+
 CCoinsViewCursor *CCoinsViewDB::Cursor() const
 {
     CCoinsViewDBCursor *i = new CCoinsViewDBCursor(const_cast<CDBWrapper&>(db).NewIterator(), GetBestBlock());
@@ -259,6 +356,18 @@ bool CBlockTreeDB::ReadFlag(const std::string &name, bool &fValue) {
     return true;
 }
 
+bool CBlockTreeDB::HasKawpowHeaderFormat() {
+    bool fKawpowHeaders = false;
+    if (ReadFlag("kawpowheaders", fKawpowHeaders))
+        return fKawpowHeaders;
+
+    // Without the flag, only a database holding no block index yet is usable
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+    pcursor->Seek(std::make_pair(DB_BLOCK_INDEX, uint256()));
+    std::pair<char, uint256> key;
+    return !(pcursor->Valid() && pcursor->GetKey(key) && key.first == DB_BLOCK_INDEX);
+}
+
 bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex)
 {
     std::unique_ptr<CDBIterator> pcursor(NewIterator());
@@ -284,17 +393,24 @@ bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams,
                 pindexNew->nTime          = diskindex.nTime;
                 pindexNew->nBits          = diskindex.nBits;
                 pindexNew->nNonce         = diskindex.nNonce;
+                pindexNew->nMixHash       = diskindex.nMixHash;
+                pindexNew->hashPoW        = diskindex.hashPoW;
                 pindexNew->nStatus        = diskindex.nStatus;
                 pindexNew->nTx            = diskindex.nTx;
 
-                // NoteCoin: Disable PoW Sanity check while loading block index from disk.
-                // We use the sha256 hash for the block index for performance reasons, which is recorded for later use.
-                // CheckProofOfWork() uses the scrypt hash which is discarded after a block is accepted.
-                // While it is technically feasible to verify the PoW, doing so takes several minutes as it
-                // requires recomputing every PoW hash during every NoteCoin startup.
-                // We opt instead to simply trust the data that is on your local disk.
-                //if (!CheckProofOfWork(pindexNew->GetBlockHash(), pindexNew->nBits, consensusParams))
-                //    return error("%s: CheckProofOfWork failed: %s", __func__, pindexNew->ToString());
+                // Recomputing the KawPoW mix of every header needs the DAG and
+                // takes far too long for every startup; that is left to the
+                // optional background pass (-checkblockpow). The final hash
+                // from the stored mix digest is only two Keccak-f[800] passes,
+                // so check that here, and that it still equals the hash recorded
+                // when the header was fully verified.
+                if (pindexNew->GetBlockHash() != consensusParams.hashGenesisBlock) {
+                    const uint256 hashPoW = kawpow::HashPoWLight(pindexNew->GetBlockHeader());
+                    if (!CheckProofOfWork(hashPoW, pindexNew->nBits, consensusParams))
+                        return error("%s: CheckProofOfWork failed: %s", __func__, pindexNew->ToString());
+                    if ((pindexNew->nStatus & BLOCK_POW_VERIFIED) && hashPoW != pindexNew->hashPoW)
+                        return error("%s: recorded PoW hash mismatch: %s", __func__, pindexNew->ToString());
+                }
 
                 pcursor->Next();
             } else {
@@ -74,11 +74,22 @@ public:
 
     bool GetCoin(const COutPoint &outpoint, Coin &coin) const override;
     bool HaveCoin(const COutPoint &outpoint) const override;
+    //! Spreads large batches over the coin fetching threads, if any are running
+    void GetCoins(const std::vector<COutPoint>& outpoints, std::vector<Coin>& coins, std::vector<bool>& found) const override;
     uint256 GetBestBlock() const override;
     std::vector<uint256> GetHeadBlocks() const override;
     bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) override;
     CCoinsViewCursor *Cursor() const override;
 
+    /**
+     * Write coins loaded from a UTXO snapshot straight to the database, in
+     * batches of -dbbatchsize. The best block is unset until the final call
+     * sets it to hashBlock, so a partly loaded chainstate is never used.
+     */
+    bool WriteSnapshotCoins(const std::vector<std::pair<COutPoint, Coin>>& coins, const uint256& hashBlock, bool fFinal);
+    /** Erase the coins of a UTXO snapshot that failed to load, leaving the chainstate empty. */
+    bool EraseSnapshotCoins();
+
     //! Attempt to update from an older database format. Returns whether an error occurred.
     bool Upgrade();
     size_t EstimateSize() const override;
@@ -124,6 +135,8 @@ public:
     bool WriteTxIndex(const std::vector<std::pair<uint256, CDiskTxPos> > &vect);
     bool WriteFlag(const std::string &name, bool fValue);
     bool ReadFlag(const std::string &name, bool &fValue);
+    /** Whether block index entries were written with the KawPoW header fields (height, 64-bit nonce, mix hash). */
+    bool HasKawpowHeaderFormat();
     bool LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex);
 };
 
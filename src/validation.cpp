@@ -17,6 +17,7 @@
 #include <cuckoocache.h>
 #include <hash.h>
 #include <init.h>
+#include <kawpow/kawpow.h>
 #include <policy/fees.h>
 #include <policy/policy.h>
 #include <policy/rbf.h>
@@ -40,8 +41,11 @@
 #include <validationinterface.h>
 #include <warnings.h>
 
+#include <atomic>
 #include <future>
 #include <sstream>
+#include <thread>
+#include <unordered_set>
 
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/algorithm/string/join.hpp>
@@ -160,7 +164,7 @@ public:
 
     bool ActivateBestChain(CValidationState &state, const CChainParams& chainparams, std::shared_ptr<const CBlock> pblock);
 
-    bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex);
+    bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, const uint256* pHashPoW = nullptr);
     bool AcceptBlock(const std::shared_ptr<const CBlock>& pblock, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, bool fRequested, const CDiskBlockPos* dbp, bool* fNewBlock);
 
     // Block (dis)connection on a given view:
@@ -182,6 +186,9 @@ public:
 
     void PruneBlockIndexCandidates();
 
+    /** Mark the headers up to pindexBase as valid blocks whose data we do not have, as loaded from a UTXO snapshot. */
+    void MarkSnapshotChain(CBlockIndex* pindexBase, const std::vector<unsigned int>& vTxCount, const Consensus::Params& consensusParams);
+
     void UnloadBlockIndex();
 
 private:
@@ -216,6 +223,7 @@ std::atomic_bool fImporting(false);
 std::atomic_bool fReindex(false);
 bool fTxIndex = false;
 bool fHavePruned = false;
+bool fHaveUTXOSnapshot = false;
 bool fPruneMode = false;
 bool fIsBareMultisigStd = DEFAULT_PERMIT_BAREMULTISIG;
 bool fRequireStandard = true;
@@ -228,6 +236,7 @@ bool fEnableReplacement = DEFAULT_ENABLE_REPLACEMENT;
 
 uint256 hashAssumeValid;
 arith_uint256 nMinimumChainWork;
+static AssumeValidStats assumeValidStats;
 
 CFeeRate minRelayTxFee = CFeeRate(DEFAULT_MIN_RELAY_TX_FEE);
 CAmount maxTxFee = DEFAULT_TRANSACTION_MAXFEE;
@@ -645,11 +654,19 @@ static bool AcceptToMemoryPoolWorker(const CChainParams& chainparams, CTxMemPool
         CCoinsViewMemPool viewMemPool(pcoinsTip.get(), pool);
         view.SetBackend(viewMemPool);
 
-        // do all inputs exist?
-        for (const CTxIn txin : tx.vin) {
+        // Look all inputs up together, remembering which ones this pulls into pcoinsTip
+        std::vector<COutPoint> prevouts;
+        prevouts.reserve(tx.vin.size());
+        for (const CTxIn& txin : tx.vin) {
             if (!pcoinsTip->HaveCoinInCache(txin.prevout)) {
                 coins_to_uncache.push_back(txin.prevout);
             }
+            prevouts.push_back(txin.prevout);
+        }
+        view.FetchCoins(prevouts);
+
+        // do all inputs exist?
+        for (const CTxIn txin : tx.vin) {
             if (!view.HaveCoin(txin.prevout)) {
                 // Are inputs missing because we already have the tx?
                 for (size_t out = 0; out < tx.vout.size(); out++) {
@@ -1120,7 +1137,7 @@ bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus:
     }
 
     // Check the header
-    if (!CheckProofOfWork(block.GetPoWHash(), block.nBits, consensusParams))
+    if (!CheckBlockProofOfWork(block, consensusParams))
         return error("ReadBlockFromDisk: Errors in block header at %s", pos.ToString());
 
     return true;
@@ -1327,10 +1344,10 @@ void UpdateCoins(const CTransaction& tx, CCoinsViewCache& inputs, int nHeight)
     UpdateCoins(tx, inputs, txundo, nHeight);
 }
 
-bool CScriptCheck::operator()() {
+bool CScriptCheck::operator()(CSignatureBatch* batch) {
     const CScript &scriptSig = ptxTo->vin[nIn].scriptSig;
     const CScriptWitness *witness = &ptxTo->vin[nIn].scriptWitness;
-    return VerifyScript(scriptSig, m_tx_out.scriptPubKey, witness, nFlags, CachingTransactionSignatureChecker(ptxTo, nIn, m_tx_out.nValue, cacheStore, *txdata), &error);
+    return VerifyScript(scriptSig, m_tx_out.scriptPubKey, witness, nFlags, CachingTransactionSignatureChecker(ptxTo, nIn, m_tx_out.nValue, cacheStore, *txdata, batch), &error);
 }
 
 int GetSpendHeight(const CCoinsViewCache& inputs)
@@ -1341,7 +1358,7 @@ int GetSpendHeight(const CCoinsViewCache& inputs)
 }
 
 
-static CuckooCache::cache<uint256, SignatureCacheHasher> scriptExecutionCache;
+static CShardedCache scriptExecutionCache;
 static uint256 scriptExecutionCacheNonce(GetRandHash());
 
 void InitScriptExecutionCache() {
@@ -1353,6 +1370,18 @@ void InitScriptExecutionCache() {
             (nElems*sizeof(uint256)) >>20, (nMaxCacheSize*2)>>20, nElems);
 }
 
+CacheStats GetScriptExecutionCacheStats()
+{
+    return scriptExecutionCache.GetStats();
+}
+
+/** Make what the script checks of all threads stored in the script execution and signature caches visible */
+static void FlushScriptCaches()
+{
+    scriptExecutionCache.Flush();
+    FlushSignatureCache();
+}
+
 /**
  * Check whether all inputs of this transaction are valid (no double spends, scripts & sigs, amounts)
  * This does not modify the UTXO set.
@@ -1394,8 +1423,7 @@ bool CheckInputs(const CTransaction& tx, CValidationState &state, const CCoinsVi
             // round - giving us 19 + 32 + 4 = 55 bytes (+ 8 + 1 = 64)
             static_assert(55 - sizeof(flags) - 32 >= 128/8, "Want at least 128 bits of nonce for script execution cache");
             CSHA256().Write(scriptExecutionCacheNonce.begin(), 55 - sizeof(flags) - 32).Write(tx.GetWitnessHash().begin(), 32).Write((unsigned char*)&flags, sizeof(flags)).Finalize(hashCacheEntry.begin());
-            AssertLockHeld(cs_main); //TODO: Remove this requirement by making CuckooCache not require external locks
-            if (scriptExecutionCache.contains(hashCacheEntry, !cacheFullScriptStore)) {
+            if (scriptExecutionCache.Contains(hashCacheEntry, !cacheFullScriptStore)) {
                 return true;
             }
 
@@ -1442,7 +1470,7 @@ bool CheckInputs(const CTransaction& tx, CValidationState &state, const CCoinsVi
             if (cacheFullScriptStore && !pvChecks) {
                 // We executed all of the provided scripts, and were told to
                 // cache the result. Do so now.
-                scriptExecutionCache.insert(hashCacheEntry);
+                scriptExecutionCache.Insert(hashCacheEntry);
             }
         }
     }
@@ -1687,6 +1715,40 @@ static bool WriteTxIndexDataForBlock(const CBlock& block, CValidationState& stat
     return true;
 }
 
+/**
+ * Script checks taken from the queue together defer their signatures to a
+ * single batch. A check that fails with deferred signatures, or one that had
+ * a deferred signature turn out invalid, is rerun on its own; that decides
+ * its outcome and leaves the right script error in it.
+ */
+template <>
+bool RunChecks(std::vector<CScriptCheck>& vChecks)
+{
+    CSignatureBatch batch;
+    std::vector<size_t> vBatchBegin;
+    vBatchBegin.reserve(vChecks.size() + 1);
+    for (CScriptCheck& check : vChecks) {
+        const size_t nBegin = batch.size();
+        if (!check(&batch)) {
+            batch.Truncate(nBegin);
+            if (!check())
+                return false;
+        }
+        vBatchBegin.push_back(nBegin);
+    }
+    vBatchBegin.push_back(batch.size());
+
+    std::vector<bool> vValid;
+    if (batch.Verify(&vValid))
+        return true;
+    for (size_t i = 0; i < vChecks.size(); ++i) {
+        auto begin = vValid.begin() + vBatchBegin[i], end = vValid.begin() + vBatchBegin[i + 1];
+        if (std::find(begin, end, false) != end && !vChecks[i]())
+            return false;
+    }
+    return true;
+}
+
 static CCheckQueue<CScriptCheck> scriptcheckqueue(128);
 
 void ThreadScriptCheck() {
@@ -1694,6 +1756,169 @@ void ThreadScriptCheck() {
     scriptcheckqueue.Thread();
 }
 
+namespace {
+
+/**
+ * Closure representing the full PoW check of one header. On success the
+ * KawPoW hash is written to the caller's slot, which otherwise stays null.
+ */
+class CPoWCheck
+{
+private:
+    const CBlockHeader* pheader;
+    const Consensus::Params* pparams;
+    uint256* phashPoW;
+
+public:
+    CPoWCheck(const CBlockHeader& header, const Consensus::Params& params, uint256& hashPoW) :
+        pheader(&header), pparams(&params), phashPoW(&hashPoW) {}
+
+    bool operator()() {
+        uint256 hash;
+        if (!CheckBlockProofOfWork(*pheader, *pparams, &hash) || !CheckBlockMixHash(*pheader))
+            return false;
+        *phashPoW = hash;
+        return true;
+    }
+};
+
+} // namespace
+
+/** PoW checks take milliseconds each and the other tasks are runs of work, so workers take few at a time. */
+static CCheckQueue<CCheckTask> taskcheckqueue(4);
+
+void ThreadTaskCheck() {
+    RenameThread("notecoin-taskch");
+    taskcheckqueue.Thread();
+}
+
+bool RunCheckTasks(std::vector<CCheckTask>& vTasks)
+{
+    CCheckQueueControl<CCheckTask> control(&taskcheckqueue);
+    control.Add(vTasks);
+    return control.Wait();
+}
+
+namespace {
+
+/**
+ * Closure running the context-free checks of a run of a block's
+ * transactions, and counting their legacy sigops into the caller's slot.
+ */
+class CTxCheck
+{
+private:
+    const CTransactionRef* ptxs;
+    size_t nCount;
+    unsigned int* pnSigOps;
+
+public:
+    CTxCheck(const CTransactionRef* txs, size_t count, unsigned int& nSigOps) :
+        ptxs(txs), nCount(count), pnSigOps(&nSigOps) {}
+
+    bool operator()() {
+        CValidationState state;
+        unsigned int nSigOps = 0;
+        for (size_t i = 0; i < nCount; ++i) {
+            if (!CheckTransaction(*ptxs[i], state, true))
+                return false;
+            nSigOps += GetLegacySigOpCount(*ptxs[i]);
+        }
+        *pnSigOps = nSigOps;
+        return true;
+    }
+};
+
+} // namespace
+
+/** Below this many transactions, CheckBlock checks them on the calling thread. */
+static const size_t MIN_PARALLEL_TX_CHECKS = 64;
+/** Transactions per task */
+static const size_t TX_CHECK_CHUNK_SIZE = 16;
+
+void ThreadCheckBlockIndexPoW()
+{
+    RenameThread("notecoin-powrecheck");
+    const Consensus::Params& consensusParams = Params().GetConsensus();
+
+    // Work on copies of the headers; block index entries live until shutdown.
+    std::vector<std::pair<CBlockIndex*, CBlockHeader>> vHeaders;
+    {
+        LOCK(cs_main);
+        vHeaders.reserve(mapBlockIndex.size());
+        for (const std::pair<const uint256, CBlockIndex*>& item : mapBlockIndex) {
+            if (item.first != consensusParams.hashGenesisBlock)
+                vHeaders.emplace_back(item.second, item.second->GetBlockHeader());
+        }
+    }
+    // Go in height order so all threads share the few epoch contexts kept cached
+    std::sort(vHeaders.begin(), vHeaders.end(), [](const std::pair<CBlockIndex*, CBlockHeader>& a, const std::pair<CBlockIndex*, CBlockHeader>& b) {
+        return a.second.nHeight < b.second.nHeight;
+    });
+
+    const int64_t nStart = GetTimeMillis();
+    const int nThreads = std::max(1, GetNumCores());
+    static const size_t nChunk = 16;
+    std::atomic<size_t> nNext(0);
+    std::atomic<bool> fFailed(false);
+    std::vector<uint256> vHashes(vHeaders.size());
+    std::mutex cs_failed;
+    const CBlockIndex* pindexFailed = nullptr;
+
+    auto worker = [&]() {
+        while (!fFailed && !ShutdownRequested()) {
+            const size_t nBegin = nNext.fetch_add(nChunk);
+            if (nBegin >= vHeaders.size()) return;
+            const size_t nEnd = std::min(nBegin + nChunk, vHeaders.size());
+            for (size_t i = nBegin; i < nEnd; ++i) {
+                uint256 mix_hash;
+                vHashes[i] = kawpow::HashPoW(vHeaders[i].second, mix_hash);
+                if (mix_hash != vHeaders[i].second.nMixHash || !CheckProofOfWork(vHashes[i], vHeaders[i].second.nBits, consensusParams)) {
+                    std::lock_guard<std::mutex> lock(cs_failed);
+                    if (!fFailed) {
+                        pindexFailed = vHeaders[i].first;
+                        fFailed = true;
+                    }
+                    return;
+                }
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int i = 1; i < nThreads; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    if (fFailed) {
+        AbortNode(strprintf("%s: stored header failed the proof-of-work recheck: %s", __func__, pindexFailed->ToString()),
+                  _("Corrupted block database detected") + ". " + _("Please restart with -reindex to recover."));
+        return;
+    }
+    if (ShutdownRequested())
+        return;
+
+    // Record the hash of entries written before it was kept in the index
+    size_t nRecorded = 0;
+    {
+        LOCK(cs_main);
+        for (size_t i = 0; i < vHeaders.size(); ++i) {
+            CBlockIndex* pindex = vHeaders[i].first;
+            if (!(pindex->nStatus & BLOCK_POW_VERIFIED)) {
+                pindex->hashPoW = vHashes[i];
+                pindex->nStatus |= BLOCK_POW_VERIFIED;
+                setDirtyBlockIndex.insert(pindex);
+                ++nRecorded;
+            }
+        }
+    }
+    LogPrintf("%s: verified the proof of work of %u headers (%u newly recorded) on %d threads in %dms\n",
+        __func__, vHeaders.size(), nRecorded, nThreads, GetTimeMillis() - nStart);
+}
+
 // Protected by cs_main
 VersionBitsCache versionbitscache;
 
@@ -1777,6 +2002,7 @@ static unsigned int GetBlockScriptFlags(const CBlockIndex* pindex, const Consens
 
 static int64_t nTimeCheck = 0;
 static int64_t nTimeForks = 0;
+static int64_t nTimePrefetch = 0;
 static int64_t nTimeVerify = 0;
 static int64_t nTimeConnect = 0;
 static int64_t nTimeIndex = 0;
@@ -1784,6 +2010,12 @@ static int64_t nTimeCallbacks = 0;
 static int64_t nTimeTotal = 0;
 static int64_t nBlocksTotal = 0;
 
+AssumeValidStats GetAssumeValidStats()
+{
+    AssertLockHeld(cs_main);
+    return assumeValidStats;
+}
+
 /** Apply the effects of this block (with given index) on the UTXO set represented by coins.
  *  Validity checks that depend on the UTXO set are also done; ConnectBlock()
  *  can fail if those validity checks fail (among other reasons). */
@@ -1904,9 +2136,37 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
     // Get the script flags for this block
     unsigned int flags = GetBlockScriptFlags(pindex, chainparams.GetConsensus());
 
+    // Make the entries that mempool acceptance stored since the last block
+    // visible to the script check threads.
+    FlushScriptCaches();
+
     int64_t nTime2 = GetTimeMicros(); nTimeForks += nTime2 - nTime1;
+    const CacheStats sigCacheBefore = GetSignatureCacheStats(), scriptCacheBefore = GetScriptExecutionCacheStats();
     LogPrint(BCLog::BENCH, "    - Fork checks: %.2fms [%.2fs (%.2fms/blk)]\n", MILLI * (nTime2 - nTime1), nTimeForks * MICRO, nTimeForks * MILLI / nBlocksTotal);
 
+    // Bring the coins spent by the block into the cache in one batch up
+    // front, so that the loop below does not wait for the database input by
+    // input, and the script checks it queues follow each other quickly.
+    // Outputs created earlier in the block are left out; UpdateCoins adds
+    // them when their transaction is connected.
+    {
+        std::unordered_set<uint256, SaltedTxidHasher> setBlockTxids;
+        setBlockTxids.reserve(block.vtx.size());
+        std::vector<COutPoint> vPrevouts;
+        for (const auto& tx : block.vtx) {
+            setBlockTxids.insert(tx->GetHash());
+            if (tx->IsCoinBase())
+                continue;
+            for (const CTxIn& txin : tx->vin) {
+                if (!setBlockTxids.count(txin.prevout.hash))
+                    vPrevouts.push_back(txin.prevout);
+            }
+        }
+        view.FetchCoins(vPrevouts);
+        int64_t nTimePrefetched = GetTimeMicros(); nTimePrefetch += nTimePrefetched - nTime2;
+        LogPrint(BCLog::BENCH, "    - Prefetch %u coins: %.2fms [%.2fs (%.2fms/blk)]\n", (unsigned)vPrevouts.size(), MILLI * (nTimePrefetched - nTime2), nTimePrefetch * MICRO, nTimePrefetch * MILLI / nBlocksTotal);
+    }
+
     CBlockUndo blockundo;
 
     CCheckQueueControl<CScriptCheck> control(fScriptChecks && nScriptCheckThreads ? &scriptcheckqueue : nullptr);
@@ -1988,8 +2248,30 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
 
     if (!control.Wait())
         return state.DoS(100, error("%s: CheckQueue failed", __func__), REJECT_INVALID, "block-validation-failed");
+    if (!fJustCheck) {
+        if (!fScriptChecks) {
+            assumeValidStats.blocks++;
+            assumeValidStats.inputs += nInputs - 1;
+            assumeValidStats.last_height = pindex->nHeight;
+        } else if (assumeValidStats.last_height == pindex->nHeight - 1) {
+            LogPrintf("Script checks resume at height %d; skipped them for %u inputs in %u blocks under -assumevalid=%s\n",
+                pindex->nHeight, assumeValidStats.inputs, assumeValidStats.blocks, hashAssumeValid.GetHex());
+        }
+    }
+    FlushScriptCaches();
     int64_t nTime4 = GetTimeMicros(); nTimeVerify += nTime4 - nTime2;
     LogPrint(BCLog::BENCH, "    - Verify %u txins: %.2fms (%.3fms/txin) [%.2fs (%.2fms/blk)]\n", nInputs - 1, MILLI * (nTime4 - nTime2), nInputs <= 1 ? 0 : MILLI * (nTime4 - nTime2) / (nInputs-1), nTimeVerify * MICRO, nTimeVerify * MILLI / nBlocksTotal);
+    if (LogAcceptCategory(BCLog::BENCH)) {
+        const CacheStats sigCache = GetSignatureCacheStats(), scriptCache = GetScriptExecutionCacheStats();
+        LogPrint(BCLog::BENCH, "    - Signature cache: %u hits, %u misses, %u evictions; script cache: %u hits, %u misses, %u evictions\n",
+            sigCache.hits - sigCacheBefore.hits, sigCache.misses - sigCacheBefore.misses, sigCache.evictions - sigCacheBefore.evictions,
+            scriptCache.hits - scriptCacheBefore.hits, scriptCache.misses - scriptCacheBefore.misses, scriptCache.evictions - scriptCacheBefore.evictions);
+        if (fScriptChecks && nScriptCheckThreads) {
+            const CheckQueueStats queueStats = scriptcheckqueue.GetLastStats();
+            LogPrint(BCLog::BENCH, "    - Script check queue: %u checks on %u threads, %u steals, %.1f%% utilization\n",
+                queueStats.checks, queueStats.threads, queueStats.steals, 100.0 * queueStats.Utilization());
+        }
+    }
 
     if (fJustCheck)
         return true;
@@ -2469,6 +2751,29 @@ void CChainState::PruneBlockIndexCandidates() {
     assert(!setBlockIndexCandidates.empty());
 }
 
+void CChainState::MarkSnapshotChain(CBlockIndex* pindexBase, const std::vector<unsigned int>& vTxCount, const Consensus::Params& consensusParams) {
+    AssertLockHeld(cs_main);
+    assert(vTxCount.size() == (size_t)pindexBase->nHeight);
+
+    std::vector<CBlockIndex*> vChain(pindexBase->nHeight + 1);
+    for (CBlockIndex* pindex = pindexBase; pindex != nullptr; pindex = pindex->pprev) {
+        vChain[pindex->nHeight] = pindex;
+    }
+    for (int nHeight = 1; nHeight <= pindexBase->nHeight; nHeight++) {
+        // Like a pruned block: its transactions count toward nChainTx, but
+        // there is no block data to serve or to reorganize over.
+        CBlockIndex* pindex = vChain[nHeight];
+        pindex->nTx = vTxCount[nHeight - 1];
+        pindex->nChainTx = pindex->pprev->nChainTx + pindex->nTx;
+        if (IsWitnessEnabled(pindex->pprev, consensusParams)) {
+            pindex->nStatus |= BLOCK_OPT_WITNESS;
+        }
+        pindex->RaiseValidity(BLOCK_VALID_SCRIPTS);
+        setDirtyBlockIndex.insert(pindex);
+    }
+    setBlockIndexCandidates.insert(pindexBase);
+}
+
 /**
  * Try to make some progress towards making pindexMostWork the active block.
  * pblock is either nullptr or a pointer to a CBlock corresponding to pindexMostWork.
@@ -2839,6 +3144,7 @@ CBlockIndex* CChainState::AddToBlockIndex(const CBlockHeader& block)
         pindexNew->BuildSkip();
     }
     pindexNew->nTimeMax = (pindexNew->pprev ? std::max(pindexNew->pprev->nTimeMax, pindexNew->nTime) : pindexNew->nTime);
+    pindexNew->BuildMedianTimePast();
     pindexNew->nChainWork = (pindexNew->pprev ? pindexNew->pprev->nChainWork : 0) + GetBlockProof(*pindexNew);
     pindexNew->RaiseValidity(BLOCK_VALID_TREE);
     if (pindexBestHeader == nullptr || pindexBestHeader->nChainWork < pindexNew->nChainWork)
@@ -2986,10 +3292,10 @@ static bool FindUndoPos(CValidationState &state, int nFile, CDiskBlockPos &pos,
     return true;
 }
 
-static bool CheckBlockHeader(const CBlockHeader& block, CValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW = true)
+static bool CheckBlockHeader(const CBlockHeader& block, CValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW = true, uint256* pow_hash = nullptr)
 {
     // Check proof of work matches claimed amount
-    if (fCheckPOW && !CheckProofOfWork(block.GetPoWHash(), block.nBits, consensusParams))
+    if (fCheckPOW && !CheckBlockProofOfWork(block, consensusParams, pow_hash))
         return state.DoS(50, false, REJECT_INVALID, "high-hash", false, "proof of work failed");
 
     return true;
@@ -3038,16 +3344,35 @@ bool CheckBlock(const CBlock& block, CValidationState& state, const Consensus::P
         if (block.vtx[i]->IsCoinBase())
             return state.DoS(100, false, REJECT_INVALID, "bad-cb-multiple", false, "more than one coinbase");
 
-    // Check transactions
-    for (const auto& tx : block.vtx)
-        if (!CheckTransaction(*tx, state, true))
-            return state.Invalid(false, state.GetRejectCode(), state.GetRejectReason(),
-                                 strprintf("Transaction check failed (tx hash %s) %s", tx->GetHash().ToString(), state.GetDebugMessage()));
-
+    // Check transactions. Large blocks are checked on the check threads
+    // first; if that finds a problem, the serial loop below runs to report
+    // the first failing transaction, as it would have without them.
     unsigned int nSigOps = 0;
-    for (const auto& tx : block.vtx)
-    {
-        nSigOps += GetLegacySigOpCount(*tx);
+    bool fParallelOk = false;
+    if (nScriptCheckThreads && block.vtx.size() >= MIN_PARALLEL_TX_CHECKS) {
+        std::vector<unsigned int> vSigOps((block.vtx.size() + TX_CHECK_CHUNK_SIZE - 1) / TX_CHECK_CHUNK_SIZE);
+        std::vector<CCheckTask> vTasks;
+        vTasks.reserve(vSigOps.size());
+        for (size_t i = 0; i < vSigOps.size(); ++i) {
+            const size_t nPos = i * TX_CHECK_CHUNK_SIZE;
+            vTasks.emplace_back(CTxCheck(&block.vtx[nPos], std::min(TX_CHECK_CHUNK_SIZE, block.vtx.size() - nPos), vSigOps[i]));
+        }
+        if (RunCheckTasks(vTasks)) {
+            for (unsigned int n : vSigOps)
+                nSigOps += n;
+            fParallelOk = true;
+        }
+    }
+    if (!fParallelOk) {
+        for (const auto& tx : block.vtx)
+            if (!CheckTransaction(*tx, state, true))
+                return state.Invalid(false, state.GetRejectCode(), state.GetRejectReason(),
+                                     strprintf("Transaction check failed (tx hash %s) %s", tx->GetHash().ToString(), state.GetDebugMessage()));
+
+        for (const auto& tx : block.vtx)
+        {
+            nSigOps += GetLegacySigOpCount(*tx);
+        }
     }
     if (nSigOps * WITNESS_SCALE_FACTOR > MAX_BLOCK_SIGOPS_COST)
         return state.DoS(100, false, REJECT_INVALID, "bad-blk-sigops", false, "out-of-bounds SigOpCount");
@@ -3139,6 +3464,10 @@ static bool ContextualCheckBlockHeader(const CBlockHeader& block, CValidationSta
     if (block.nBits != GetNextWorkRequired(pindexPrev, &block, consensusParams))
         return state.DoS(100, false, REJECT_INVALID, "bad-diffbits", false, "incorrect proof of work");
 
+    // The height selects the KawPoW epoch and program, so it must be the real one
+    if (block.nHeight != (uint32_t)nHeight)
+        return state.DoS(100, false, REJECT_INVALID, "bad-height", false, "incorrect block height in header");
+
     // Check against checkpoints
     if (fCheckpointsEnabled) {
         // Don't accept any forks from the main chain prior to last checkpoint.
@@ -3259,13 +3588,15 @@ static bool ContextualCheckBlock(const CBlock& block, CValidationState& state, c
     return true;
 }
 
-bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex)
+/** pHashPoW, if given, is the KawPoW hash of a header whose PoW was already fully checked. */
+bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, const uint256* pHashPoW)
 {
     AssertLockHeld(cs_main);
     // Check for duplicate
     uint256 hash = block.GetHash();
     BlockMap::iterator miSelf = mapBlockIndex.find(hash);
     CBlockIndex *pindex = nullptr;
+    uint256 hashPoW;
     if (hash != chainparams.GetConsensus().hashGenesisBlock) {
 
         if (miSelf != mapBlockIndex.end()) {
@@ -3278,8 +3609,10 @@ bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState&
             return true;
         }
 
-        if (!CheckBlockHeader(block, state, chainparams.GetConsensus()))
+        if (!CheckBlockHeader(block, state, chainparams.GetConsensus(), pHashPoW == nullptr, &hashPoW))
             return error("%s: Consensus::CheckBlockHeader: %s, %s", __func__, hash.ToString(), FormatStateMessage(state));
+        if (pHashPoW)
+            hashPoW = *pHashPoW;
 
         // Get prev block index
         CBlockIndex* pindexPrev = nullptr;
@@ -3291,6 +3624,10 @@ bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState&
             return state.DoS(100, error("%s: prev block invalid", __func__), REJECT_INVALID, "bad-prevblk");
         if (!ContextualCheckBlockHeader(block, state, chainparams, pindexPrev, GetAdjustedTime()))
             return error("%s: Consensus::ContextualCheckBlockHeader: %s, %s", __func__, hash.ToString(), FormatStateMessage(state));
+        // The DAG check builds the epoch context selected by nHeight, so it
+        // only runs once nHeight and nBits are known to be the chain's.
+        if (pHashPoW == nullptr && !CheckBlockMixHash(block))
+            return state.DoS(50, error("%s: mix hash mismatch for %s", __func__, hash.ToString()), REJECT_INVALID, "high-hash", false, "proof of work failed");
 
         if (!pindexPrev->IsValid(BLOCK_VALID_SCRIPTS)) {
             for (const CBlockIndex* failedit : g_failed_blocks) {
@@ -3307,8 +3644,14 @@ bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState&
             }
         }
     }
-    if (pindex == nullptr)
+    if (pindex == nullptr) {
         pindex = AddToBlockIndex(block);
+        if (!hashPoW.IsNull()) {
+            // Record the verified hash so startup can check the index cheaply
+            pindex->hashPoW = hashPoW;
+            pindex->nStatus |= BLOCK_POW_VERIFIED;
+        }
+    }
 
     if (ppindex)
         *ppindex = pindex;
@@ -3322,11 +3665,45 @@ bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState&
 bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, CValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex, CBlockHeader *first_invalid)
 {
     if (first_invalid != nullptr) first_invalid->SetNull();
+
+    // The PoW check is by far the most expensive part of accepting a header,
+    // so run it for every new header of the batch on the check threads
+    // before taking cs_main for the loop below. The DAG check trusts nHeight,
+    // so this is only done for a batch that extends a known block with
+    // linked headers and consecutive heights; the loop rejects any other
+    // batch before doing DAG work for it. The queue skips the remaining
+    // checks after a failure. Headers whose check did not pass (or did not
+    // run) are checked again in order below, which also produces the usual
+    // error for them.
+    std::vector<uint256> vHashPoW(headers.size());
+    if (nScriptCheckThreads && !headers.empty()) {
+        std::vector<CCheckTask> vTasks;
+        {
+            LOCK(cs_main);
+            BlockMap::const_iterator mi = mapBlockIndex.find(headers[0].hashPrevBlock);
+            if (mi != mapBlockIndex.end() && !(mi->second->nStatus & BLOCK_FAILED_MASK)) {
+                uint256 hashPrev = headers[0].hashPrevBlock;
+                int nHeight = mi->second->nHeight;
+                for (size_t i = 0; i < headers.size(); ++i) {
+                    if (headers[i].hashPrevBlock != hashPrev || headers[i].nHeight != (uint32_t)++nHeight) {
+                        vTasks.clear();
+                        break;
+                    }
+                    hashPrev = headers[i].GetHash();
+                    if (!mapBlockIndex.count(hashPrev))
+                        vTasks.emplace_back(CPoWCheck(headers[i], chainparams.GetConsensus(), vHashPoW[i]));
+                }
+            }
+        }
+        RunCheckTasks(vTasks);
+    }
+
     {
         LOCK(cs_main);
-        for (const CBlockHeader& header : headers) {
+        for (size_t i = 0; i < headers.size(); ++i) {
+            const CBlockHeader& header = headers[i];
             CBlockIndex *pindex = nullptr; // Use a temp pindex instead of ppindex to avoid a const_cast
-            if (!g_chainstate.AcceptBlockHeader(header, state, chainparams, &pindex)) {
+            if (!g_chainstate.AcceptBlockHeader(header, state, chainparams, &pindex, vHashPoW[i].IsNull() ? nullptr : &vHashPoW[i])) {
                 if (first_invalid) *first_invalid = header;
                 return false;
             }
@@ -3485,6 +3862,8 @@ bool TestBlockValidity(CValidationState& state, const CChainParams& chainparams,
     // NOTE: CheckBlockHeader is called by CheckBlock
     if (!ContextualCheckBlockHeader(block, state, chainparams, pindexPrev, GetAdjustedTime()))
         return error("%s: Consensus::ContextualCheckBlockHeader: %s", __func__, FormatStateMessage(state));
+    if (fCheckPOW && !CheckBlockMixHash(block))
+        return state.DoS(50, error("%s: mix hash mismatch", __func__), REJECT_INVALID, "high-hash", false, "proof of work failed");
     if (!CheckBlock(block, state, chainparams.GetConsensus(), fCheckPOW, fCheckMerkleRoot))
         return error("%s: Consensus::CheckBlock: %s", __func__, FormatStateMessage(state));
     if (!ContextualCheckBlock(block, state, chainparams.GetConsensus(), pindexPrev))
@@ -3760,6 +4139,7 @@ bool CChainState::LoadBlockIndex(const Consensus::Params& consensus_params, CBlo
             pindexBestInvalid = pindex;
         if (pindex->pprev)
             pindex->BuildSkip();
+        pindex->BuildMedianTimePast();
         if (pindex->IsValid(BLOCK_VALID_TREE) && (pindexBestHeader == nullptr || CBlockIndexWorkComparator()(pindexBestHeader, pindex)))
             pindexBestHeader = pindex;
     }
@@ -3812,6 +4192,11 @@ bool static LoadBlockIndexDB(const CChainParams& chainparams)
     if (fHavePruned)
         LogPrintf("LoadBlockIndexDB(): Block files have previously been pruned\n");
 
+    // Check whether the chainstate was loaded from a UTXO snapshot
+    pblocktree->ReadFlag("utxosnapshot", fHaveUTXOSnapshot);
+    if (fHaveUTXOSnapshot)
+        LogPrintf("LoadBlockIndexDB(): Chainstate was loaded from a UTXO snapshot\n");
+
     // Check whether we need to continue reindexing
     bool fReindexing = false;
     pblocktree->ReadReindexing(fReindexing);
@@ -3893,7 +4278,7 @@ bool CVerifyDB::VerifyDB(const CChainParams& chainparams, CCoinsView *coinsview,
         uiInterface.ShowProgress(_("Verifying blocks..."), percentageDone, false);
         if (pindex->nHeight < chainActive.Height()-nCheckDepth)
             break;
-        if (fPruneMode && !(pindex->nStatus & BLOCK_HAVE_DATA)) {
+        if ((fPruneMode || fHavePruned) && !(pindex->nStatus & BLOCK_HAVE_DATA)) {
             // If pruning, only go back as far as we have data.
             LogPrintf("VerifyDB(): block verification stopping at height %d (pruning, no data)\n", pindex->nHeight);
             break;
@@ -4065,7 +4450,7 @@ bool CChainState::RewindBlockIndex(const CChainParams& params)
     CValidationState state;
     CBlockIndex* pindex = chainActive.Tip();
     while (chainActive.Height() >= nHeight) {
-        if (fPruneMode && !(chainActive.Tip()->nStatus & BLOCK_HAVE_DATA)) {
+        if ((fPruneMode || fHavePruned) && !(chainActive.Tip()->nStatus & BLOCK_HAVE_DATA)) {
             // If pruning, don't try rewinding past the HAVE_DATA point;
             // since older blocks can't be served anyway, there's
             // no need to walk further, and trying to DisconnectTip()
@@ -4182,6 +4567,7 @@ void UnloadBlockIndex()
     }
     mapBlockIndex.clear();
     fHavePruned = false;
+    fHaveUTXOSnapshot = false;
 
     g_chainstate.UnloadBlockIndex();
 }
@@ -4701,6 +5087,355 @@ bool DumpMempool(void)
     return true;
 }
 
+static const uint64_t UTXO_SNAPSHOT_VERSION = 1;
+static const unsigned char UTXO_SNAPSHOT_MAGIC[4] = {'u', 't', 'x', 'o'};
+//! Headers handed to ProcessNewBlockHeaders at once while loading a UTXO snapshot
+static const size_t SNAPSHOT_HEADERS_BATCH = 2000;
+//! Coins handed to the chainstate database at once while loading a UTXO snapshot
+static const size_t SNAPSHOT_COINS_BATCH = 100000;
+
+/*
+ * A UTXO snapshot file holds, in order:
+ * - the magic, the format version, the network's message start, and the
+ *   hash and height of the base block the UTXO set belongs to;
+ * - the headers of blocks 1 up to the base, each followed by its number of
+ *   transactions;
+ * - the coins grouped by txid: the txid, the number of outputs, then each
+ *   output index and coin; a null txid with no outputs ends the list;
+ * - the number of coins and the hash_serialized_2 of the UTXO set, which
+ *   can be compared against gettxoutsetinfo on any node.
+ */
+
+static void WriteSnapshotOutputs(CAutoFile& file, const uint256& txid, const std::map<uint32_t, Coin>& outputs)
+{
+    uint32_t count = outputs.size();
+    file << txid;
+    file << VARINT(count);
+    for (const auto& output : outputs) {
+        file << VARINT(output.first);
+        file << output.second;
+    }
+}
+
+/** Read the coins of the next transaction of a UTXO snapshot. Returns false at the end of the list. */
+static bool ReadSnapshotOutputs(CAutoFile& file, uint256& txid, std::map<uint32_t, Coin>& outputs)
+{
+    uint32_t count;
+    file >> txid;
+    file >> VARINT(count);
+    outputs.clear();
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t n;
+        Coin coin;
+        file >> VARINT(n);
+        file >> coin;
+        // The UTXO set hash only commits to the height and coinbase flag once per transaction
+        if (!outputs.empty() && (coin.nHeight != outputs.begin()->second.nHeight || coin.fCoinBase != outputs.begin()->second.fCoinBase)) {
+            throw std::ios_base::failure("inconsistent outputs of " + txid.ToString());
+        }
+        if (!outputs.emplace(n, std::move(coin)).second) {
+            throw std::ios_base::failure("duplicate output of " + txid.ToString());
+        }
+    }
+    return count != 0;
+}
+
+bool DumpUTXOSnapshot(const fs::path& path, UTXOSnapshotInfo& info)
+{
+    int64_t start = GetTimeMicros();
+    const CChainParams& chainparams = Params();
+
+    // The database cursor keeps reading the UTXO set as of the flush, and the
+    // headers of the active chain stay in memory, so only this part needs cs_main.
+    std::unique_ptr<CCoinsViewCursor> pcursor;
+    std::vector<std::pair<const CBlockIndex*, unsigned int>> vChain;
+    {
+        LOCK(cs_main);
+        FlushStateToDisk();
+        pcursor.reset(pcoinsdbview->Cursor());
+        BlockMap::const_iterator it = mapBlockIndex.find(pcursor->GetBestBlock());
+        if (it == mapBlockIndex.end()) {
+            return error("%s: chainstate best block not found", __func__);
+        }
+        const CBlockIndex* pindexBase = it->second;
+        vChain.resize(pindexBase->nHeight);
+        for (const CBlockIndex* pindex = pindexBase; pindex->pprev != nullptr; pindex = pindex->pprev) {
+            vChain[pindex->nHeight - 1] = std::make_pair(pindex, pindex->nTx);
+        }
+        info.base_blockhash = pindexBase->GetBlockHash();
+        info.base_height = pindexBase->nHeight;
+        info.coins_count = 0;
+    }
+
+    int64_t mid = GetTimeMicros();
+
+    fs::path pathTmp = path;
+    pathTmp += ".incomplete";
+    try {
+        FILE* filestr = fsbridge::fopen(pathTmp, "wb");
+        if (!filestr) {
+            return error("%s: unable to open %s", __func__, pathTmp.string());
+        }
+
+        CAutoFile file(filestr, SER_DISK, CLIENT_VERSION);
+        file.write((const char*)UTXO_SNAPSHOT_MAGIC, sizeof(UTXO_SNAPSHOT_MAGIC));
+        file << UTXO_SNAPSHOT_VERSION;
+        file.write((const char*)chainparams.MessageStart(), CMessageHeader::MESSAGE_START_SIZE);
+        file << info.base_blockhash;
+        file << info.base_height;
+
+        for (const auto& entry : vChain) {
+            file << entry.first->GetBlockHeader();
+            file << VARINT(entry.second);
+        }
+
+        CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
+        ss << info.base_blockhash;
+        uint256 prevkey;
+        std::map<uint32_t, Coin> outputs;
+        while (pcursor->Valid()) {
+            boost::this_thread::interruption_point();
+            COutPoint key;
+            Coin coin;
+            if (!pcursor->GetKey(key) || !pcursor->GetValue(coin)) {
+                return error("%s: unable to read coin", __func__);
+            }
+            if (!outputs.empty() && key.hash != prevkey) {
+                ApplyTxOutSetHash(ss, prevkey, outputs);
+                WriteSnapshotOutputs(file, prevkey, outputs);
+                outputs.clear();
+            }
+            prevkey = key.hash;
+            outputs[key.n] = std::move(coin);
+            info.coins_count++;
+            pcursor->Next();
+        }
+        if (!outputs.empty()) {
+            ApplyTxOutSetHash(ss, prevkey, outputs);
+            WriteSnapshotOutputs(file, prevkey, outputs);
+        }
+        WriteSnapshotOutputs(file, uint256(), std::map<uint32_t, Coin>());
+        info.txoutset_hash = ss.GetHash();
+
+        file << info.coins_count;
+        file << info.txoutset_hash;
+        FileCommit(file.Get());
+        file.fclose();
+        if (!RenameOver(pathTmp, path)) {
+            return error("%s: unable to rename %s", __func__, pathTmp.string());
+        }
+        int64_t last = GetTimeMicros();
+        LogPrintf("Dumped UTXO snapshot at height %d: %u coins, %gs to flush, %gs to dump\n", info.base_height, info.coins_count, (mid-start)*MICRO, (last-mid)*MICRO);
+    } catch (const std::exception& e) {
+        return error("%s: failed to dump UTXO snapshot: %s", __func__, e.what());
+    }
+    return true;
+}
+
+/** Erase what a failed LoadUTXOSnapshot wrote, so that the node can start without the snapshot. */
+static void AbandonUTXOSnapshot()
+{
+    // If this fails, the next startup reports an interrupted load instead
+    if (!pcoinsdbview->EraseSnapshotCoins()) {
+        LogPrintf("%s: failed to erase the coins of the UTXO snapshot\n", __func__);
+        return;
+    }
+    fHaveUTXOSnapshot = false;
+    pblocktree->WriteFlag("utxosnapshot", false);
+}
+
+bool LoadUTXOSnapshot(const CChainParams& chainparams, const fs::path& path, std::string& strError)
+{
+    // The UTXO set at the genesis block is empty
+    const uint256 hashBest = pcoinsTip->GetBestBlock();
+    if (!hashBest.IsNull() && hashBest != chainparams.GetConsensus().hashGenesisBlock) {
+        LogPrintf("%s: chainstate is not empty, ignoring %s\n", __func__, path.string());
+        return true;
+    }
+
+    int64_t start = GetTimeMicros();
+    FILE* filestr = fsbridge::fopen(path, "rb");
+    CAutoFile file(filestr, SER_DISK, CLIENT_VERSION);
+    if (file.IsNull()) {
+        strError = strprintf(_("Unable to open UTXO snapshot %s"), path.string());
+        return false;
+    }
+
+    uiInterface.InitMessage(_("Loading UTXO snapshot..."));
+    LogPrintf("Loading UTXO snapshot from %s\n", path.string());
+
+    bool fWriting = false;
+    try {
+        unsigned char magic[sizeof(UTXO_SNAPSHOT_MAGIC)];
+        uint64_t version;
+        CMessageHeader::MessageStartChars message_start;
+        file.read((char*)magic, sizeof(magic));
+        file >> version;
+        file.read((char*)message_start, sizeof(message_start));
+        if (memcmp(magic, UTXO_SNAPSHOT_MAGIC, sizeof(magic)) != 0 || version != UTXO_SNAPSHOT_VERSION) {
+            strError = _("Unsupported UTXO snapshot format");
+            return false;
+        }
+        if (memcmp(message_start, chainparams.MessageStart(), sizeof(message_start)) != 0) {
+            strError = _("The UTXO snapshot is for a different network");
+            return false;
+        }
+
+        UTXOSnapshotInfo info;
+        file >> info.base_blockhash;
+        file >> info.base_height;
+        const MapAssumeutxo::const_iterator it_assumeutxo = chainparams.Assumeutxo().find(info.base_blockhash);
+        if (it_assumeutxo == chainparams.Assumeutxo().end()) {
+            strError = strprintf(_("The UTXO snapshot at block %s is not one this software accepts"), info.base_blockhash.ToString());
+            return false;
+        }
+        // The height sizes what is read below, so it must be the listed one
+        const AssumeutxoData& assumeutxo = it_assumeutxo->second;
+        if (info.base_height != assumeutxo.height) {
+            strError = strprintf(_("The UTXO snapshot claims height %d for block %s, expected %d"), info.base_height, info.base_blockhash.ToString(), assumeutxo.height);
+            return false;
+        }
+
+        // A load that was interrupted may have left coins behind
+        if (fHaveUTXOSnapshot) {
+            LogPrintf("Restarting an interrupted UTXO snapshot load\n");
+            if (!pcoinsdbview->EraseSnapshotCoins()) {
+                strError = _("Failed to write to coin database");
+                return false;
+            }
+        }
+
+        // The headers are accepted as if received from a peer, so their PoW
+        // is checked on the check threads. That needs an active chain, so
+        // connect the genesis block first. An interrupted load leaves the
+        // headers in the block index, and LoadChainTip then only connects
+        // genesis if the coins view says so; the UTXO set there is empty.
+        bool fHaveTip;
+        {
+            LOCK(cs_main);
+            fHaveTip = chainActive.Tip() != nullptr;
+            if (!fHaveTip && pcoinsTip->GetBestBlock().IsNull() && mapBlockIndex.size() > 1) {
+                pcoinsTip->SetBestBlock(chainparams.GetConsensus().hashGenesisBlock);
+            }
+        }
+        if (!fHaveTip && !LoadChainTip(chainparams)) {
+            strError = _("Error initializing block database");
+            return false;
+        }
+        std::vector<unsigned int> vTxCount(info.base_height);
+        std::vector<CBlockHeader> headers;
+        headers.reserve(SNAPSHOT_HEADERS_BATCH);
+        uint256 hashPrev = chainparams.GetConsensus().hashGenesisBlock;
+        const CBlockIndex* pindexBase = nullptr;
+        for (int nHeight = 1; nHeight <= info.base_height; nHeight++) {
+            CBlockHeader header;
+            file >> header;
+            file >> VARINT(vTxCount[nHeight - 1]);
+            if (header.hashPrevBlock != hashPrev || vTxCount[nHeight - 1] == 0) {
+                strError = strprintf(_("The UTXO snapshot has an invalid header at height %d"), nHeight);
+                return false;
+            }
+            hashPrev = header.GetHash();
+            headers.push_back(header);
+            if (headers.size() == SNAPSHOT_HEADERS_BATCH || nHeight == info.base_height) {
+                CValidationState state;
+                if (!ProcessNewBlockHeaders(headers, state, chainparams, &pindexBase)) {
+                    strError = strprintf(_("The UTXO snapshot has an invalid header: %s"), FormatStateMessage(state));
+                    return false;
+                }
+                headers.clear();
+                if (ShutdownRequested()) return false;
+            }
+        }
+        if (pindexBase == nullptr || pindexBase->GetBlockHash() != info.base_blockhash) {
+            strError = _("The UTXO snapshot headers do not lead to its base block");
+            return false;
+        }
+        if (pindexBase->nChainWork < nMinimumChainWork) {
+            strError = _("The UTXO snapshot's base block has less work than the minimum chain work");
+            return false;
+        }
+
+        // Hash the coins while writing them, in a single pass over the file.
+        // The chainstate's best block stays unset until the final write, and
+        // the flag lets the next startup tell an interrupted load apart.
+        fHaveUTXOSnapshot = true;
+        if (!pblocktree->WriteFlag("utxosnapshot", true) || !pblocktree->Sync()) {
+            strError = _("Failed to write to block index database");
+            return false;
+        }
+        fWriting = true;
+        CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
+        ss << info.base_blockhash;
+        uint64_t coins_count = 0;
+        uint256 txid;
+        std::map<uint32_t, Coin> outputs;
+        std::vector<std::pair<COutPoint, Coin>> coins;
+        coins.reserve(SNAPSHOT_COINS_BATCH);
+        while (ReadSnapshotOutputs(file, txid, outputs)) {
+            ApplyTxOutSetHash(ss, txid, outputs);
+            coins_count += outputs.size();
+            for (auto& output : outputs) {
+                coins.emplace_back(COutPoint(txid, output.first), std::move(output.second));
+            }
+            if (coins.size() >= SNAPSHOT_COINS_BATCH) {
+                if (!pcoinsdbview->WriteSnapshotCoins(coins, info.base_blockhash, false)) {
+                    throw std::runtime_error("failed to write to coin database");
+                }
+                coins.clear();
+                if (ShutdownRequested()) {
+                    AbandonUTXOSnapshot();
+                    return false;
+                }
+            }
+        }
+        file >> info.coins_count;
+        file >> info.txoutset_hash;
+        info.txoutset_hash = ss.GetHash();
+        if (coins_count != assumeutxo.coins_count || info.coins_count != assumeutxo.coins_count || info.txoutset_hash != assumeutxo.hash_serialized) {
+            LogPrintf("%s: expected %u coins with hash %s, got %u with hash %s\n", __func__,
+                assumeutxo.coins_count, assumeutxo.hash_serialized.ToString(), coins_count, info.txoutset_hash.ToString());
+            AbandonUTXOSnapshot();
+            strError = _("The UTXO snapshot does not match its UTXO set hash");
+            return false;
+        }
+
+        // Record the snapshot's history in the block index before making the
+        // chainstate point at its base.
+        {
+            LOCK(cs_main);
+            g_chainstate.MarkSnapshotChain(mapBlockIndex.at(info.base_blockhash), vTxCount, chainparams.GetConsensus());
+            fHavePruned = true;
+            pblocktree->WriteFlag("prunedblockfiles", true);
+            std::vector<const CBlockIndex*> vBlocks(setDirtyBlockIndex.begin(), setDirtyBlockIndex.end());
+            setDirtyBlockIndex.clear();
+            if (!pblocktree->WriteBatchSync({}, nLastBlockFile, vBlocks)) {
+                throw std::runtime_error("failed to write to block index database");
+            }
+        }
+        if (!pcoinsdbview->WriteSnapshotCoins(coins, info.base_blockhash, true)) {
+            throw std::runtime_error("failed to write to coin database");
+        }
+        fWriting = false;
+
+        // The cache still has the genesis block as its best block
+        pcoinsTip->SetBestBlock(info.base_blockhash);
+        if (!LoadChainTip(chainparams)) {
+            strError = _("Error initializing block database");
+            return false;
+        }
+
+        int64_t last = GetTimeMicros();
+        LogPrintf("Loaded UTXO snapshot at height %d (%s): %u coins in %gs\n",
+            info.base_height, info.base_blockhash.ToString(), info.coins_count, (last-start)*MICRO);
+    } catch (const std::exception& e) {
+        if (fWriting) AbandonUTXOSnapshot();
+        strError = strprintf(_("Failed to load UTXO snapshot: %s"), e.what());
+        return false;
+    }
+    return true;
+}
+
 //! Guess how far we are in the verification process at the given block index
 double GuessVerificationProgress(const ChainTxData& data, const CBlockIndex *pindex) {
     if (pindex == nullptr)
@@ -21,6 +21,7 @@
 
 #include <algorithm>
 #include <exception>
+#include <functional>
 #include <map>
 #include <memory>
 #include <set>
@@ -38,10 +39,12 @@ class CCoinsViewDB;
 class CInv;
 class CConnman;
 class CScriptCheck;
+class CSignatureBatch;
 class CBlockPolicyEstimator;
 class CTxMemPool;
 class CValidationState;
 struct ChainTxData;
+struct CacheStats;
 
 struct PrecomputedTransactionData;
 struct LockPoints;
@@ -187,6 +190,19 @@ extern bool fEnableReplacement;
 /** Block hash whose ancestors we will assume to have valid scripts without checking them. */
 extern uint256 hashAssumeValid;
 
+/** Script checks ConnectBlock skipped because of hashAssumeValid since startup. */
+struct AssumeValidStats
+{
+    //! Blocks connected without script checks, and the inputs they spend
+    uint64_t blocks = 0;
+    uint64_t inputs = 0;
+    //! Height of the last such block, or -1 if there was none
+    int last_height = -1;
+};
+
+/** Return the script checks skipped so far. Requires cs_main. */
+AssumeValidStats GetAssumeValidStats();
+
 /** Minimum work we will assume exists on some valid chain. */
 extern arith_uint256 nMinimumChainWork;
 
@@ -199,6 +215,8 @@ static const uint64_t nMinDiskSpace = 52428800;
 /** Pruning-related variables and constants */
 /** True if any block files have ever been pruned. */
 extern bool fHavePruned;
+/** True if the chainstate was loaded from a UTXO snapshot, with no block data below its base. */
+extern bool fHaveUTXOSnapshot;
 /** True if we're running in -prune mode. */
 extern bool fPruneMode;
 /** Number of MiB of block files that we're trying to stay below. */
@@ -210,6 +228,8 @@ static const unsigned int NODE_NETWORK_LIMITED_MIN_BLOCKS = 288;
 
 static const signed int DEFAULT_CHECKBLOCKS = 6 * 4;
 static const unsigned int DEFAULT_CHECKLEVEL = 3;
+/** Default for -checkblockpow, re-verifying the KawPoW of every stored header after startup */
+static const bool DEFAULT_CHECKBLOCKPOW = false;
 
 // Require that user allocate at least 550MB for block & undo files (blk???.dat and rev???.dat)
 // At 1MB per block, 288 blocks = 288MB.
@@ -274,6 +294,35 @@ bool LoadChainTip(const CChainParams& chainparams);
 void UnloadBlockIndex();
 /** Run an instance of the script checking thread */
 void ThreadScriptCheck();
+/**
+ * Validation work other than script checks that is spread over the check
+ * threads: header PoW checks, CheckBlock's transaction checks and the
+ * coin database's batched reads. They share one queue, so that -par
+ * bounds the thread count.
+ */
+class CCheckTask
+{
+private:
+    std::function<bool()> fn;
+
+public:
+    CCheckTask() {}
+    explicit CCheckTask(std::function<bool()> fnIn) : fn(std::move(fnIn)) {}
+
+    bool operator()() { return fn(); }
+
+    void swap(CCheckTask& task) { fn.swap(task.fn); }
+};
+/** Run tasks on the check threads, or the calling thread without any, and wait for them. Returns whether all of them succeeded. */
+bool RunCheckTasks(std::vector<CCheckTask>& vTasks);
+/** Run an instance of the thread running CCheckTasks */
+void ThreadTaskCheck();
+/**
+ * Recompute the KawPoW mix of every header in the block index on all cores,
+ * recording the hash of entries that predate BLOCK_POW_VERIFIED. Aborts the
+ * node if a stored header fails.
+ */
+void ThreadCheckBlockIndexPoW();
 /** Check whether we are doing an initial block download (synchronizing from disk or network) */
 bool IsInitialBlockDownload();
 /** Retrieve a transaction (from memory pool, or from disk, if possible) */
@@ -376,7 +425,11 @@ public:
     CScriptCheck(const CTxOut& outIn, const CTransaction& txToIn, unsigned int nInIn, unsigned int nFlagsIn, bool cacheIn, PrecomputedTransactionData* txdataIn) :
         m_tx_out(outIn), ptxTo(&txToIn), nIn(nInIn), nFlags(nFlagsIn), cacheStore(cacheIn), error(SCRIPT_ERR_UNKNOWN_ERROR), txdata(txdataIn) { }
 
-    bool operator()();
+    /**
+     * Run the check. If batch is given, signatures may be deferred to it
+     * instead, see CachingTransactionSignatureChecker.
+     */
+    bool operator()(CSignatureBatch* batch = nullptr);
 
     void swap(CScriptCheck &check) {
         std::swap(ptxTo, check.ptxTo);
@@ -391,8 +444,16 @@ public:
     ScriptError GetScriptError() const { return error; }
 };
 
+/** Script checks run from a CCheckQueue verify their signatures in batches, see checkqueue.h */
+template <typename T>
+bool RunChecks(std::vector<T>& vChecks);
+template <>
+bool RunChecks(std::vector<CScriptCheck>& vChecks);
+
 /** Initializes the script-execution cache */
 void InitScriptExecutionCache();
+/** Lookup and eviction counts of the script-execution cache */
+CacheStats GetScriptExecutionCacheStats();
 
 
 /** Functions for disk access for blocks */
@@ -485,4 +546,25 @@ bool DumpMempool();
 /** Load the mempool from disk. */
 bool LoadMempool();
 
+/** Where a UTXO snapshot was taken, and the UTXO set it holds. */
+struct UTXOSnapshotInfo {
+    uint256 base_blockhash;
+    int base_height = 0;
+    uint64_t coins_count = 0;
+    //! gettxoutsetinfo's hash_serialized_2 of the UTXO set at base_blockhash
+    uint256 txoutset_hash;
+};
+
+/** Write the UTXO set at the chain tip, with the headers leading to it, to a snapshot file. */
+bool DumpUTXOSnapshot(const fs::path& path, UTXOSnapshotInfo& info);
+
+/**
+ * Fill the empty chainstate from a snapshot written by DumpUTXOSnapshot.
+ * Only snapshots listed in the chain parameters are accepted: the headers
+ * are validated and the UTXO set must match the listed hash and coin count.
+ * The blocks below the base are never validated and are treated like pruned
+ * blocks. Coins written by a load that fails are erased again.
+ */
+bool LoadUTXOSnapshot(const CChainParams& chainparams, const fs::path& path, std::string& strError);
+
 #endif // BITCOIN_VALIDATION_H
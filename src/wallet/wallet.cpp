@@ -3194,6 +3194,8 @@ bool CWallet::TopUpKeyPool(unsigned int kpSize)
         }
         bool internal = false;
         CWalletDB walletdb(*dbw);
+        std::vector<CPubKey> vNewKeys;
+        std::vector<int64_t> vNewIndexes;
         for (int64_t i = missingInternal + missingExternal; i--;) {
             if (i < missingInternal) {
                 internal = true;
@@ -3212,7 +3214,13 @@ bool CWallet::TopUpKeyPool(unsigned int kpSize)
             } else {
                 setExternalKeyPool.insert(index);
             }
-            m_pool_key_to_index[pubkey.GetID()] = index;
+            vNewKeys.push_back(pubkey);
+            vNewIndexes.push_back(index);
+        }
+        // Hash the new keys together rather than one at a time
+        const std::vector<CKeyID> vNewIDs = CPubKey::GetIDs(vNewKeys);
+        for (size_t i = 0; i < vNewIDs.size(); ++i) {
+            m_pool_key_to_index[vNewIDs[i]] = vNewIndexes[i];
         }
         if (missingInternal + missingExternal > 0) {
             LogPrintf("keypool added %d keys (%d internal), size=%u (%u internal)\n", missingInternal + missingExternal, missingInternal, setInternalKeyPool.size() + setExternalKeyPool.size(), setInternalKeyPool.size());
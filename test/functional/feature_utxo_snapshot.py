@@ -0,0 +1,84 @@
+#!/usr/bin/env python3
+# Copyright (c) 2024 The NoteCoin developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test dumptxoutset and starting a node from the snapshot with -loadutxosnapshot.
+
+- Node 0 mines a chain and writes a UTXO snapshot of its tip.
+- Node 1 starts with an empty datadir from the snapshot. Verify it is at the
+  snapshot's tip with the same UTXO set, has no blocks below it, and syncs
+  the blocks mined after it.
+- Node 2 refuses a snapshot that is not listed with -assumeutxo, and one that
+  does not match the listed UTXO set hash, then starts without a snapshot.
+"""
+import os
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import (
+    assert_equal,
+    assert_raises_rpc_error,
+    connect_nodes,
+    sync_blocks,
+)
+
+class UTXOSnapshotTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.setup_clean_chain = True
+        self.num_nodes = 3
+
+    def setup_network(self):
+        # Nodes 1 and 2 start later, from the snapshot.
+        self.add_nodes(self.num_nodes)
+        self.start_node(0)
+
+    def run_test(self):
+        node0 = self.nodes[0]
+        node0.generate(150)
+
+        self.log.info("Dump the UTXO set of node 0")
+        snapshot = node0.dumptxoutset("utxo.dat")
+        txoutset = node0.gettxoutsetinfo()
+        assert_equal(snapshot['path'], os.path.join(node0.datadir, "regtest", "utxo.dat"))
+        assert_equal(snapshot['base_hash'], node0.getbestblockhash())
+        assert_equal(snapshot['base_height'], 150)
+        assert_equal(snapshot['coins_written'], txoutset['txouts'])
+        assert_equal(snapshot['hash_serialized_2'], txoutset['hash_serialized_2'])
+        assert_raises_rpc_error(-8, "already exists", node0.dumptxoutset, "utxo.dat")
+
+        self.log.info("Start node 1 from the snapshot")
+        assumeutxo = "-assumeutxo=%s:%d:%s:%d" % (snapshot['base_hash'], snapshot['base_height'], snapshot['hash_serialized_2'], snapshot['coins_written'])
+        snapshot_args = ["-loadutxosnapshot=" + snapshot['path'], assumeutxo]
+        self.start_node(1, extra_args=snapshot_args)
+        node1 = self.nodes[1]
+        assert_equal(node1.getbestblockhash(), snapshot['base_hash'])
+        assert_equal(node1.gettxoutsetinfo()['hash_serialized_2'], snapshot['hash_serialized_2'])
+        assert_raises_rpc_error(-1, "Block not available (pruned data)", node1.getblock, node0.getblockhash(100))
+        assert_equal(node1.getchaintxstats()['txcount'], node0.getchaintxstats()['txcount'])
+
+        self.log.info("Sync the blocks mined after the snapshot")
+        node0.generate(10)
+        # Node 1 does not serve old blocks, so only it connects out.
+        connect_nodes(node1, 0)
+        sync_blocks(self.nodes[0:2])
+        assert_equal(node1.getblockcount(), 160)
+        assert_equal(node1.gettxoutsetinfo()['hash_serialized_2'], node0.gettxoutsetinfo()['hash_serialized_2'])
+
+        self.log.info("Restart node 1 with and without the snapshot")
+        self.restart_node(1)
+        assert_equal(node1.getblockcount(), 160)
+        self.restart_node(1, extra_args=snapshot_args)
+        assert_equal(self.nodes[1].getblockcount(), 160)
+
+        self.log.info("Refuse a snapshot that is not listed")
+        self.assert_start_raises_init_error(2, ["-loadutxosnapshot=" + snapshot['path']], "is not one this software accepts")
+
+        self.log.info("Refuse a snapshot that does not match the listed hash")
+        wrong_hash = "-assumeutxo=%s:%d:%s:%d" % (snapshot['base_hash'], snapshot['base_height'], "11" * 32, snapshot['coins_written'])
+        self.assert_start_raises_init_error(2, ["-loadutxosnapshot=" + snapshot['path'], wrong_hash], "The UTXO snapshot does not match its UTXO set hash")
+
+        self.log.info("Start node 2 without the snapshot it failed to load")
+        self.start_node(2)
+        assert_equal(self.nodes[2].getblockcount(), 0)
+
+if __name__ == '__main__':
+    UTXOSnapshotTest().main()
@@ -12,6 +12,7 @@ Test the following RPCs:
     - getblockhash
     - getblockheader
     - getchaintxstats
+    - dumpassumevalid
     - getnetworkhashps
     - verifychain
 
@@ -41,6 +42,7 @@ class BlockchainTest(BitcoinTestFramework):
     def run_test(self):
         self._test_getblockchaininfo()
         self._test_getchaintxstats()
+        self._test_dumpassumevalid()
         self._test_gettxoutsetinfo()
         self._test_getblockheader()
         self._test_getdifficulty()
@@ -129,6 +131,24 @@ class BlockchainTest(BitcoinTestFramework):
 
         assert_raises_rpc_error(-8, "Invalid block count: should be between 0 and the block's height - 1", self.nodes[0].getchaintxstats, 201)
 
+    def _test_dumpassumevalid(self):
+        node = self.nodes[0]
+        res = node.dumpassumevalid(0)
+        assert_equal(res['height'], 200)
+        assert_equal(res['defaultassumevalid'], node.getbestblockhash())
+
+        res = node.dumpassumevalid(10)
+        header = node.getblockheader(node.getblockhash(190))
+        assert_equal(res['network'], 'regtest')
+        assert_equal(res['height'], 190)
+        assert_equal(res['defaultassumevalid'], header['hash'])
+        assert_equal(res['minimumchainwork'], header['chainwork'])
+        assert_equal(res['chaintxdata']['time'], header['time'])
+        assert_equal(res['chaintxdata']['txcount'], 191)
+
+        assert_raises_rpc_error(-8, "Invalid depth: should be between 0 and the chain height", node.dumpassumevalid, 201)
+        assert_raises_rpc_error(-8, "Invalid depth: should be between 0 and the chain height", node.dumpassumevalid, -1)
+
     def _test_gettxoutsetinfo(self):
         node = self.nodes[0]
         res = node.gettxoutsetinfo()